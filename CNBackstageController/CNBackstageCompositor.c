@@ -0,0 +1,532 @@
+//
+//  CNBackstageCompositor.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CNBackstageCompositor.h"
+#include "CNBackstageImageEncoder.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+static const double kCNCompositorShadowBlurRadius   = 11.0;     // same values as the NSShadow of CNBackstageShadowView
+static const double kCNCompositorShadowOffset       = 3.0;
+static const uint8_t kCNCompositorBrightLineAlpha   = 64;       // white with alpha 0.25
+
+typedef enum {
+    CNCompositorSideTop     = 1 << 0,
+    CNCompositorSideBottom  = 1 << 1,
+    CNCompositorSideLeft    = 1 << 2,
+    CNCompositorSideRight   = 1 << 3
+} CNCompositorSide;
+
+typedef struct {
+    int x, y, width, height;                            // pixel rect, rows top down
+} CNPixelRect;
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Row Kernels
+
+static inline uint8_t CNDiv255(unsigned int value)
+{
+    value += 128;
+    return (uint8_t)((value + (value >> 8)) >> 8);
+}
+
+#if defined(__SSE2__)
+static inline __m128i CNDiv255Epu16(__m128i value)
+{
+    value = _mm_add_epi16(value, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8);
+}
+
+static inline __m128i CNBlendPixelsEpu16(__m128i dst, __m128i src, __m128i alpha)
+{
+    __m128i scaledSrc = CNDiv255Epu16(_mm_mullo_epi16(src, alpha));
+    __m128i srcAlpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(scaledSrc, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i inverseAlpha = _mm_sub_epi16(_mm_set1_epi16(255), srcAlpha);
+    return _mm_add_epi16(scaledSrc, CNDiv255Epu16(_mm_mullo_epi16(dst, inverseAlpha)));
+}
+#endif
+
+void CNCompositorBlendRow(uint8_t *dst, const uint8_t *src, int count, uint8_t alpha)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i globalAlpha = _mm_set1_epi16(alpha);
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i * 4));
+        __m128i low = CNBlendPixelsEpu16(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero), globalAlpha);
+        __m128i high = CNBlendPixelsEpu16(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero), globalAlpha);
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < count; i++) {
+        const uint8_t *s = src + i * 4;
+        uint8_t *d = dst + i * 4;
+        uint8_t scaledAlpha = CNDiv255(s[3] * alpha);
+        unsigned int inverseAlpha = 255 - scaledAlpha;
+        for (int c = 0; c < 3; c++) {
+            d[c] = (uint8_t)(CNDiv255(s[c] * alpha) + CNDiv255(d[c] * inverseAlpha));
+        }
+        d[3] = (uint8_t)(scaledAlpha + CNDiv255(d[3] * inverseAlpha));
+    }
+}
+
+void CNCompositorDarkenRow(uint8_t *dst, int count, uint8_t alpha)
+{
+    unsigned int inverseAlpha = 255 - alpha;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    /// the alpha channel keeps its value, a black overlay on an opaque cover stays opaque
+    const __m128i factor = _mm_set_epi16(255, (short)inverseAlpha, (short)inverseAlpha, (short)inverseAlpha,
+                                         255, (short)inverseAlpha, (short)inverseAlpha, (short)inverseAlpha);
+    for (; i + 4 <= count; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i * 4));
+        __m128i low = CNDiv255Epu16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), factor));
+        __m128i high = CNDiv255Epu16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), factor));
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < count; i++) {
+        uint8_t *d = dst + i * 4;
+        d[0] = CNDiv255(d[0] * inverseAlpha);
+        d[1] = CNDiv255(d[1] * inverseAlpha);
+        d[2] = CNDiv255(d[2] * inverseAlpha);
+    }
+}
+
+static void CNCompositorBrightenRow(uint8_t *dst, int count, uint8_t alpha)
+{
+    unsigned int inverseAlpha = 255 - alpha;
+    for (int i = 0; i < count; i++) {
+        uint8_t *d = dst + i * 4;
+        d[0] = (uint8_t)(alpha + CNDiv255(d[0] * inverseAlpha));
+        d[1] = (uint8_t)(alpha + CNDiv255(d[1] * inverseAlpha));
+        d[2] = (uint8_t)(alpha + CNDiv255(d[2] * inverseAlpha));
+        d[3] = (uint8_t)(alpha + CNDiv255(d[3] * inverseAlpha));
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Pixel Buffer
+
+bool CNPixelBufferAlloc(CNPixelBuffer *buffer, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return false;
+
+    buffer->width = width;
+    buffer->height = height;
+    buffer->bytesPerRow = (size_t)width * 4;
+    buffer->data = calloc((size_t)height, buffer->bytesPerRow);
+    return (buffer->data != NULL);
+}
+
+void CNPixelBufferFree(CNPixelBuffer *buffer)
+{
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->width = buffer->height = 0;
+    buffer->bytesPerRow = 0;
+}
+
+static inline uint8_t *CNPixelBufferRow(const CNPixelBuffer *buffer, int row)
+{
+    return buffer->data + (size_t)row * buffer->bytesPerRow;
+}
+
+static CNPixelRect CNPixelRectFromLayoutRect(CNLayoutRect rect, int windowHeight)
+{
+    CNPixelRect pixelRect;
+    pixelRect.x = (int)floor(rect.x + 0.5);
+    pixelRect.width = (int)floor(rect.width + 0.5);
+    pixelRect.height = (int)floor(rect.height + 0.5);
+    pixelRect.y = windowHeight - (int)floor(rect.y + 0.5) - pixelRect.height;
+    return pixelRect;
+}
+
+static CNPixelRect CNPixelRectIntersection(CNPixelRect a, CNPixelRect b)
+{
+    int minX = (a.x > b.x ? a.x : b.x);
+    int minY = (a.y > b.y ? a.y : b.y);
+    int maxX = (a.x + a.width < b.x + b.width ? a.x + a.width : b.x + b.width);
+    int maxY = (a.y + a.height < b.y + b.height ? a.y + a.height : b.y + b.height);
+    CNPixelRect result = { minX, minY, (maxX > minX ? maxX - minX : 0), (maxY > minY ? maxY - minY : 0) };
+    return result;
+}
+
+/// copies `source` (a sub rect of `image`) to `destination` of `output`, both rects have the same size
+static void CNCompositorBlit(const CNPixelBuffer *image, CNPixelRect source, CNPixelBuffer *output, CNPixelRect destination, uint8_t alpha, bool isOpaqueCopy)
+{
+    CNPixelRect bounds = { 0, 0, output->width, output->height };
+    CNPixelRect visible = CNPixelRectIntersection(destination, bounds);
+    int offsetX = visible.x - destination.x + source.x;
+    int offsetY = visible.y - destination.y + source.y;
+
+    /// clip against the source image as well
+    if (offsetX < 0) { visible.x -= offsetX; visible.width += offsetX; offsetX = 0; }
+    if (offsetY < 0) { visible.y -= offsetY; visible.height += offsetY; offsetY = 0; }
+    if (offsetX + visible.width > image->width) visible.width = image->width - offsetX;
+    if (offsetY + visible.height > image->height) visible.height = image->height - offsetY;
+    if (visible.width <= 0 || visible.height <= 0)
+        return;
+
+    for (int row = 0; row < visible.height; row++) {
+        const uint8_t *src = CNPixelBufferRow(image, offsetY + row) + offsetX * 4;
+        uint8_t *dst = CNPixelBufferRow(output, visible.y + row) + visible.x * 4;
+        if (isOpaqueCopy && alpha == 255) {
+            memcpy(dst, src, (size_t)visible.width * 4);
+        } else {
+            CNCompositorBlendRow(dst, src, visible.width, alpha);
+        }
+    }
+}
+
+static void CNCompositorFillRect(CNPixelBuffer *output, CNPixelRect rect, const uint8_t color[4])
+{
+    CNPixelRect bounds = { 0, 0, output->width, output->height };
+    rect = CNPixelRectIntersection(rect, bounds);
+    for (int row = 0; row < rect.height; row++) {
+        uint8_t *dst = CNPixelBufferRow(output, rect.y + row) + rect.x * 4;
+        for (int column = 0; column < rect.width; column++) {
+            memcpy(dst + column * 4, color, 4);
+        }
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Effects
+
+static void CNCompositorBoxBlurLine(uint8_t *line, size_t step, int count, int radius, uint8_t *scratch)
+{
+    /// running sum box blur with clamped edges, `scratch` holds a copy of the line
+    for (int i = 0; i < count; i++) {
+        memcpy(scratch + i * 4, line + i * step, 4);
+    }
+
+    unsigned int window = (unsigned int)(2 * radius + 1);
+    unsigned int sum[4] = { 0, 0, 0, 0 };
+    for (int i = -radius; i <= radius; i++) {
+        int index = (i < 0 ? 0 : (i >= count ? count - 1 : i));
+        for (int c = 0; c < 4; c++) sum[c] += scratch[index * 4 + c];
+    }
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < 4; c++) {
+            line[i * step + c] = (uint8_t)((sum[c] + window / 2) / window);
+        }
+        int outgoing = i - radius;
+        int incoming = i + radius + 1;
+        outgoing = (outgoing < 0 ? 0 : outgoing);
+        incoming = (incoming >= count ? count - 1 : incoming);
+        for (int c = 0; c < 4; c++) sum[c] += scratch[incoming * 4 + c] - scratch[outgoing * 4 + c];
+    }
+}
+
+static void CNCompositorBlurRect(CNPixelBuffer *output, CNPixelRect rect, double radius)
+{
+    CNPixelRect bounds = { 0, 0, output->width, output->height };
+    rect = CNPixelRectIntersection(rect, bounds);
+    if (radius <= 0 || rect.width <= 0 || rect.height <= 0)
+        return;
+
+    /// three box passes approximate a gaussian with sigma == radius
+    int boxRadius = (int)floor((sqrt(4.0 * radius * radius + 1.0) - 1.0) / 2.0 + 0.5);
+    if (boxRadius < 1)
+        return;
+
+    int maxCount = (rect.width > rect.height ? rect.width : rect.height);
+    uint8_t *scratch = malloc((size_t)maxCount * 4);
+    if (scratch == NULL)
+        return;
+
+    for (int pass = 0; pass < 3; pass++) {
+        for (int row = 0; row < rect.height; row++) {
+            CNCompositorBoxBlurLine(CNPixelBufferRow(output, rect.y + row) + rect.x * 4, 4, rect.width, boxRadius, scratch);
+        }
+        for (int column = 0; column < rect.width; column++) {
+            CNCompositorBoxBlurLine(CNPixelBufferRow(output, rect.y) + (rect.x + column) * 4, output->bytesPerRow, rect.height, boxRadius, scratch);
+        }
+    }
+    free(scratch);
+}
+
+static void CNCompositorDarkenRect(CNPixelBuffer *output, CNPixelRect rect, uint8_t alpha)
+{
+    CNPixelRect bounds = { 0, 0, output->width, output->height };
+    rect = CNPixelRectIntersection(rect, bounds);
+    if (alpha == 0)
+        return;
+    for (int row = 0; row < rect.height; row++) {
+        CNCompositorDarkenRow(CNPixelBufferRow(output, rect.y + row) + rect.x * 4, rect.width, alpha);
+    }
+}
+
+/// inner shadow coverage at `distance` pixels from the shadowed side of the application view
+static double CNCompositorShadowCoverage(double distance)
+{
+    double sigma = kCNCompositorShadowBlurRadius / 2.0;
+    return 0.5 * erfc((distance + 0.5 - kCNCompositorShadowOffset) / (sigma * sqrt(2.0)));
+}
+
+static void CNCompositorDrawShadows(CNPixelBuffer *output, CNPixelRect applicationRect, unsigned int sides, double shadowAlpha)
+{
+    CNPixelRect bounds = { 0, 0, output->width, output->height };
+    CNPixelRect visible = CNPixelRectIntersection(applicationRect, bounds);
+    int reach = (int)ceil(kCNCompositorShadowOffset + 3 * kCNCompositorShadowBlurRadius / 2.0);
+
+    uint8_t profile[64];
+    for (int i = 0; i < reach && i < 64; i++) {
+        profile[i] = (uint8_t)floor(CNCompositorShadowCoverage(i) * shadowAlpha * 255.0 + 0.5);
+    }
+
+    for (int row = visible.y; row < visible.y + visible.height; row++) {
+        uint8_t *line = CNPixelBufferRow(output, row);
+        int fromTop = row - applicationRect.y;
+        int fromBottom = applicationRect.y + applicationRect.height - 1 - row;
+
+        uint8_t rowAlpha = 0;
+        if ((sides & CNCompositorSideTop) && fromTop < reach) rowAlpha = profile[fromTop];
+        if ((sides & CNCompositorSideBottom) && fromBottom < reach && profile[fromBottom] > rowAlpha) rowAlpha = profile[fromBottom];
+        if (rowAlpha > 0) {
+            CNCompositorDarkenRow(line + visible.x * 4, visible.width, rowAlpha);
+        }
+
+        /// only the bands next to the left and right side are touched
+        for (int band = 0; band < 2; band++) {
+            unsigned int side = (band == 0 ? CNCompositorSideLeft : CNCompositorSideRight);
+            if (!(sides & side))
+                continue;
+
+            int from = (band == 0 ? applicationRect.x : applicationRect.x + applicationRect.width - reach);
+            int to = from + reach;
+            from = (from < visible.x ? visible.x : from);
+            to = (to > visible.x + visible.width ? visible.x + visible.width : to);
+            for (int column = from; column < to; column++) {
+                int distance = (band == 0 ? column - applicationRect.x : applicationRect.x + applicationRect.width - 1 - column);
+                CNCompositorDarkenRow(line + column * 4, 1, profile[distance]);
+            }
+        }
+    }
+}
+
+static void CNCompositorDrawBrightLines(CNPixelBuffer *output, CNPixelRect applicationRect, unsigned int sides)
+{
+    CNPixelRect bounds = { 0, 0, output->width, output->height };
+    CNPixelRect lines[4];
+    int lineCount = 0;
+    if (sides & CNCompositorSideTop)    lines[lineCount++] = (CNPixelRect){ applicationRect.x, applicationRect.y, applicationRect.width, 1 };
+    if (sides & CNCompositorSideBottom) lines[lineCount++] = (CNPixelRect){ applicationRect.x, applicationRect.y + applicationRect.height - 1, applicationRect.width, 1 };
+    if (sides & CNCompositorSideLeft)   lines[lineCount++] = (CNPixelRect){ applicationRect.x, applicationRect.y, 1, applicationRect.height };
+    if (sides & CNCompositorSideRight)  lines[lineCount++] = (CNPixelRect){ applicationRect.x + applicationRect.width - 1, applicationRect.y, 1, applicationRect.height };
+
+    for (int i = 0; i < lineCount; i++) {
+        CNPixelRect line = CNPixelRectIntersection(lines[i], bounds);
+        for (int row = line.y; row < line.y + line.height; row++) {
+            CNCompositorBrightenRow(CNPixelBufferRow(output, row) + line.x * 4, line.width, kCNCompositorBrightLineAlpha);
+        }
+    }
+}
+
+/// the sides CNBackstageShadowView draws its shadows and its bright lines on
+static void CNCompositorShadowSides(CNLayoutEdge edge, unsigned int *shadowSides, unsigned int *lineSides)
+{
+    switch (edge) {
+        case CNLayoutEdgeTop:               *shadowSides = CNCompositorSideTop;                         *lineSides = CNCompositorSideBottom; break;
+        case CNLayoutEdgeBottom:            *shadowSides = CNCompositorSideTop;                         *lineSides = CNCompositorSideTop; break;
+        case CNLayoutEdgeLeft:              *shadowSides = CNCompositorSideTop | CNCompositorSideRight; *lineSides = CNCompositorSideRight; break;
+        case CNLayoutEdgeRight:             *shadowSides = CNCompositorSideTop | CNCompositorSideLeft;  *lineSides = CNCompositorSideLeft; break;
+        case CNLayoutEdgeSplitHorizontal:   *shadowSides = CNCompositorSideLeft | CNCompositorSideRight; *lineSides = CNCompositorSideLeft | CNCompositorSideRight; break;
+        case CNLayoutEdgeSplitVertical:     *shadowSides = CNCompositorSideTop;                         *lineSides = CNCompositorSideTop | CNCompositorSideBottom; break;
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Rendering
+
+void CNCompositorDefaultParameters(CNCompositorParameters *parameters)
+{
+    parameters->edge = CNLayoutEdgeTop;
+    parameters->animation = CNLayoutAnimationStatic;
+    parameters->visualEffects = CNCompositorEffectOverlayBlack;
+    parameters->thickness = 0;
+    parameters->duration = 0.42;
+    parameters->overlayAlpha = 0.75;
+    parameters->blurRadius = 2.0;
+    parameters->shouldUseShadows = true;
+    parameters->shadowAlpha = 0.55;
+    parameters->backgroundColor[0] = parameters->backgroundColor[1] = parameters->backgroundColor[2] = 85;     // [NSColor darkGrayColor]
+    parameters->backgroundColor[3] = 255;
+}
+
+/// source rect of a cover inside the snapshot, CGImageCreateWithImageInRect in CNBackstageController does the same cut
+static CNPixelRect CNCompositorCoverSource(CNLayoutEdge edge, int width, int height, bool isSecondCover)
+{
+    switch (edge) {
+        case CNLayoutEdgeSplitHorizontal:
+            return (CNPixelRect){ (isSecondCover ? width / 2 : 0), 0, width / 2, height };
+        case CNLayoutEdgeSplitVertical:
+            return (CNPixelRect){ 0, (isSecondCover ? height / 2 : 0), width, height / 2 };
+        default:
+            return (CNPixelRect){ 0, 0, width, height };
+    }
+}
+
+bool CNCompositorRenderFrame(const CNCompositorParameters *parameters, const CNCompositorFrame *frame,
+                             const CNPixelBuffer *snapshot, const CNPixelBuffer *applicationImage, CNPixelBuffer *output)
+{
+    if (parameters == NULL || frame == NULL || snapshot == NULL || output == NULL || snapshot->data == NULL || output->data == NULL)
+        return false;
+    if (snapshot->width != output->width || snapshot->height != output->height)
+        return false;
+
+    double windowWidth = output->width;
+    double windowHeight = output->height;
+    double progress = (parameters->duration > 0 ? CNLayoutEaseInEaseOut(frame->time / parameters->duration) : 1);
+
+    /// animated state of the frames and effects, dependent on the phase
+    CNLayoutFrames frames, collapsedFrames, expandedFrames;
+    double overlayAlpha = parameters->overlayAlpha;
+    double blurRadius = parameters->blurRadius;
+    double applicationAlpha = 1;
+
+    switch (frame->phase) {
+        case CNCompositorPhaseExpand:
+            CNLayoutCollapsedFrames(parameters->edge, parameters->animation, windowWidth, windowHeight, parameters->thickness, &collapsedFrames);
+            CNLayoutExpandedFrames(parameters->edge, parameters->animation, windowWidth, windowHeight, parameters->thickness, &expandedFrames);
+            CNLayoutInterpolateFrames(&collapsedFrames, &expandedFrames, progress, &frames);
+            overlayAlpha *= progress;
+            applicationAlpha = (parameters->animation == CNLayoutAnimationFade ? progress : 1);
+            break;
+
+        case CNCompositorPhaseCollapse:
+            CNLayoutCollapsedFrames(parameters->edge, parameters->animation, windowWidth, windowHeight, parameters->thickness, &collapsedFrames);
+            CNLayoutExpandedFrames(parameters->edge, parameters->animation, windowWidth, windowHeight, parameters->thickness, &expandedFrames);
+            CNLayoutInterpolateFrames(&expandedFrames, &collapsedFrames, progress, &frames);
+            overlayAlpha *= (1 - progress);
+            blurRadius = 0;                                 // the controller drops the blur radius at the start of a collapse
+            applicationAlpha = (parameters->animation == CNLayoutAnimationFade ? 1 - progress : 1);
+            break;
+
+        case CNCompositorPhaseDrag: {
+            double thickness = parameters->thickness + frame->dragOffset;
+            CNLayoutExpandedFrames(parameters->edge, parameters->animation, windowWidth, windowHeight, (thickness > 0 ? thickness : 0), &frames);
+            break;
+        }
+
+        default:
+            return false;
+    }
+
+    /// window background
+    CNPixelRect windowRect = { 0, 0, output->width, output->height };
+    CNCompositorFillRect(output, windowRect, parameters->backgroundColor);
+
+    /// application view with its shadow view, it lies below the covers
+    CNPixelRect applicationRect = CNPixelRectFromLayoutRect(frames.applicationFrame, output->height);
+    uint8_t applicationAlphaByte = (uint8_t)floor(applicationAlpha * 255.0 + 0.5);
+    if (applicationImage != NULL && applicationImage->data != NULL && applicationAlphaByte > 0) {
+        CNPixelRect source = { 0, 0, applicationRect.width, applicationRect.height };
+        CNCompositorBlit(applicationImage, source, output, applicationRect, applicationAlphaByte, false);
+    }
+
+    unsigned int shadowSides = 0, lineSides = 0;
+    CNCompositorShadowSides(parameters->edge, &shadowSides, &lineSides);
+    if (parameters->shouldUseShadows) {
+        CNCompositorDrawShadows(output, applicationRect, shadowSides, parameters->shadowAlpha);
+    }
+    CNCompositorDrawBrightLines(output, applicationRect, lineSides);
+
+    /// covers with their blur and overlay
+    uint8_t overlayAlphaByte = (uint8_t)floor(overlayAlpha * 255.0 + 0.5);
+    int coverCount = (frames.hasSecondCover ? 2 : 1);
+    for (int i = 0; i < coverCount; i++) {
+        CNPixelRect coverRect = CNPixelRectFromLayoutRect(i == 0 ? frames.firstCoverFrame : frames.secondCoverFrame, output->height);
+        CNPixelRect source = CNCompositorCoverSource(parameters->edge, snapshot->width, snapshot->height, i == 1);
+        coverRect.width = source.width;
+        coverRect.height = source.height;
+
+        CNCompositorBlit(snapshot, source, output, coverRect, 255, true);
+        if (parameters->visualEffects & CNCompositorEffectGaussianBlur) {
+            CNCompositorBlurRect(output, coverRect, blurRadius);
+        }
+        if (parameters->visualEffects & CNCompositorEffectOverlayBlack) {
+            CNCompositorDarkenRect(output, coverRect, overlayAlphaByte);
+        }
+    }
+    return true;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// PNG Output
+
+bool CNCompositorWritePNG(const CNPixelBuffer *buffer, const char *path)
+{
+    if (buffer == NULL || buffer->data == NULL || path == NULL)
+        return false;
+
+    CNImageEncoderParameters parameters;
+    CNImageEncoderDefaultParameters(&parameters, buffer->width, buffer->height);
+    parameters.isOpaque = false;
+
+    CNImageEncoder *encoder = CNImageEncoderCreate();
+    const uint8_t *data = NULL;
+    size_t length = 0;
+    if (encoder != NULL &&
+        CNImageEncoderBegin(encoder, &parameters) &&
+        CNImageEncoderAppendRows(encoder, buffer->data, buffer->bytesPerRow, buffer->height)) {
+        data = CNImageEncoderFinish(encoder, &length);
+    }
+
+    FILE *file = (data != NULL ? fopen(path, "wb") : NULL);
+    bool success = (file != NULL && fwrite(data, 1, length, file) == length);
+    if (file != NULL && fclose(file) != 0)
+        success = false;
+
+    CNImageEncoderFree(encoder);
+    return success;
+}
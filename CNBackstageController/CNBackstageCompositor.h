@@ -0,0 +1,114 @@
+//
+//  CNBackstageCompositor.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#ifndef CNBackstageCompositor_h
+#define CNBackstageCompositor_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CNBackstageLayout.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A CPU reference compositor for the backstage window. It renders any frame of an expand, collapse or drag from the
+/// same layout (`CNBackstageLayout`) and effect parameters the controller uses: the screen snapshot covers, their
+/// gaussian blur and black overlay, the application view with its fade or slide and the edge shadows of
+/// `CNBackstageShadowView`. It has no dependency on AppKit or the window server, so frames can be rendered headless,
+/// compared against golden images and measured.
+///
+/// Units are pixels. The blur is approximated by three box blur passes and the shadows by an analytic profile of the
+/// `NSShadow` used by `CNBackstageShadowView`, so the result is close to, but not bit identical with, a live session.
+
+typedef struct {
+    uint8_t *data;                                      // RGBA, 8 bit per channel, premultiplied alpha, rows top down
+    int width;
+    int height;
+    size_t bytesPerRow;
+} CNPixelBuffer;
+
+enum {
+    CNCompositorEffectOverlayBlack  = 1 << 0,           // same values as CNToggleVisualEffect
+    CNCompositorEffectGaussianBlur  = 1 << 1
+};
+
+typedef enum {
+    CNCompositorPhaseExpand = 0,
+    CNCompositorPhaseCollapse,
+    CNCompositorPhaseDrag
+} CNCompositorPhase;
+
+typedef struct {
+    CNLayoutEdge edge;
+    CNLayoutAnimation animation;
+    unsigned int visualEffects;                         // combination of CNCompositorEffect values
+    double thickness;                                   // width or height of the application view
+    double duration;                                    // duration of the expand and collapse animation in seconds
+    double overlayAlpha;
+    double blurRadius;
+    bool shouldUseShadows;
+    double shadowAlpha;                                 // 0.55 (normal), 0.35 (lighter) or 0.75 (darker)
+    uint8_t backgroundColor[4];                         // premultiplied RGBA of the window background
+} CNCompositorParameters;
+
+typedef struct {
+    CNCompositorPhase phase;
+    double time;                                        // seconds since the start of an expand or collapse
+    double dragOffset;                                  // change of the thickness while dragging
+} CNCompositorFrame;
+
+
+/// Fills in the defaults of `CNBackstageController`.
+extern void CNCompositorDefaultParameters(CNCompositorParameters *parameters);
+
+/// Creates a buffer with `malloc`, release it with `CNPixelBufferFree`.
+extern bool CNPixelBufferAlloc(CNPixelBuffer *buffer, int width, int height);
+extern void CNPixelBufferFree(CNPixelBuffer *buffer);
+
+/// Renders one frame into `output`, which must have the size of `snapshot`. `applicationImage` may be NULL, then the
+/// application view shows the background color. Its content is drawn unscaled at the origin of the application view.
+extern bool CNCompositorRenderFrame(const CNCompositorParameters *parameters, const CNCompositorFrame *frame,
+                                    const CNPixelBuffer *snapshot, const CNPixelBuffer *applicationImage, CNPixelBuffer *output);
+
+/// Writes the buffer as PNG file, encoded with `CNBackstageImageEncoder`.
+extern bool CNCompositorWritePNG(const CNPixelBuffer *buffer, const char *path);
+
+
+/// Row kernels, SSE2 accelerated where available. Exposed for benchmarking.
+
+/// dst = src * alpha + dst * (1 - src.a * alpha)
+extern void CNCompositorBlendRow(uint8_t *dst, const uint8_t *src, int count, uint8_t alpha);
+
+/// dst = dst * (1 - alpha), a black overlay
+extern void CNCompositorDarkenRow(uint8_t *dst, int count, uint8_t alpha);
+
+#endif
@@ -32,6 +32,7 @@
 #import "NSScreen+CNBackstageController.h"
 #import "CNBackstageDefinitions.h"
 #import "CNBackstageDelegate.h"
+#import "CNBackstageStateStore.h"
 
 
 
@@ -253,7 +254,7 @@
  
  @note These are just constants for four displays. You may of course own more than four displays, and `CNBackstageController` will provide them all!
  */
-@property (assign) CNToggleDisplay toggleDisplay;
+@property (assign, nonatomic) CNToggleDisplay toggleDisplay;
 
 /**
  Specifies the visual effects, while the display is toggling.
@@ -283,7 +284,7 @@
  @warning Using the `CNToggleAnimationEffectGaussianBlur` will decrease the animation performance!
  @see overlayAlpha.
 */
-@property (assign) CNToggleAnimationEffect toggleVisualEffect;
+@property (assign, nonatomic) CNToggleAnimationEffect toggleVisualEffect;
 
 /**
  Specifies the animation effects, while the display is toggling.
@@ -308,7 +309,7 @@
 
  The default value is `CNToggleAnimationEffectStatic`.
  */
-@property (assign) CNToggleAnimationEffect toggleAnimationEffect;
+@property (assign, nonatomic) CNToggleAnimationEffect toggleAnimationEffect;
 
 /**
  Boolean property that indicates whether the user can resize the coverage of the applicationView or not.
@@ -320,6 +321,36 @@
  */
 @property (assign, getter = isResizingAllowed) BOOL resizingAllowed;
 
+/**
+ Boolean property that indicates whether effect free configurations use a lightweight overlay.
+
+ If this property is `YES`, `toggleVisualEffect` is `CNToggleVisualEffectNone`, `toggleEdge` isn't a split edge and no
+ additional panels were added, the controller doesn't capture the screen and doesn't create a full screen window with
+ covers. Instead, the applicationView appears in a window of its own size on the toggle edge and the live desktop stays
+ visible behind it. The cost of an expand then depends on the size of the applicationView, not on the size of the screen,
+ which makes this mode a good default on low end machines.
+
+ The `toggleAnimationEffect` is used as usual, a sliding applicationView is clipped by its window. The presentation
+ options (e.g. a hidden dock) are left untouched and the applicationView can't be resized by dragging. The controller
+ collapses when the application resigns active, e.g. on a click on the desktop.
+
+ The default value is `NO`.
+ */
+@property (assign, nonatomic) BOOL shouldUseLightweightOverlay;
+
+/**
+ The time in seconds the Dock stays hidden after the applicationView has disappeared.
+
+ The Dock is only hidden if it overlaps the applicationView or one of the panels, in their expanded place or on their way
+ in and out. A right edge panel with a Dock at the bottom doesn't touch the presentation options at all. Every change of
+ the presentation options makes the Dock slide and costs system wide work, so with a positive value the options stay
+ applied across rapid toggles and are restored once the applicationView stayed collapsed for that long. Presentation
+ options only apply while the application is active.
+
+ The default value is `0`, the Dock is restored on every collapse.
+ */
+@property (assign, nonatomic) NSTimeInterval dockRestoreDelay;
+
 
 #pragma mark - Managing the Layout
 /** @name Managing the Layout */
@@ -339,7 +370,7 @@
  
  @param overlayAlpha    Any valid value in the range between `0` and `1`.
  */
-@property (assign) CGFloat overlayAlpha;
+@property (assign, nonatomic) CGFloat overlayAlpha;
 
 /**
  Boolean property to control the drawing of shadows on applicationView.
@@ -349,7 +380,7 @@
  @param YES Shadows will be drawn on top of the applicationView.
  @param NO  No shadows will be drawn.
  */
-@property (assign) BOOL shouldUseShadows;
+@property (assign, nonatomic) BOOL shouldUseShadows;
 
 /**
  Specifies the intensity of the aplicationView's shadow drawing.
@@ -371,6 +402,210 @@
 @property (assign) CNShadowIntensity shadowIntensity;
 
 
+#pragma mark - Multiple Panels
+/** @name Multiple Panels */
+
+/**
+ Adds a panel that appears together with the applicationView on another edge of the same display.
+
+ A left tool panel and a bottom log panel, for example, can be open at the same time as the applicationView. All panels
+ share the window, the screen snapshot and the visual effects of the controller. The applicationView pushes the covers
+ aside as usual, the panels lie above them, so the covers stay visible in the remaining region of the screen. Panels on
+ the axis of `toggleEdge` span the whole screen, the panels on the other axis fill the space between them. The panels use
+ the `toggleAnimationEffect` and the shadows of the applicationView, only the applicationView can be resized by dragging.
+
+ There is at most one panel per edge, adding a panel replaces the one on the same edge. Only the edges `CNToggleEdgeTop`,
+ `CNToggleEdgeBottom`, `CNToggleEdgeLeft` and `CNToggleEdgeRight` are supported, a panel on the current `toggleEdge` is
+ ignored. Panels are not shown while `toggleEdge` is a split edge, and a panel whose edge becomes the `toggleEdge` later
+ stays hidden until the applicationView moves to another edge again.
+
+ @param aViewController The view controller whose view is shown as panel.
+ @param aToggleEdge     The edge the panel appears on.
+ @param aToggleSize     The size of the panel, it accepts the same absolute and relative values as `toggleSize`.
+ */
+- (void)addPanelWithViewController:(NSViewController *)aViewController toggleEdge:(CNToggleEdge)aToggleEdge toggleSize:(CNToggleSize)aToggleSize;
+
+/**
+ Removes the panel on the given edge. If the controller is expanded, the panel disappears immediately.
+
+ @param aToggleEdge The edge of the panel to remove.
+ */
+- (void)removePanelOnToggleEdge:(CNToggleEdge)aToggleEdge;
+
+/**
+ Returns the view controller of the panel on the given edge, or `nil` if there is no panel.
+
+ @param aToggleEdge The edge of the panel.
+ */
+- (NSViewController *)panelViewControllerOnToggleEdge:(CNToggleEdge)aToggleEdge;
+
+
+#pragma mark - Live Covers
+/** @name Live Covers */
+
+/**
+ Boolean property that indicates whether the screen snapshot covers are kept up to date while the applicationView is visible.
+
+ Normally the covers show the screen content of the moment the applicationView appeared. With live covers enabled the
+ visible parts of the covers are captured again every `liveCoverRefreshInterval` seconds. The captured region is divided
+ into tiles and only the tiles whose content has changed are uploaded into the cover layers, so a playing video or a
+ scrolling terminal behind the covers costs a few tiles per refresh instead of a full screen capture. The visual effects
+ of `toggleVisualEffect` are applied to the refreshed tiles as well.
+
+ While the applicationView appears, disappears or is resized by dragging, no captures are taken.
+
+ The default value is `NO`.
+ */
+@property (assign, nonatomic) BOOL shouldUseLiveCovers;
+
+/**
+ The time in seconds between two refreshes of the live covers.
+
+ The next capture is started not before the previous one has been applied, so a slow capture lowers the rate instead of
+ piling up. Values below `1/30` second are raised to `1/30` second.
+ The default value is `kCNDefaultLiveCoverRefreshInterval` (0.25 seconds).
+ */
+@property (assign, nonatomic) NSTimeInterval liveCoverRefreshInterval;
+
+
+#pragma mark - Adaptive Quality
+/** @name Adaptive Quality */
+
+/**
+ Boolean property that indicates whether the controller trades effects for smoothness on machines that can't sustain them.
+
+ If this property is `YES`, the frame times of every expand, collapse and drag are measured on the toggle display. When too
+ many frames are missed, the controller steps down one quality level: first the gaussian blur radius is reduced, then the
+ blur is left out, then the shadows, then a slide animation becomes a fade and finally the applicationView appears without
+ animation. When the frames have been smooth for a while, it steps back up again. A step up that turns out to be too expensive
+ makes the next try wait longer, so the level doesn't oscillate. Levels that wouldn't change anything with the current
+ settings are skipped.
+
+ A new level is used from the next expand on and reported by `backstageController:didChangeQuality:onScreen:toggleEdge:`.
+ The configured properties (`toggleVisualEffect`, `toggleAnimationEffect`, `shouldUseShadows`) are never changed.
+ Setting this property starts over with `CNToggleQualityFull`.
+
+ The default value is `NO`.
+ */
+@property (assign, nonatomic) BOOL shouldAdaptQuality;
+
+/**
+ The quality level that is used on the next expand.
+
+ This is always `CNToggleQualityFull` if `shouldAdaptQuality` is `NO`.
+ */
+@property (readonly, nonatomic) CNToggleQuality currentQuality;
+
+
+#pragma mark - Screen Edge Activation
+/** @name Screen Edge Activation */
+
+/**
+ Specifies whether the applicationView appears automatically if the pointer rests on the toggle edge.
+
+    typedef enum {
+        CNToggleActivationManual = 0,
+        CNToggleActivationScreenEdge,
+        CNToggleActivationHotCorner
+    } CNToggleActivation;
+
+ `CNToggleActivationManual`<br />
+ The applicationView only appears by calling `toggleViewState` or `expand`. This is the default value.
+
+ `CNToggleActivationScreenEdge`<br />
+ The applicationView appears if the pointer rests for `toggleActivationDwellTime` seconds on the edge `toggleEdge` of the
+ display `toggleDisplay`.
+
+ `CNToggleActivationHotCorner`<br />
+ Like `CNToggleActivationScreenEdge`, but only the two corners at the ends of `toggleEdge` are sensitive.
+
+ The activation is driven by pointer events only, there is no polling. Once the pointer has been resting on the edge for half
+ of the dwell time the screen snapshot is already taken, so the expand itself gets faster. The split edges `CNToggleEdgeSplitHorizontal` and `CNToggleEdgeSplitVertical`
+ have no screen edge and don't support an automatic activation.
+ */
+@property (assign, nonatomic) CNToggleActivation toggleActivation;
+
+/**
+ The time in seconds the pointer has to rest on the toggle edge before the applicationView appears.
+
+ The default value is `0.3`.
+ */
+@property (assign, nonatomic) NSTimeInterval toggleActivationDwellTime;
+
+/**
+ The pointer speed in points per second above which the pointer is considered to just pass by the toggle edge.
+
+ A faster pointer doesn't arm the activation and restarts a running dwell time. A value of `0` disables the threshold.
+ The default value is `1500`.
+ */
+@property (assign, nonatomic) CGFloat toggleActivationVelocityThreshold;
+
+
+#pragma mark - Persistence
+/** @name Persistence */
+
+/**
+ The store that keeps the configuration and the sizes the user has chosen by dragging across launches.
+
+ Assigning a store loads its record once and applies it: `toggleEdge`, `toggleSize`, `toggleDisplay`, `toggleVisualEffect`,
+ `toggleAnimationEffect`, `overlayAlpha`, `shouldUseShadows` and the last dragged size of the applicationView on each
+ display and edge. So set your defaults first and assign the store afterwards, the stored values win.
+ A stored value out of its range, e.g. a display that isn't connected any more, is skipped and the current value stays.
+
+ From then on every change of these properties and every resize by dragging is written to the store. Changes are coalesced
+ for half a second and written on a background queue, so the main thread never waits for the disk. Pending changes are
+ written when the application terminates.
+
+ A dragged size is used on the next expand on the same display and edge, until `toggleSize` is set again while that
+ display and edge are current.
+
+ The default value is `nil`, nothing is persisted. Use a `CNBackstageUserDefaultsStateStore` to keep the state in the user
+ defaults.
+ */
+@property (strong, nonatomic) id<CNBackstageStateStore> stateStore;
+
+
+#pragma mark - Resource Management
+/** @name Resource Management */
+
+/**
+ The time in seconds the controller may stay collapsed before it releases its backstage resources.
+
+ `CNBackstageController` doesn't create any views until it is expanded for the first time (or `prewarm` is called). After it has been
+ collapsed for `hibernationInterval` seconds it releases the window, the cover views, snapshots, baked effects and its reference
+ to the application view. If the applicationViewController has a `nibName` its view is released as well and loaded again on
+ the next expand, otherwise releasing the view is left to the delegate. The delegate is informed via `backstageController:willHibernateOnScreen:toggleEdge:` and
+ `backstageController:willWakeUpOnScreen:toggleEdge:`, so the applicationViewController can release and rebuild its own content.
+
+ A value of `0` disables the timeout. The default value is `kCNDefaultHibernationInterval` (180 seconds).
+ */
+@property (assign, nonatomic) NSTimeInterval hibernationInterval;
+
+/**
+ Boolean property that indicates whether a collapsed controller releases its backstage resources on a memory pressure signal
+ of the system.
+
+ Memory pressure signals are available on OS X 10.9 and above. The default value is `YES`.
+ */
+@property (assign, nonatomic) BOOL shouldHibernateOnMemoryPressure;
+
+/**
+ The time in seconds the screen snapshot, the window and the visual effects of the last expand are kept after a collapse.
+
+ An expand within this time takes a fingerprint of the screen in nominal resolution and compares it with the fingerprint
+ taken together with the last snapshot. If the screen content hasn't changed, the last snapshot and window are shown
+ again instead of capturing the screen in full resolution and building a new window. This makes flicking the
+ applicationView open and closed several times within a few seconds faster, at the price of keeping the window and a
+ full resolution snapshot in memory for this time.
+
+ The snapshot is only reused on Retina displays, where the nominal resolution capture has a quarter of the pixels of the
+ snapshot. On other displays it would cost as much as the snapshot itself, a changed screen even twice as much, so only
+ the window is kept there. A value of `0` disables the reuse, the window and the snapshot are then released on every
+ collapse. The default value is `kCNDefaultSnapshotReuseInterval` (`0`, the reuse is disabled).
+ */
+@property (assign, nonatomic) NSTimeInterval snapshotReuseInterval;
+
+
 #pragma mark - API
 /** @name API */
 
@@ -403,4 +638,44 @@
  */
 - (CNToggleState)currentViewState;
 
+/**
+ Builds the backstage resources ahead of the first expand.
+
+ Normally all resources are created lazily on the first expand. Call this method if you want to move that work to a point
+ in time of your choice, e.g. shortly after launch when the application is idle. Besides loading the view of the
+ applicationViewController this builds the window, the cover and shadow views and the layer hierarchy, so the next expand only
+ has to capture the screen. A prewarmed controller will hibernate again after `hibernationInterval` seconds if it isn't expanded.
+ */
+- (void)prewarm;
+
+/**
+ Returns the screen snapshot of the current expand as a read-only snapshot buffer.
+
+ The controller draws its capture once into the buffer and shows the very same pixels in its covers, so neither handing out
+ the buffer nor retaining it copies anything, all callers share that one allocation. Use it instead of capturing the
+ display a second time, e.g. to build your own background effects. The pixels show the screen at the start of the expand,
+ live cover refreshes don't change them. Besides the pixels the buffer describes their stride, pixel format, backing scale
+ and display ID, see `CNBackstageSnapshotBuffer.h`.
+
+ The caller owns the returned buffer and has to release it with `CNSnapshotBufferRelease`. The buffer stays valid after the
+ controller has collapsed, the controller itself lets go of the snapshot on every collapse.
+
+ @return    A retained snapshot buffer, or `NULL` if the controller isn't expanded, uses the lightweight overlay or the
+            display couldn't be captured.
+ */
+- (CNSnapshotBuffer *)copySnapshotBuffer;
+
+/**
+ Returns the screen snapshot of the expand that captured the snapshot `generation` as a read-only snapshot buffer.
+
+ Every captured snapshot gets a new generation, the `CNBackstageControllerDidCaptureSnapshotNotification` sends it using the
+ key `CNSnapshotGenerationUserInfoKey`. Observers that handle the notification later, e.g. on another queue, use this method
+ instead of `copySnapshotBuffer`, so they never get the snapshot of a later expand.
+
+ @param generation  The generation of the snapshot.
+ @return    A retained snapshot buffer, or `NULL` if the snapshot of that generation is gone or `copySnapshotBuffer` would
+            return `NULL`.
+ */
+- (CNSnapshotBuffer *)copySnapshotBufferOfGeneration:(NSUInteger)generation;
+
 @end
@@ -31,6 +31,34 @@
 #import <QuartzCore/QuartzCore.h>
 #import "CNBackstageController.h"
 #import "CNBackstageShadowView.h"
+#import "CNBackstageIdlePolicy.h"
+#import "CNBackstageEdgeActivation.h"
+#import "CNBackstageLayout.h"
+#import "CNBackstageTileDiff.h"
+#import "CNBackstageFingerprint.h"
+#import "CNBackstageQualityGovernor.h"
+#import "CNBackstageDockPolicy.h"
+#import "CNBackstageState.h"
+#import <libkern/OSAtomic.h>
+
+
+static const CGFloat kCNToggleActivationTriggerDistance = 2;
+static const CGFloat kCNToggleActivationReleaseDistance = 24;
+static const CGFloat kCNToggleActivationCornerSize      = 48;
+static const CGFloat kCNToggleActivationPrepareRatio    = 0.5;
+
+static const int kCNLiveCoverTileSize                              = 64;
+static const NSTimeInterval kCNLiveCoverMinimumRefreshInterval    = 1.0 / 30.0;
+static const int kCNFingerprintBlockSize                          = 16;
+static const int kCNFingerprintRowStep                            = 1;
+static const CGFloat kCNGaussianBlurRadius                        = 2;
+static const CGFloat kCNReducedGaussianBlurRadius                 = 1;
+static const NSTimeInterval kCNStateSaveDelay                     = 0.5;
+
+static inline NSRect NSRectFromLayoutRect(CNLayoutRect layoutRect)
+{
+    return NSMakeRect(layoutRect.x, layoutRect.y, layoutRect.width, layoutRect.height);
+}
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -52,11 +80,48 @@
     NSPoint _initialSecondCoverOrigin;
     NSRect _initialApplicationViewFrame;
     CNToggleState _toggleState;
-    BOOL _dockIsHidden;
     BOOL _toggleAnimationIsRunning;
     BOOL _applicationCoverIsDragging;
     CIFilter *_gaussianBlurFilter;
     CNToggleSize _toggleSize;
+    CNIdlePolicy _idlePolicy;
+    NSUInteger _idleTimerGeneration;
+    dispatch_source_t _memoryPressureSource;
+    CNEdgeActivationDetector _activationDetector;
+    id _globalPointerMonitor;
+    id _localPointerMonitor;
+    NSUInteger _activationTimerGeneration;
+    double _activationTimerDeadline;
+    CGImageRef _speculativeSnapshot;
+    dispatch_queue_t _liveCoverQueue;
+    NSUInteger _liveCoverGeneration;
+    CNTileGrid _liveCoverGrids[2];
+    NSArray *_liveCoverTileLayers;
+    NSMutableDictionary *_panelViewControllers;
+    NSMutableDictionary *_panelShadowViews;
+    CNToggleSize _panelToggleSizes[4];
+    CNLayoutPanels _layoutPanels;
+    CNLayoutRect _panelFrames[4];
+    CNLayoutRect _remainingFrame;
+    CGImageRef _reusableSnapshot;
+    CNSnapshotBuffer *_reusableSnapshotBuffer;
+    CNFingerprint _reusableSnapshotFingerprint;
+    NSUInteger _snapshotReuseGeneration;
+    BOOL _lightweightOverlayIsActive;
+    CNQualityGovernor _qualityGovernor;
+    CNQualityLevel _activeQualityLevel;
+    CVDisplayLinkRef _qualityDisplayLink;
+    volatile int32_t _qualityFrameIsPending;
+    dispatch_queue_t _stateQueue;
+    CNStateSaveScheduler _stateSaveScheduler;
+    BOOL _stateIsRestoring;
+    CNDraggedSizes _draggedToggleSizes;
+    CNDockPolicy _dockPolicy;
+    NSUInteger _dockRestoreGeneration;
+    NSMutableDictionary *_dockFrames;
+    CGImageRef _currentSnapshot;
+    CNSnapshotBuffer *_currentSnapshotBuffer;
+    NSUInteger _currentSnapshotGeneration;
 }
 @property (readonly) NSRect currentToggleDisplayFrame;
 
@@ -67,8 +132,11 @@
 - (NSScreen*)screenOfCurrentToggleDisplay;
 - (CNToggleFrameDeltas)toggleDeltasForFrame:(NSRect)aFrame;
 - (void)initializeApplicationWindow;
+- (NSRect)contentRectOfCurrentToggleDisplay;
+- (void)initializeWindowWithContentRect:(NSRect)windowRect;
 - (void)buildLayerHierarchy;
 - (NSRect)frameOfApplicationView;
+- (CGFloat)thicknessOfApplicationViewForFrame:(NSRect)aFrame;
 - (void)createSnapshotOfCurrentToggleDisplay;
 - (void)resignApplicationWindow;
 - (int)thicknessOfSystemStatusBarForCurrentToggleDisplay;
@@ -79,9 +147,97 @@
 - (CGDirectDisplayID)displayIDForCurrentToggleDisplay:(CNToggleDisplay)aToggleDisplay;
 - (NSScreen*)screenForDisplayWithID:(CGDirectDisplayID)displayID;
 - (void)dragCoverageUsingAnchorPoint:(NSPoint)location;
+- (void)prepareCoverViews;
+- (void)discardCoverViews;
+- (void)performIdlePolicyAction:(CNIdlePolicyAction)idlePolicyAction;
+- (void)wakeUpBackstageResources;
+- (void)hibernateBackstageResources;
+- (void)scheduleIdleTimer;
+- (void)observeMemoryPressure;
+- (void)updateToggleActivationMonitors;
+- (void)updateToggleActivationConfiguration;
+- (void)toggleActivationPointerMoved:(NSEvent *)theEvent;
+- (void)performToggleActivationEvent:(CNEdgeActivationEvent)activationEvent;
+- (void)scheduleToggleActivationTimer;
+- (void)captureSpeculativeSnapshot;
+- (void)discardSpeculativeSnapshot;
+- (void)startLiveCoverRefresh;
+- (void)stopLiveCoverRefresh;
+- (void)scheduleLiveCoverRefresh;
+- (void)refreshLiveCovers;
+- (NSArray *)changedTilesOfLiveCoverAtIndex:(NSUInteger)coverIndex captureRect:(CGRect)captureRect visibleRect:(NSRect)visibleRect windowID:(CGWindowID)windowID;
+- (void)applyLiveCoverTiles:(NSArray *)tiles toCoverView:(NSView *)coverView tileLayers:(NSMutableDictionary *)tileLayers;
+- (BOOL)supportsPanels;
+- (CGFloat)thicknessOfPanelOnToggleEdge:(CNToggleEdge)aToggleEdge forFrame:(NSRect)aFrame;
+- (void)updatePanelLayout;
+- (NSRect)frameOfPanelOnToggleEdge:(CNToggleEdge)aToggleEdge expanded:(BOOL)expanded;
+- (void)buildPanelHierarchy;
+- (void)layoutPanelViewsExpanded:(BOOL)expanded animated:(BOOL)animated;
+- (void)removePanelViewOnToggleEdge:(CNToggleEdge)aToggleEdge;
+- (BOOL)isPanelAtPoint:(NSPoint)aPoint;
+- (CGImageRef)snapshotOfCurrentToggleDisplay;
+- (BOOL)canUseLightweightOverlay;
+- (void)expandLightweightOverlayUsingCompletionHandler:(void(^)(void))completionHandler;
+- (void)collapseLightweightOverlayUsingCompletionHandler:(void(^)(void))completionHandler;
+- (CNLayoutFrames)lightweightOverlayFramesExpanded:(BOOL)expanded;
+- (CGRect)fingerprintRectOfDisplayWithID:(CGDirectDisplayID)displayID;
+- (void)scheduleSnapshotReuseTimeout;
+- (void)discardReusableSnapshot;
+- (void)discardReusableArtifacts;
+- (unsigned int)applicableQualityLevels;
+- (CNToggleAnimationEffect)effectiveToggleAnimationEffect;
+- (BOOL)effectiveShadowUsage;
+- (CGFloat)effectiveGaussianBlurRadius;
+- (void)beginQualitySession;
+- (void)endQualitySession;
+- (void)qualityDisplayLinkDidOutputFrame;
+- (void)setNeedsStateSave;
+- (void)scheduleStateSaveTickAfterDelay:(NSTimeInterval)delay;
+- (void)saveState;
+- (void)writeState;
+- (void)restoreStateFromRecord:(const CNStateRecord *)stateRecord;
+- (CNDisplayIdentity)identityOfCurrentToggleDisplay;
+- (void)recordDraggedToggleSize;
+- (BOOL)dockOverlapsApplicationView;
+- (void)performDockPolicyAction:(CNDockPolicyAction)dockPolicyAction;
+- (void)scheduleDockRestore;
+- (CGImageRef)createSharedSnapshotWithImage:(CGImageRef)imageRef snapshotBuffer:(CNSnapshotBuffer **)snapshotBuffer;
+- (void)discardCurrentSnapshot;
 @end
 
 
+static CVReturn CNQualityDisplayLinkOutput(CVDisplayLinkRef displayLink, const CVTimeStamp *inNow, const CVTimeStamp *inOutputTime,
+                                           CVOptionFlags flagsIn, CVOptionFlags *flagsOut, void *displayLinkContext)
+{
+    [(__bridge CNBackstageController *)displayLinkContext qualityDisplayLinkDidOutputFrame];
+    return kCVReturnSuccess;
+}
+
+/// captures the rect in nominal resolution, safe to call on any queue
+static BOOL CNFingerprintCaptureRect(CNFingerprint *fingerprint, CGRect captureRect)
+{
+    CGImageRef captureRef = CGWindowListCreateImage(captureRect, kCGWindowListOptionOnScreenOnly, kCGNullWindowID, kCGWindowImageNominalResolution);
+    if (captureRef == NULL)
+        return NO;
+
+    BOOL success = NO;
+    if (CGImageGetBitsPerPixel(captureRef) == 32 &&
+        CNFingerprintInit(fingerprint, (int)CGImageGetWidth(captureRef), (int)CGImageGetHeight(captureRef), kCNFingerprintBlockSize, kCNFingerprintRowStep)) {
+        CFDataRef pixelData = CGDataProviderCopyData(CGImageGetDataProvider(captureRef));
+        CNFingerprintCompute(fingerprint, CFDataGetBytePtr(pixelData), CGImageGetBytesPerRow(captureRef));
+        CFRelease(pixelData);
+        success = YES;
+    }
+    CGImageRelease(captureRef);
+    return success;
+}
+
+static void CNSharedSnapshotReleaseBuffer(void *info, const void *data, size_t size)
+{
+    CNSnapshotBufferRelease((CNSnapshotBuffer *)info);
+}
+
+
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -112,18 +268,47 @@
         _defaults                           = [NSUserDefaults standardUserDefaults];
         _applicationCoverIsDragging         = NO;
         _toggleAnimationIsRunning           = NO;
-        _dockIsHidden                       = NO;
-        _applicationView                    = [[NSView alloc] init];
-        _applicationFirstCoverView          = [[NSView alloc] init];
-        _applicationFirstCoverOverlayView   = [[NSView alloc] init];
-        _applicationSecondCoverView         = [[NSView alloc] init];
-        _applicationSecondCoverOverlayView  = [[NSView alloc] init];
-        _shadowView                         = [[CNBackstageShadowView alloc] init];
+        CNDockPolicyInit(&_dockPolicy, 0);
+        _dockRestoreGeneration              = 0;
+        _applicationView                    = nil;                  // all views are created lazily on the first expand
+        _applicationFirstCoverView          = nil;
+        _applicationFirstCoverOverlayView   = nil;
+        _applicationSecondCoverView         = nil;
+        _applicationSecondCoverOverlayView  = nil;
+        _shadowView                         = nil;
         _initialDraggingPoint               = NSZeroPoint;
         _initialFirstCoverOrigin            = NSZeroPoint;
         _initialSecondCoverOrigin           = NSZeroPoint;
         _initialApplicationViewFrame        = NSZeroRect;
         _toggleState                        = CNToggleStateCollapsed;
+        _idleTimerGeneration                = 0;
+        CNIdlePolicyInit(&_idlePolicy, kCNDefaultHibernationInterval, YES);
+        _globalPointerMonitor               = nil;
+        _localPointerMonitor                = nil;
+        _activationTimerGeneration          = 0;
+        _activationTimerDeadline            = -1;
+        _speculativeSnapshot                = NULL;
+        _liveCoverQueue                     = dispatch_queue_create("com.cocoanaut.CNBackstageController.liveCovers", DISPATCH_QUEUE_SERIAL);
+        _liveCoverGeneration                = 0;
+        _liveCoverTileLayers                = @[[NSMutableDictionary dictionary], [NSMutableDictionary dictionary]];
+        _panelViewControllers               = [NSMutableDictionary dictionary];
+        _panelShadowViews                   = [NSMutableDictionary dictionary];
+        _reusableSnapshot                   = NULL;
+        _reusableSnapshotBuffer             = NULL;
+        _snapshotReuseGeneration            = 0;
+        _lightweightOverlayIsActive         = NO;
+        CNQualityGovernorInit(&_qualityGovernor, 0);
+        _activeQualityLevel                 = CNQualityLevelFull;
+        _qualityDisplayLink                 = NULL;
+        _qualityFrameIsPending              = 0;
+        _stateQueue                         = dispatch_queue_create("com.cocoanaut.CNBackstageController.state", DISPATCH_QUEUE_SERIAL);
+        CNStateSaveSchedulerInit(&_stateSaveScheduler, kCNStateSaveDelay);
+        _stateIsRestoring                   = NO;
+        _draggedToggleSizes                 = (CNDraggedSizes){ NULL, 0, 0 };
+        _dockFrames                         = [NSMutableDictionary dictionary];
+        _currentSnapshot                    = NULL;
+        _currentSnapshotBuffer              = NULL;
+        _currentSnapshotGeneration          = 0;
 
         /// properties of API
         _delegate                   = nil;
@@ -139,6 +324,19 @@
         _toggleSizeMin              = NSMakeSize(200.0f, 120.0f);
         _shouldUseShadows           = YES;
         _shadowIntensity            = CNShadowIntensityNormal;
+        _toggleActivation           = CNToggleActivationManual;
+        _toggleActivationDwellTime  = 0.3;
+        _toggleActivationVelocityThreshold = 1500;
+        _shouldUseLiveCovers        = NO;
+        _liveCoverRefreshInterval   = kCNDefaultLiveCoverRefreshInterval;
+        _snapshotReuseInterval      = kCNDefaultSnapshotReuseInterval;
+        _shouldUseLightweightOverlay = NO;
+        _shouldAdaptQuality         = NO;
+        _stateStore                 = nil;
+
+        [self observeMemoryPressure];
+        [_nc addObserver:self selector:@selector(applicationWillTerminate:) name:NSApplicationWillTerminateNotification object:nil];
+        [self updateToggleActivationConfiguration];
     }
     return self;
 }
@@ -165,14 +363,28 @@
 
         [NSApp activateIgnoringOtherApps:YES];
 
+        /// cancel a pending idle timeout and rebuild the resources if they were released
+        _idleTimerGeneration++;
+        _snapshotReuseGeneration++;
+        [self performIdlePolicyAction:CNIdlePolicyWillExpand(&_idlePolicy)];
+
         /// inform the delegate
         [self backstageController:self willExpandOnScreen:[self screenOfCurrentToggleDisplay] toggleEdge:self.toggleEdge];
 
+        /// the quality level stays the same until the next expand, even if the governor changes it in between
+        _activeQualityLevel = (self.shouldAdaptQuality ? _qualityGovernor.level : CNQualityLevelFull);
+
         [self expandUsingCompletionHandler:^{
+            [self endQualitySession];
+
             /// inform the delegate
             [self backstageController:self didExpandOnScreen:[self screenOfCurrentToggleDisplay] toggleEdge:self.toggleEdge];
             _toggleAnimationIsRunning = NO;
+
+            [self startLiveCoverRefresh];
         }];
+        /// the snapshot has been taken synchronously, only the animation is measured
+        [self beginQualitySession];
     }
 }
 
@@ -183,11 +395,19 @@
 
         /// inform the delegate
         [self backstageController:self willCollapseOnScreen:[self screenOfCurrentToggleDisplay] toggleEdge:self.toggleEdge];
+        [self stopLiveCoverRefresh];
+        [self beginQualitySession];
 
         [self collapseUsingCompletionHandler:^{
+            [self endQualitySession];
+
             /// inform the delegate
             [self backstageController:self didCollapseOnScreen:[self screenOfCurrentToggleDisplay] toggleEdge:self.toggleEdge];
             _toggleAnimationIsRunning = NO;
+
+            CNIdlePolicyDidCollapse(&_idlePolicy, CACurrentMediaTime());
+            [self scheduleIdleTimer];
+            [self scheduleSnapshotReuseTimeout];
         }];
     }
 }
@@ -197,6 +417,70 @@
     return _toggleState;
 }
 
+- (void)prewarm
+{
+    CNIdlePolicyAction idlePolicyAction = CNIdlePolicyPrewarm(&_idlePolicy, CACurrentMediaTime());
+    [self performIdlePolicyAction:idlePolicyAction];
+
+    /// the next expand only has to capture the screen, the window and the layer hierarchy are already there
+    if (idlePolicyAction == CNIdlePolicyActionWakeUp && ![self canUseLightweightOverlay]) {
+        [self prepareCoverViews];
+        [self initializeApplicationWindow];
+        [self buildLayerHierarchy];
+    }
+    [self scheduleIdleTimer];
+}
+
+- (CNSnapshotBuffer *)copySnapshotBuffer
+{
+    return CNSnapshotBufferRetain(_currentSnapshotBuffer);
+}
+
+- (CNSnapshotBuffer *)copySnapshotBufferOfGeneration:(NSUInteger)generation
+{
+    if (generation != _currentSnapshotGeneration || _currentSnapshot == NULL)
+        return NULL;
+    return [self copySnapshotBuffer];
+}
+
+- (void)addPanelWithViewController:(NSViewController *)aViewController toggleEdge:(CNToggleEdge)aToggleEdge toggleSize:(CNToggleSize)aToggleSize
+{
+    if (aViewController == nil || aToggleEdge > CNToggleEdgeRight || aToggleEdge == self.toggleEdge)
+        return;
+
+    [self removePanelOnToggleEdge:aToggleEdge];
+    [_panelViewControllers setObject:aViewController forKey:@(aToggleEdge)];
+    _panelToggleSizes[aToggleEdge] = aToggleSize;
+
+    if (_toggleState == CNToggleStateExpanded && !_toggleAnimationIsRunning) {
+        [self buildPanelHierarchy];
+        [NSAnimationContext runAnimationGroup:^(NSAnimationContext *context) {
+            context.duration = kCNAnimationDuration;
+            context.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];
+            [self layoutPanelViewsExpanded:YES animated:YES];
+        } completionHandler:nil];
+    }
+}
+
+- (void)removePanelOnToggleEdge:(CNToggleEdge)aToggleEdge
+{
+    if ([_panelViewControllers objectForKey:@(aToggleEdge)] == nil)
+        return;
+
+    [self removePanelViewOnToggleEdge:aToggleEdge];
+    [_panelViewControllers removeObjectForKey:@(aToggleEdge)];
+
+    /// the remaining panels may grow into the free space
+    if (_toggleState == CNToggleStateExpanded && !_toggleAnimationIsRunning) {
+        [self layoutPanelViewsExpanded:YES animated:NO];
+    }
+}
+
+- (NSViewController *)panelViewControllerOnToggleEdge:(CNToggleEdge)aToggleEdge
+{
+    return [_panelViewControllers objectForKey:@(aToggleEdge)];
+}
+
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -207,7 +491,9 @@
     if (_applicationViewController != applicationViewController) {
         _applicationViewController = nil;
         _applicationViewController = applicationViewController;
-        _applicationView = [_applicationViewController view];
+
+        /// don't load the view of a hibernating controller, this will be done on the next expand
+        _applicationView = (_idlePolicy.state == CNIdlePolicyStateHibernating ? nil : [_applicationViewController view]);
         self.delegate = _applicationViewController;
 
         [[NSNotificationCenter defaultCenter] addObserver:self
@@ -217,6 +503,103 @@
     }
 }
 
+- (void)setToggleEdge:(CNToggleEdge)toggleEdge
+{
+    _toggleEdge = toggleEdge;
+    [self updateToggleActivationConfiguration];
+    [self setNeedsStateSave];
+}
+
+- (void)setToggleDisplay:(CNToggleDisplay)toggleDisplay
+{
+    _toggleDisplay = toggleDisplay;
+    [self updateToggleActivationConfiguration];
+    [self setNeedsStateSave];
+}
+
+- (void)setToggleVisualEffect:(CNToggleAnimationEffect)toggleVisualEffect
+{
+    _toggleVisualEffect = toggleVisualEffect;
+    [self setNeedsStateSave];
+}
+
+- (void)setToggleAnimationEffect:(CNToggleAnimationEffect)toggleAnimationEffect
+{
+    _toggleAnimationEffect = toggleAnimationEffect;
+    [self setNeedsStateSave];
+}
+
+- (void)setOverlayAlpha:(CGFloat)overlayAlpha
+{
+    _overlayAlpha = overlayAlpha;
+    [self setNeedsStateSave];
+}
+
+- (void)setShouldUseShadows:(BOOL)shouldUseShadows
+{
+    _shouldUseShadows = shouldUseShadows;
+    [self setNeedsStateSave];
+}
+
+- (void)setStateStore:(id<CNBackstageStateStore>)stateStore
+{
+    _stateStore = stateStore;
+    CNStateSaveSchedulerReset(&_stateSaveScheduler);
+
+    NSData *recordData = [stateStore loadStateRecord];
+    if (recordData != nil) {
+        CNStateRecord stateRecord;
+        if (CNStateRecordDecode(&stateRecord, [recordData bytes], [recordData length], (int)[[NSScreen screens] count])) {
+            [self restoreStateFromRecord:&stateRecord];
+        }
+        CNStateRecordFree(&stateRecord);
+    }
+}
+
+- (void)setToggleActivation:(CNToggleActivation)toggleActivation
+{
+    _toggleActivation = toggleActivation;
+    [self updateToggleActivationMonitors];
+}
+
+- (void)setToggleActivationDwellTime:(NSTimeInterval)toggleActivationDwellTime
+{
+    _toggleActivationDwellTime = toggleActivationDwellTime;
+    [self updateToggleActivationConfiguration];
+}
+
+- (void)setToggleActivationVelocityThreshold:(CGFloat)toggleActivationVelocityThreshold
+{
+    _toggleActivationVelocityThreshold = toggleActivationVelocityThreshold;
+    [self updateToggleActivationConfiguration];
+}
+
+- (void)setShouldUseLiveCovers:(BOOL)shouldUseLiveCovers
+{
+    _shouldUseLiveCovers = shouldUseLiveCovers;
+    [self stopLiveCoverRefresh];
+    [self startLiveCoverRefresh];
+}
+
+- (void)setShouldAdaptQuality:(BOOL)shouldAdaptQuality
+{
+    _shouldAdaptQuality = shouldAdaptQuality;
+    CNQualityGovernorReset(&_qualityGovernor);
+}
+
+- (CNToggleQuality)currentQuality
+{
+    return (self.shouldAdaptQuality ? (CNToggleQuality)_qualityGovernor.level : CNToggleQualityFull);
+}
+
+- (void)setSnapshotReuseInterval:(NSTimeInterval)snapshotReuseInterval
+{
+    _snapshotReuseInterval = snapshotReuseInterval;
+    if (snapshotReuseInterval <= 0) {
+        [self discardReusableArtifacts];
+    }
+}
+
 - (CNToggleSize)toggleSize
 {
     return _toggleSize;
@@ -226,6 +609,9 @@
 {
     NSUInteger width = 0, height = 0;
 
+    /// the window doesn't exist before the first expand, after a hibernation or while the state is restored
+    NSRect windowFrame = ([self window] != nil ? [[self window] frame] : [self contentRectOfCurrentToggleDisplay]);
+
     switch (aToggleSize.width) {
         case CNToggleSizeQuarterScreen:
         case CNToggleSizeHalfScreen:
@@ -240,8 +626,7 @@
                 case CNToggleEdgeLeft:
                 case CNToggleEdgeRight:
                 case CNToggleEdgeSplitHorizontal: {
-                    CGFloat windowWidth = NSWidth([[self window] frame]);
-                    if (aToggleSize.width <= windowWidth) {
+                    if (aToggleSize.width <= NSWidth(windowFrame)) {
                         width = aToggleSize.width;
                     }
 
@@ -276,8 +661,7 @@
                 case CNToggleEdgeTop:
                 case CNToggleEdgeBottom:
                 case CNToggleEdgeSplitVertical: {
-                    CGFloat windowHeight = NSHeight([[self window] frame]);
-                    if (aToggleSize.height <= windowHeight && aToggleSize.height >= self.toggleSizeMin.height) {
+                    if (aToggleSize.height <= NSHeight(windowFrame) && aToggleSize.height >= self.toggleSizeMin.height) {
                         height = aToggleSize.height;
                     }
 
@@ -299,6 +683,12 @@
 #pragma clang diagnostic pop
     
     _toggleSize = CNMakeToggleSize(width, height);
+
+    /// an explicitly set size replaces the size the user has dragged on this display and edge, the others stay
+    if (!_stateIsRestoring) {
+        CNDraggedSizesRemove(&_draggedToggleSizes, [self identityOfCurrentToggleDisplay], (CNLayoutEdge)self.toggleEdge);
+    }
+    [self setNeedsStateSave];
 }
 
 - (CGRect)currentToggleDisplayFrame
@@ -306,6 +696,37 @@
     return [[self screenOfCurrentToggleDisplay] frame];
 }
 
+- (NSTimeInterval)hibernationInterval
+{
+    return _idlePolicy.idleInterval;
+}
+
+- (NSTimeInterval)dockRestoreDelay
+{
+    return _dockPolicy.restoreDelay;
+}
+
+- (void)setDockRestoreDelay:(NSTimeInterval)dockRestoreDelay
+{
+    _dockPolicy.restoreDelay = dockRestoreDelay;
+}
+
+- (void)setHibernationInterval:(NSTimeInterval)hibernationInterval
+{
+    _idlePolicy.idleInterval = hibernationInterval;
+    [self scheduleIdleTimer];
+}
+
+- (BOOL)shouldHibernateOnMemoryPressure
+{
+    return _idlePolicy.hibernatesOnMemoryPressure;
+}
+
+- (void)setShouldHibernateOnMemoryPressure:(BOOL)shouldHibernateOnMemoryPressure
+{
+    _idlePolicy.hibernatesOnMemoryPressure = shouldHibernateOnMemoryPressure;
+}
+
 
 
 
@@ -314,17 +735,30 @@
 
 - (void)expandUsingCompletionHandler:(void(^)(void))completionHandler
 {
+    _lightweightOverlayIsActive = [self canUseLightweightOverlay];
+    if (_lightweightOverlayIsActive) {
+        [self expandLightweightOverlayUsingCompletionHandler:completionHandler];
+        return;
+    }
+
+    [self prepareCoverViews];
     [self initializeApplicationWindow];
     [self buildLayerHierarchy];
+    [self buildPanelHierarchy];
     [self createSnapshotOfCurrentToggleDisplay];
     [self configurePresentationOptions];
 
 
-    __block NSRect applicationFrame = [_applicationView frame];
-    __block NSRect screenSnapshotFirstFrame = [_applicationFirstCoverView frame];
-    __block NSRect screenSnapshotSecondFrame = [_applicationSecondCoverView frame];
-
-    switch (self.toggleAnimationEffect) {
+    /// target frames of the expand animation
+    NSRect windowFrame = [[self window] frame];
+    CNLayoutFrames expandedFrames;
+    CNLayoutExpandedFrames((CNLayoutEdge)self.toggleEdge, (CNLayoutAnimation)[self effectiveToggleAnimationEffect],
+                           NSWidth(windowFrame), NSHeight(windowFrame), [self thicknessOfApplicationViewForFrame:windowFrame], &expandedFrames);
+    NSRect applicationFrame = NSRectFromLayoutRect(expandedFrames.applicationFrame);
+    NSRect screenSnapshotFirstFrame = NSRectFromLayoutRect(expandedFrames.firstCoverFrame);
+    NSRect screenSnapshotSecondFrame = (expandedFrames.hasSecondCover ? NSRectFromLayoutRect(expandedFrames.secondCoverFrame) : [_applicationSecondCoverView frame]);
+
+    switch ([self effectiveToggleAnimationEffect]) {
         case CNToggleAnimationEffectFade:
             [_applicationView setAlphaValue:0.0];
             break;
@@ -334,7 +768,7 @@
         context.duration = kCNAnimationDuration;
         context.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];
 
-        switch (self.toggleAnimationEffect) {
+        switch ([self effectiveToggleAnimationEffect]) {
             case CNToggleAnimationEffectStatic:
                 break;
 
@@ -342,43 +776,16 @@
                 [[_applicationView animator] setAlphaValue:1.0];
                 break;
 
-            case CNToggleAnimationEffectSlide: {
-                switch (self.toggleEdge) {
-                    case CNToggleEdgeTop:       applicationFrame.origin.y -= ceil(NSHeight(applicationFrame)); break;
-                    case CNToggleEdgeBottom:    applicationFrame.origin.y += ceil(NSHeight(applicationFrame)); break;
-                    case CNToggleEdgeLeft:      applicationFrame.origin.x += ceil(NSWidth(applicationFrame)); break;
-                    case CNToggleEdgeRight:     applicationFrame.origin.x -= ceil(NSWidth(applicationFrame)); break;
-                    default: break;
-                }
+            case CNToggleAnimationEffectSlide:
                 [[_applicationView animator] setFrame:applicationFrame];
                 break;
-            }
-            default:
-                break;
-        }
-
-        // configure the screen snapshot view
-        switch (self.toggleEdge) {
-            case CNToggleEdgeTop:       screenSnapshotFirstFrame.origin.y -= ceil(NSHeight(applicationFrame)); break;
-            case CNToggleEdgeBottom:    screenSnapshotFirstFrame.origin.y += ceil(NSHeight(applicationFrame)); break;
-            case CNToggleEdgeLeft:      screenSnapshotFirstFrame.origin.x += ceil(NSWidth(applicationFrame)); break;
-            case CNToggleEdgeRight:     screenSnapshotFirstFrame.origin.x -= ceil(NSWidth(applicationFrame)); break;
-
-            case CNToggleEdgeSplitHorizontal:
-                screenSnapshotFirstFrame.origin.x -= ceil(NSWidth(applicationFrame)/2)-1;
-                screenSnapshotSecondFrame.origin.x += ceil(NSWidth(applicationFrame)/2)-1;
-                break;
-
-            case CNToggleEdgeSplitVertical:
-                screenSnapshotFirstFrame.origin.y += ceil(NSHeight(applicationFrame)/2)-1;
-                screenSnapshotSecondFrame.origin.y -= ceil(NSHeight(applicationFrame)/2)-1;
-                break;
 
             default:
                 break;
         }
 
         [self activateVisualEffects];
+        [self layoutPanelViewsExpanded:YES animated:YES];
         [[_applicationFirstCoverView animator] setFrame:screenSnapshotFirstFrame];
         [[_applicationSecondCoverView animator] setFrame:screenSnapshotSecondFrame];
 
@@ -393,6 +800,11 @@
 
 - (void)collapseUsingCompletionHandler:(void(^)(void))completionHandler
 {
+    if (_lightweightOverlayIsActive) {
+        [self collapseLightweightOverlayUsingCompletionHandler:completionHandler];
+        return;
+    }
+
     __block NSRect applicationFrame = [_applicationView frame];
     __block NSRect screenSnapshotFirstFrame = [_applicationFirstCoverView frame];
     __block NSRect screenSnapshotSecondFrame = [_applicationSecondCoverView frame];
@@ -401,7 +813,7 @@
         context.duration = kCNAnimationDuration;
         context.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];
 
-        switch (self.toggleAnimationEffect) {
+        switch ([self effectiveToggleAnimationEffect]) {
             case CNToggleAnimationEffectStatic:
                 break;
 
@@ -441,6 +853,7 @@
         }
 
         [self deactivateVisualEffects];
+        [self layoutPanelViewsExpanded:NO animated:YES];
         [[_applicationFirstCoverView animator] setFrame:screenSnapshotFirstFrame];
         [[_applicationSecondCoverView animator] setFrame:screenSnapshotSecondFrame];
 
@@ -450,6 +863,7 @@
         [_applicationSecondCoverOverlayView.layer setFilters:nil];
         [self restorePresentationOptions];
         [self resignApplicationWindow];
+        [self discardCurrentSnapshot];
 
         _toggleAnimationIsRunning = NO;
         _toggleState = CNToggleStateCollapsed;
@@ -470,10 +884,12 @@
         [[_applicationSecondCoverOverlayView animator] setAlphaValue:self.overlayAlpha];
     }
 
-    if (self.toggleVisualEffect & CNToggleVisualEffectGaussianBlur) {
-        _gaussianBlurFilter = [CIFilter filterWithName:@"CIGaussianBlur"];
-        [_gaussianBlurFilter setDefaults];
-        [_gaussianBlurFilter setValue:[NSNumber numberWithFloat:2] forKey:@"inputRadius"];
+    if ((self.toggleVisualEffect & CNToggleVisualEffectGaussianBlur) && [self effectiveGaussianBlurRadius] > 0) {
+        if (_gaussianBlurFilter == nil) {
+            _gaussianBlurFilter = [CIFilter filterWithName:@"CIGaussianBlur"];
+            [_gaussianBlurFilter setDefaults];
+        }
+        [_gaussianBlurFilter setValue:[NSNumber numberWithFloat:[self effectiveGaussianBlurRadius]] forKey:@"inputRadius"];
         [_applicationFirstCoverOverlayView.layer setMasksToBounds:YES];
         [_applicationSecondCoverOverlayView.layer setMasksToBounds:YES];
         [_applicationFirstCoverOverlayView.layer setBackgroundFilters:@[_gaussianBlurFilter]];
@@ -504,6 +920,18 @@
 - (CNToggleFrameDeltas)toggleDeltasForFrame:(NSRect)aFrame
 {
     CNToggleFrameDeltas frameDeltas = CNMakeToggleFrameDeltas(0, 0);
+
+    /// the size the user has dragged on this display and edge wins over the configured one
+    long draggedSize = 0;
+    if (CNDraggedSizesGet(&_draggedToggleSizes, [self identityOfCurrentToggleDisplay], (CNLayoutEdge)self.toggleEdge, &draggedSize)) {
+        if (CNLayoutEdgeIsHorizontal((CNLayoutEdge)self.toggleEdge)) {
+            frameDeltas.deltaX = MIN(draggedSize, NSWidth(aFrame));
+        } else {
+            frameDeltas.deltaY = MIN(draggedSize, NSHeight(aFrame));
+        }
+        return frameDeltas;
+    }
+
     switch (self.toggleEdge) {
         case CNToggleEdgeTop:
         case CNToggleEdgeBottom:
@@ -544,6 +972,11 @@
 }
 
 - (void)initializeApplicationWindow
+{
+    [self initializeWindowWithContentRect:[self contentRectOfCurrentToggleDisplay]];
+}
+
+- (NSRect)contentRectOfCurrentToggleDisplay
 {
     CGDirectDisplayID displayID = [self displayIDForCurrentToggleDisplay:self.toggleDisplay];
     NSRect windowRect = NSMakeRect(0, 0, CGDisplayPixelsWide(displayID), CGDisplayPixelsHigh(displayID));
@@ -551,6 +984,24 @@
     if (self.toggleDisplay == CNToggleDisplayMain) {
         windowRect.size.height -= [self thicknessOfSystemStatusBarForCurrentToggleDisplay];
     }
+    return windowRect;
+}
+
+- (void)initializeWindowWithContentRect:(NSRect)windowRect
+{
+    CGDirectDisplayID displayID = [self displayIDForCurrentToggleDisplay:self.toggleDisplay];
+
+    /// the window of the previous expand is kept for `snapshotReuseInterval` seconds
+    if (self.window != nil) {
+        NSRect screenFrame = [[self screenForDisplayWithID:displayID] frame];
+        if (NSEqualRects([self.window frame], NSOffsetRect(windowRect, NSMinX(screenFrame), NSMinY(screenFrame)))) {
+            [self.window setBackgroundColor:self.backgroundColor];
+            self.window.alphaValue = 1.0;
+            return;
+        }
+        [self.window close];
+        self.window = nil;
+    }
 
     NSWindow *controllerWindow = [[NSWindow alloc] initWithContentRect:windowRect
                                                              styleMask:NSBorderlessWindowMask
@@ -576,12 +1027,15 @@
     _applicationView.frame = [self frameOfApplicationView];
     [controllerWindowContentView addSubview:_applicationView];
 
-    // application shadow view
-    _shadowView = [[CNBackstageShadowView alloc] initWithFrame:[_applicationView bounds]];
+    // application shadow view, a prewarmed hierarchy is only updated
+    if (_shadowView == nil) {
+        _shadowView = [[CNBackstageShadowView alloc] initWithFrame:[_applicationView bounds]];
+        [_shadowView setAutoresizingMask:NSViewWidthSizable | NSViewHeightSizable];
+    }
+    _shadowView.frame = [_applicationView bounds];
     _shadowView.toggleEdge = self.toggleEdge;
-    _shadowView.shouldUseShadows = self.shouldUseShadows;
+    _shadowView.shouldUseShadows = [self effectiveShadowUsage];
     _shadowView.shadowIntensity = self.shadowIntensity;
-    [_shadowView setAutoresizingMask:NSViewWidthSizable | NSViewHeightSizable];
     [_applicationView addSubview:_shadowView];
 
     // Screen Snapshot, First
@@ -589,7 +1043,7 @@
     [_applicationFirstCoverView addSubview:_applicationFirstCoverOverlayView];
     _applicationFirstCoverOverlayView.alphaValue = 0.0f;
 
-    if (self.isResizingAllowed) {
+    if (self.isResizingAllowed && [[_applicationFirstCoverView trackingAreas] count] == 0) {
         NSTrackingArea *firstTrackingArea = [[NSTrackingArea alloc] initWithRect:_applicationFirstCoverView.layer.frame
                                                                          options:NSTrackingMouseEnteredAndExited | NSTrackingCursorUpdate | NSTrackingActiveInKeyWindow | NSTrackingEnabledDuringMouseDrag
                                                                            owner:self
@@ -602,99 +1056,59 @@
         [_applicationSecondCoverView addSubview:_applicationSecondCoverOverlayView];
         _applicationSecondCoverOverlayView.alphaValue = 0.0f;
 
-        NSTrackingArea *secondTrackingArea = [[NSTrackingArea alloc] initWithRect:_applicationSecondCoverView.layer.frame
-                                                                          options:NSTrackingMouseEnteredAndExited | NSTrackingCursorUpdate | NSTrackingActiveInKeyWindow | NSTrackingEnabledDuringMouseDrag
-                                                                            owner:self
-                                                                         userInfo:nil];
-        [_applicationSecondCoverView addTrackingArea:secondTrackingArea];
+        if ([[_applicationSecondCoverView trackingAreas] count] == 0) {
+            NSTrackingArea *secondTrackingArea = [[NSTrackingArea alloc] initWithRect:_applicationSecondCoverView.layer.frame
+                                                                              options:NSTrackingMouseEnteredAndExited | NSTrackingCursorUpdate | NSTrackingActiveInKeyWindow | NSTrackingEnabledDuringMouseDrag
+                                                                                owner:self
+                                                                             userInfo:nil];
+            [_applicationSecondCoverView addTrackingArea:secondTrackingArea];
+        }
+    } else {
+        /// the toggle edge may have changed since the hierarchy was prewarmed
+        [_applicationSecondCoverView removeFromSuperview];
     }
 }
 
 - (NSRect)frameOfApplicationView
 {
-    NSRect resultRect = NSZeroRect;
     NSRect windowFrame = [[self window] frame];
+    CNLayoutFrames collapsedFrames;
+    CNLayoutCollapsedFrames((CNLayoutEdge)self.toggleEdge, (CNLayoutAnimation)[self effectiveToggleAnimationEffect],
+                            NSWidth(windowFrame), NSHeight(windowFrame), [self thicknessOfApplicationViewForFrame:windowFrame], &collapsedFrames);
+    return NSRectFromLayoutRect(collapsedFrames.applicationFrame);
+}
 
-    switch (self.toggleEdge) {
-        case CNToggleEdgeTop: {
-            resultRect.size = NSMakeSize(NSWidth(windowFrame), ceil([self toggleDeltasForFrame:windowFrame].deltaY));
-            switch (self.toggleAnimationEffect) {
-                case CNToggleAnimationEffectStatic:
-                case CNToggleAnimationEffectFade:
-                    resultRect.origin.y = NSHeight(windowFrame) - NSHeight(resultRect);
-                    break;
-
-                case CNToggleAnimationEffectSlide:
-                    resultRect.origin.y = NSHeight(windowFrame);
-                    break;
-            }
-            break;
-        }
-
-        case CNToggleEdgeBottom: {
-            resultRect.size = NSMakeSize(NSWidth(windowFrame), ceil([self toggleDeltasForFrame:windowFrame].deltaY));
-            switch (self.toggleAnimationEffect) {
-                case CNToggleAnimationEffectStatic:
-                case CNToggleAnimationEffectFade:
-                    resultRect.origin.y = 0;
-                    break;
-
-                case CNToggleAnimationEffectSlide:
-                    resultRect.origin.y = 0 - NSHeight(resultRect);
-                    break;
-            }
-            break;
-        }
-
-        case CNToggleEdgeLeft: {
-            resultRect.size = NSMakeSize(ceil([self toggleDeltasForFrame:windowFrame].deltaX), NSHeight(windowFrame));
-            switch (self.toggleAnimationEffect) {
-                case CNToggleAnimationEffectStatic:
-                case CNToggleAnimationEffectFade:
-                    resultRect.origin.x = 0;
-                    break;
-
-                case CNToggleAnimationEffectSlide:
-                    resultRect.origin.x = 0 - NSWidth(resultRect);
-                    break;
-            }
-            break;
-        }
-
-        case CNToggleEdgeRight: {
-            resultRect.size = NSMakeSize(ceil([self toggleDeltasForFrame:windowFrame].deltaX), NSHeight(windowFrame));
-            switch (self.toggleAnimationEffect) {
-                case CNToggleAnimationEffectStatic:
-                case CNToggleAnimationEffectFade:
-                    resultRect.origin.x = NSWidth([[self window] frame]) - NSWidth(resultRect);
-                    break;
-
-                case CNToggleAnimationEffectSlide:
-                    resultRect.origin.x = NSWidth([[self window] frame]);
-                    break;
-            }
-            break;
-        }
-
-        case CNToggleEdgeSplitHorizontal:
-            resultRect.size = NSMakeSize(ceil([self toggleDeltasForFrame:windowFrame].deltaX), NSHeight(windowFrame));
-            resultRect.origin.x = floor((NSWidth(windowFrame) - NSWidth(resultRect)) / 2);
-            break;
-
-        case CNToggleEdgeSplitVertical:
-            resultRect.size = NSMakeSize(NSWidth(windowFrame), ceil([self toggleDeltasForFrame:windowFrame].deltaY));
-            resultRect.origin.y = floor((NSHeight(windowFrame) - NSHeight(resultRect)) / 2);
-            break;
-    }
-    return resultRect;
+- (CGFloat)thicknessOfApplicationViewForFrame:(NSRect)aFrame
+{
+    CNToggleFrameDeltas frameDeltas = [self toggleDeltasForFrame:aFrame];
+    return ceil(CNLayoutEdgeIsHorizontal((CNLayoutEdge)self.toggleEdge) ? frameDeltas.deltaX : frameDeltas.deltaY);
 }
 
 - (void)createSnapshotOfCurrentToggleDisplay
 {
-    CGDirectDisplayID displayID = [self displayIDForCurrentToggleDisplay:self.toggleDisplay];
-    CGImageRef snapshotRef = [self snapshotOfDisplayWithID:displayID];
+    CGImageRef snapshotRef = [self snapshotOfCurrentToggleDisplay];
     NSRect contentViewBounds = [[[self window] contentView] bounds];
 
+    [self discardCurrentSnapshot];
+    if (snapshotRef != NULL && snapshotRef == _reusableSnapshot && _reusableSnapshotBuffer != NULL) {
+        /// a reused snapshot lives in its snapshot buffer already
+        _currentSnapshotBuffer = CNSnapshotBufferRetain(_reusableSnapshotBuffer);
+    } else {
+        /// the covers and the application read the same allocation from here on
+        CGImageRef sharedSnapshotRef = [self createSharedSnapshotWithImage:snapshotRef snapshotBuffer:&_currentSnapshotBuffer];
+        if (sharedSnapshotRef != NULL) {
+            if (snapshotRef == _reusableSnapshot) {
+                CGImageRelease(_reusableSnapshot);
+                _reusableSnapshot = CGImageRetain(sharedSnapshotRef);
+                _reusableSnapshotBuffer = CNSnapshotBufferRetain(_currentSnapshotBuffer);
+            }
+            CGImageRelease(snapshotRef);
+            snapshotRef = sharedSnapshotRef;
+        }
+    }
+    _currentSnapshot = CGImageRetain(snapshotRef);
+    _currentSnapshotGeneration++;
+
     switch (self.toggleEdge) {
         case CNToggleEdgeTop:
         case CNToggleEdgeBottom:
@@ -741,79 +1155,1132 @@
         }
     }
     CGImageRelease(snapshotRef);
+
+    [self backstageController:self didCaptureSnapshot:_currentSnapshotBuffer onScreen:[self screenOfCurrentToggleDisplay] toggleEdge:self.toggleEdge];
 }
 
 - (void)resignApplicationWindow
 {
     self.window.alphaValue = 0.0;
 
+    [self discardCoverViews];
+    _applicationView.alphaValue = 1.0;
+
+    for (NSNumber *panelEdge in [_panelShadowViews allKeys]) {
+        [self removePanelViewOnToggleEdge:[panelEdge intValue]];
+    }
+
+    /// an ordered out window can be shown again on a quick re-expand
+    if (self.snapshotReuseInterval > 0) {
+        [self.window orderOut:nil];
+    } else {
+        [self.window close];
+        self.window = nil;
+    }
+}
+
+- (void)prepareCoverViews
+{
+    if (_applicationFirstCoverView == nil) {
+        _applicationFirstCoverView          = [[NSView alloc] init];
+        _applicationFirstCoverOverlayView   = [[NSView alloc] init];
+        _applicationSecondCoverView         = [[NSView alloc] init];
+        _applicationSecondCoverOverlayView  = [[NSView alloc] init];
+    }
+}
+
+- (void)discardCoverViews
+{
     [_shadowView removeFromSuperview];
     [_applicationFirstCoverOverlayView removeFromSuperview];
     [_applicationFirstCoverView removeFromSuperview];
     [_applicationSecondCoverOverlayView removeFromSuperview];
     [_applicationSecondCoverView removeFromSuperview];
-    _applicationView.alphaValue = 1.0;
 
-    _shadowView = [[CNBackstageShadowView alloc] init];
-    _applicationFirstCoverView = [[NSView alloc] init];
-    _applicationFirstCoverOverlayView = [[NSView alloc] init];
-    _applicationSecondCoverView = [[NSView alloc] init];
-    _applicationSecondCoverOverlayView = [[NSView alloc] init];
-    [self.window close];
-    self.window = nil;
+    /// the cover views will be recreated on the next expand
+    _shadowView = nil;
+    _applicationFirstCoverView = nil;
+    _applicationFirstCoverOverlayView = nil;
+    _applicationSecondCoverView = nil;
+    _applicationSecondCoverOverlayView = nil;
 }
 
-- (int)thicknessOfSystemStatusBarForCurrentToggleDisplay
+- (void)performIdlePolicyAction:(CNIdlePolicyAction)idlePolicyAction
 {
-    return ([self displayIDForCurrentToggleDisplay:self.toggleDisplay] == CGMainDisplayID() ? [[NSStatusBar systemStatusBar] thickness] : 0);
+    switch (idlePolicyAction) {
+        case CNIdlePolicyActionNone:        break;
+        case CNIdlePolicyActionWakeUp:      [self wakeUpBackstageResources]; break;
+        case CNIdlePolicyActionHibernate:   [self hibernateBackstageResources]; break;
+    }
 }
 
-- (float)valueForToggleSize:(NSInteger)aToggleSize frameSize:(CGFloat)aSize
+- (void)wakeUpBackstageResources
 {
-    float value = 0;
-    switch (aToggleSize) {
-        case CNToggleSizeHalfScreen:         value = aSize /  -2.00 * -1;      break;
-        case CNToggleSizeQuarterScreen:      value = aSize /  -4.00 * -1;      break;
-        case CNToggleSizeThreeQuarterScreen: value = (aSize / -4.00 * -1) * 3; break;
-        case CNToggleSizeOneThirdScreen:     value = aSize /  -3.00 * -1;      break;
-        case CNToggleSizeTwoThirdsScreen:    value = aSize /  -1.50 * -1;      break;
-    }
-    return value;
+    /// give the applicationViewController the chance to rebuild its content before its view is requested
+    [self backstageController:self willWakeUpOnScreen:[self screenOfCurrentToggleDisplay] toggleEdge:self.toggleEdge];
+    _applicationView = [self.applicationViewController view];
 }
 
-- (void)restorePresentationOptions
+- (void)hibernateBackstageResources
 {
-    if (_dockIsHidden) {
-        [NSApp setPresentationOptions:_presentationOptionsBackup];
-        _dockIsHidden = NO;
+    [self backstageController:self willHibernateOnScreen:[self screenOfCurrentToggleDisplay] toggleEdge:self.toggleEdge];
+    [self discardCoverViews];
+    [_applicationView removeFromSuperview];
+    _applicationView = nil;
+
+    /// a view loaded from a nib is loaded again on the next wake up, any other view is up to the delegate
+    if ([self.applicationViewController nibName] != nil) {
+        [self.applicationViewController setView:nil];
     }
+    [self discardSpeculativeSnapshot];
+    [self discardReusableArtifacts];
 }
 
-- (void)configurePresentationOptions
+- (void)scheduleIdleTimer
 {
-    [self showWindow:nil];
-    _presentationOptionsBackup = [NSApp currentSystemPresentationOptions];
-    if ([[self screenOfCurrentToggleDisplay] containsDock]) {
-        [NSApp setPresentationOptions:NSApplicationPresentationHideDock | NSApplicationPresentationDisableProcessSwitching | NSApplicationPresentationDisableAppleMenu | NSApplicationPresentationDisableHideApplication];
-        _dockIsHidden = YES;
-    }
+    NSUInteger timerGeneration = ++_idleTimerGeneration;
+    double deadline = CNIdlePolicyNextDeadline(&_idlePolicy);
+    if (deadline < 0)
+        return;
+
+    /// a single one-shot timer for the whole idle interval, a newer schedule or an expand invalidates it
+    int64_t delay = (int64_t)(MAX(deadline - CACurrentMediaTime(), 0) * NSEC_PER_SEC);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, delay), dispatch_get_main_queue(), ^{
+        if (timerGeneration == _idleTimerGeneration) {
+            [self performIdlePolicyAction:CNIdlePolicyTick(&_idlePolicy, CACurrentMediaTime())];
+        }
+    });
 }
 
-- (CGImageRef)snapshotOfDisplayWithID:(CGDirectDisplayID)displayID
+- (void)observeMemoryPressure
 {
-    return CGDisplayCreateImageForRect(displayID, CGRectMake(0, 0 + [self thicknessOfSystemStatusBarForCurrentToggleDisplay],
-                                                             NSWidth(self.currentToggleDisplayFrame),
-                                                             NSHeight(self.currentToggleDisplayFrame) - [self thicknessOfSystemStatusBarForCurrentToggleDisplay]));
+#ifdef DISPATCH_SOURCE_TYPE_MEMORYPRESSURE
+    _memoryPressureSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0,
+                                                   DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL,
+                                                   dispatch_get_main_queue());
+    dispatch_source_set_event_handler(_memoryPressureSource, ^{
+        unsigned long pressureFlags = dispatch_source_get_data(_memoryPressureSource);
+        CNMemoryPressure pressure = (pressureFlags & DISPATCH_MEMORYPRESSURE_CRITICAL ? CNMemoryPressureCritical : CNMemoryPressureWarning);
+        [self performIdlePolicyAction:CNIdlePolicyMemoryPressure(&_idlePolicy, pressure)];
+    });
+    dispatch_resume(_memoryPressureSource);
+#endif
 }
 
-- (CGDirectDisplayID)displayIDForCurrentToggleDisplay:(CNToggleDisplay)aToggleDisplay
+- (CGImageRef)snapshotOfCurrentToggleDisplay
 {
-    uint32_t MAX_TOGGLE_DISPLAYS = kCNMaxNumberOfSupportedDisplays;   // number of supported displays
-    uint32_t displayCount;
-    CGDirectDisplayID toggleDisplays[MAX_TOGGLE_DISPLAYS];
-    CGGetOnlineDisplayList(MAX_TOGGLE_DISPLAYS, toggleDisplays, &displayCount);
+    CGDirectDisplayID displayID = [self displayIDForCurrentToggleDisplay:self.toggleDisplay];
+
+    /// a snapshot taken while the pointer was dwelling on the toggle edge is used right away
+    if (_speculativeSnapshot != NULL) {
+        CGImageRef snapshotRef = _speculativeSnapshot;
+        _speculativeSnapshot = NULL;
+        [self discardReusableSnapshot];
+        return snapshotRef;
+    }
+
+    /// a nominal resolution capture is only cheaper than the snapshot itself on a Retina display
+    if (self.snapshotReuseInterval <= 0 || [[self screenOfCurrentToggleDisplay] backingScaleFactor] <= 1)
+        return [self snapshotOfDisplayWithID:displayID];
+
+    /// the snapshot of the previous expand is reused if the screen content hasn't changed since then
+    CGRect fingerprintRect = [self fingerprintRectOfDisplayWithID:displayID];
+    __block CNFingerprint fingerprint;
+    __block BOOL hasFingerprint = (_reusableSnapshot != NULL && CNFingerprintCaptureRect(&fingerprint, fingerprintRect));
+    if (hasFingerprint && CNFingerprintMatches(&fingerprint, &_reusableSnapshotFingerprint)) {
+        CNFingerprintFree(&fingerprint);
+        return CGImageRetain(_reusableSnapshot);
+    }
+
+    /// without a previous snapshot there is nothing to compare, the fingerprint for the next expand is taken while the display is captured
+    dispatch_group_t fingerprintGroup = dispatch_group_create();
+    if (!hasFingerprint) {
+        dispatch_group_async(fingerprintGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+            hasFingerprint = CNFingerprintCaptureRect(&fingerprint, fingerprintRect);
+        });
+    }
+
+    [self discardReusableSnapshot];
+    CGImageRef snapshotRef = [self snapshotOfDisplayWithID:displayID];
+    dispatch_group_wait(fingerprintGroup, DISPATCH_TIME_FOREVER);
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(fingerprintGroup);
+#endif
+
+    if (hasFingerprint && snapshotRef != NULL) {
+        _reusableSnapshot = CGImageRetain(snapshotRef);
+        _reusableSnapshotFingerprint = fingerprint;
+    } else if (hasFingerprint) {
+        CNFingerprintFree(&fingerprint);
+    }
+    return snapshotRef;
+}
+
+- (BOOL)canUseLightweightOverlay
+{
+    /// without visual effects, split covers or additional panels there is nothing the screen snapshot is needed for
+    return (self.shouldUseLightweightOverlay &&
+            self.toggleVisualEffect == CNToggleVisualEffectNone &&
+            self.toggleEdge <= CNToggleEdgeRight &&
+            [_panelViewControllers count] == 0);
+}
+
+- (CNLayoutFrames)lightweightOverlayFramesExpanded:(BOOL)expanded
+{
+    /// the window has the size of the applicationView, a sliding applicationView is clipped by it
+    NSRect contentViewBounds = [[[self window] contentView] bounds];
+    CGFloat thickness = (CNLayoutEdgeIsHorizontal((CNLayoutEdge)self.toggleEdge) ? NSWidth(contentViewBounds) : NSHeight(contentViewBounds));
+
+    CNLayoutFrames frames;
+    if (expanded) {
+        CNLayoutExpandedFrames((CNLayoutEdge)self.toggleEdge, (CNLayoutAnimation)[self effectiveToggleAnimationEffect],
+                               NSWidth(contentViewBounds), NSHeight(contentViewBounds), thickness, &frames);
+    } else {
+        CNLayoutCollapsedFrames((CNLayoutEdge)self.toggleEdge, (CNLayoutAnimation)[self effectiveToggleAnimationEffect],
+                                NSWidth(contentViewBounds), NSHeight(contentViewBounds), thickness, &frames);
+    }
+    return frames;
+}
+
+- (void)expandLightweightOverlayUsingCompletionHandler:(void(^)(void))completionHandler
+{
+    /// a window of the size of the applicationView on the toggle edge, the desktop stays visible and live behind it
+    NSRect displayRect = [self contentRectOfCurrentToggleDisplay];
+    CNLayoutFrames displayFrames;
+    CNLayoutExpandedFrames((CNLayoutEdge)self.toggleEdge, CNLayoutAnimationStatic,
+                           NSWidth(displayRect), NSHeight(displayRect), [self thicknessOfApplicationViewForFrame:displayRect], &displayFrames);
+    [self initializeWindowWithContentRect:NSRectFromLayoutRect(displayFrames.applicationFrame)];
+
+    _applicationView.frame = NSRectFromLayoutRect([self lightweightOverlayFramesExpanded:NO].applicationFrame);
+    [[[self window] contentView] addSubview:_applicationView];
+
+    _shadowView = [[CNBackstageShadowView alloc] initWithFrame:[_applicationView bounds]];
+    _shadowView.toggleEdge = self.toggleEdge;
+    _shadowView.shouldUseShadows = [self effectiveShadowUsage];
+    _shadowView.shadowIntensity = self.shadowIntensity;
+    [_shadowView setAutoresizingMask:NSViewWidthSizable | NSViewHeightSizable];
+    [_applicationView addSubview:_shadowView];
+
+    if ([self effectiveToggleAnimationEffect] == CNToggleAnimationEffectFade) {
+        [_applicationView setAlphaValue:0.0];
+    }
+
+    /// no snapshot, no covers and no presentation options, the dock keeps its state
+    [self showWindow:nil];
+
+    NSRect applicationFrame = NSRectFromLayoutRect([self lightweightOverlayFramesExpanded:YES].applicationFrame);
+    [NSAnimationContext runAnimationGroup:^(NSAnimationContext *context) {
+        context.duration = kCNAnimationDuration;
+        context.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];
+
+        [[_applicationView animator] setFrame:applicationFrame];
+        if ([self effectiveToggleAnimationEffect] == CNToggleAnimationEffectFade) {
+            [[_applicationView animator] setAlphaValue:1.0];
+        }
+
+    } completionHandler:^{
+        _toggleState = CNToggleStateExpanded;
+        _toggleAnimationIsRunning = NO;
+
+        completionHandler();
+    }];
+}
+
+- (void)collapseLightweightOverlayUsingCompletionHandler:(void(^)(void))completionHandler
+{
+    NSRect applicationFrame = NSRectFromLayoutRect([self lightweightOverlayFramesExpanded:NO].applicationFrame);
+    [NSAnimationContext runAnimationGroup:^(NSAnimationContext *context) {
+        context.duration = kCNAnimationDuration;
+        context.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];
+
+        [[_applicationView animator] setFrame:applicationFrame];
+        if ([self effectiveToggleAnimationEffect] == CNToggleAnimationEffectFade) {
+            [[_applicationView animator] setAlphaValue:0.0];
+        }
+
+    } completionHandler:^{
+        [self resignApplicationWindow];
+        _lightweightOverlayIsActive = NO;
+
+        _toggleAnimationIsRunning = NO;
+        _toggleState = CNToggleStateCollapsed;
+
+        completionHandler();
+    }];
+}
+
+- (unsigned int)applicableQualityLevels
+{
+    unsigned int applicableLevels = 0;
+    if (self.toggleVisualEffect & CNToggleVisualEffectGaussianBlur) {
+        applicableLevels |= CNQualityLevelMask(CNQualityLevelReducedBlur) | CNQualityLevelMask(CNQualityLevelNoBlur);
+    }
+    if (self.shouldUseShadows) {
+        applicableLevels |= CNQualityLevelMask(CNQualityLevelNoShadows);
+    }
+    if (self.toggleAnimationEffect == CNToggleAnimationEffectSlide) {
+        applicableLevels |= CNQualityLevelMask(CNQualityLevelFade);
+    }
+    if (self.toggleAnimationEffect != CNToggleAnimationEffectStatic) {
+        applicableLevels |= CNQualityLevelMask(CNQualityLevelStatic);
+    }
+    return applicableLevels;
+}
+
+- (CNToggleAnimationEffect)effectiveToggleAnimationEffect
+{
+    if (_activeQualityLevel >= CNQualityLevelStatic)
+        return CNToggleAnimationEffectStatic;
+    if (_activeQualityLevel >= CNQualityLevelFade && self.toggleAnimationEffect == CNToggleAnimationEffectSlide)
+        return CNToggleAnimationEffectFade;
+    return self.toggleAnimationEffect;
+}
+
+- (BOOL)effectiveShadowUsage
+{
+    return (self.shouldUseShadows && _activeQualityLevel < CNQualityLevelNoShadows);
+}
+
+- (CGFloat)effectiveGaussianBlurRadius
+{
+    if (_activeQualityLevel >= CNQualityLevelNoBlur)
+        return 0;
+    return (_activeQualityLevel == CNQualityLevelReducedBlur ? kCNReducedGaussianBlurRadius : kCNGaussianBlurRadius);
+}
+
+- (void)beginQualitySession
+{
+    if (!self.shouldAdaptQuality || _qualityDisplayLink != NULL)
+        return;
+
+    CGDirectDisplayID displayID = [self displayIDForCurrentToggleDisplay:self.toggleDisplay];
+    if (CVDisplayLinkCreateWithCGDisplay(displayID, &_qualityDisplayLink) != kCVReturnSuccess) {
+        _qualityDisplayLink = NULL;
+        return;
+    }
+
+    /// a 120 Hz display has to deliver twice the frames of a 60 Hz display
+    double frameInterval = 0;
+    CVTime refreshPeriod = CVDisplayLinkGetNominalOutputVideoRefreshPeriod(_qualityDisplayLink);
+    if (!(refreshPeriod.flags & kCVTimeIsIndefinite) && refreshPeriod.timeValue > 0) {
+        frameInterval = (double)refreshPeriod.timeValue / refreshPeriod.timeScale;
+    }
+    CNQualityGovernorSetApplicableLevels(&_qualityGovernor, [self applicableQualityLevels]);
+    CNQualityGovernorBeginSession(&_qualityGovernor, frameInterval);
+
+    _qualityFrameIsPending = 0;
+    CVDisplayLinkSetOutputCallback(_qualityDisplayLink, CNQualityDisplayLinkOutput, (__bridge void *)self);
+    CVDisplayLinkStart(_qualityDisplayLink);
+}
+
+- (void)endQualitySession
+{
+    if (_qualityDisplayLink == NULL)
+        return;
+
+    CVDisplayLinkStop(_qualityDisplayLink);
+    CVDisplayLinkRelease(_qualityDisplayLink);
+    _qualityDisplayLink = NULL;
+
+    if (CNQualityGovernorEndSession(&_qualityGovernor)) {
+        [self backstageController:self didChangeQuality:self.currentQuality onScreen:[self screenOfCurrentToggleDisplay] toggleEdge:self.toggleEdge];
+    }
+}
+
+- (void)qualityDisplayLinkDidOutputFrame
+{
+    /// called on the display link thread. A frame is counted when the main thread gets to it, display refreshes that pass
+    /// while the main thread is still busy with the previous frame are counted as missed frames.
+    if (!OSAtomicCompareAndSwap32Barrier(0, 1, &_qualityFrameIsPending))
+        return;
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+        _qualityFrameIsPending = 0;
+        if (_qualityDisplayLink == NULL)
+            return;
+
+        if (CNQualityGovernorAddFrame(&_qualityGovernor, CACurrentMediaTime())) {
+            [self backstageController:self didChangeQuality:self.currentQuality onScreen:[self screenOfCurrentToggleDisplay] toggleEdge:self.toggleEdge];
+        }
+    });
+}
+
+- (void)setNeedsStateSave
+{
+    if (self.stateStore == nil || _stateIsRestoring)
+        return;
+
+    /// a burst of changes, e.g. from a slider, results in a single write
+    if (CNStateSaveSchedulerChange(&_stateSaveScheduler, CACurrentMediaTime())) {
+        [self scheduleStateSaveTickAfterDelay:kCNStateSaveDelay];
+    }
+}
+
+- (void)scheduleStateSaveTickAfterDelay:(NSTimeInterval)delay
+{
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        CFTimeInterval now = CACurrentMediaTime();
+        switch (CNStateSaveSchedulerTick(&_stateSaveScheduler, now)) {
+            case CNStateSaveActionSave:
+                [self writeState];
+                break;
+            case CNStateSaveActionWait:
+                [self scheduleStateSaveTickAfterDelay:_stateSaveScheduler.deadline - now];
+                break;
+            default:
+                break;
+        }
+    });
+}
+
+- (void)saveState
+{
+    if (CNStateSaveSchedulerFlush(&_stateSaveScheduler)) {
+        [self writeState];
+    }
+}
+
+- (void)writeState
+{
+    CNStateRecord stateRecord;
+    CNStateRecordInit(&stateRecord);
+    stateRecord.fields = CNStateFieldEdge | CNStateFieldSize | CNStateFieldDisplay | CNStateFieldVisualEffects |
+                         CNStateFieldAnimation | CNStateFieldOverlayAlpha | CNStateFieldShadows;
+    stateRecord.edge = (CNLayoutEdge)self.toggleEdge;
+    stateRecord.sizeWidth = self.toggleSize.width;
+    stateRecord.sizeHeight = self.toggleSize.height;
+    stateRecord.display = self.toggleDisplay;
+    stateRecord.visualEffects = self.toggleVisualEffect;
+    stateRecord.animation = (CNLayoutAnimation)self.toggleAnimationEffect;
+    stateRecord.overlayAlpha = self.overlayAlpha;
+    stateRecord.shouldUseShadows = self.shouldUseShadows;
+
+    /// the record is a few hundred bytes and encoded on the main thread, only the write happens in the background
+    NSMutableData *recordData = nil;
+    if (CNDraggedSizesCopy(&stateRecord.draggedSizes, &_draggedToggleSizes)) {
+        size_t length = CNStateRecordEncode(&stateRecord, NULL, 0);
+        recordData = [NSMutableData dataWithLength:length + 1];
+        CNStateRecordEncode(&stateRecord, [recordData mutableBytes], length + 1);
+        [recordData setLength:length];
+    }
+    CNStateRecordFree(&stateRecord);
+
+    id<CNBackstageStateStore> stateStore = self.stateStore;
+    if (recordData == nil || stateStore == nil)
+        return;
+    dispatch_async(_stateQueue, ^{
+        [stateStore saveStateRecord:recordData];
+    });
+}
+
+- (void)restoreStateFromRecord:(const CNStateRecord *)stateRecord
+{
+    /// the decoder has checked every value against its range and the display against the screens that are online
+    _stateIsRestoring = YES;
+
+    if (stateRecord->fields & CNStateFieldEdge)             self.toggleEdge = (CNToggleEdge)stateRecord->edge;
+    if (stateRecord->fields & CNStateFieldDisplay)          self.toggleDisplay = (CNToggleDisplay)stateRecord->display;
+    if (stateRecord->fields & CNStateFieldVisualEffects)    self.toggleVisualEffect = stateRecord->visualEffects;
+    if (stateRecord->fields & CNStateFieldAnimation)        self.toggleAnimationEffect = (CNToggleAnimationEffect)stateRecord->animation;
+    if (stateRecord->fields & CNStateFieldOverlayAlpha)     self.overlayAlpha = stateRecord->overlayAlpha;
+    if (stateRecord->fields & CNStateFieldShadows)          self.shouldUseShadows = stateRecord->shouldUseShadows;
+    if (stateRecord->fields & CNStateFieldSize) {
+        self.toggleSize = CNMakeToggleSize(stateRecord->sizeWidth, stateRecord->sizeHeight);
+    }
+    CNDraggedSizesCopy(&_draggedToggleSizes, &stateRecord->draggedSizes);
+
+    _stateIsRestoring = NO;
+}
+
+- (CNDisplayIdentity)identityOfCurrentToggleDisplay
+{
+    /// display IDs may change between launches, vendor, model and serial number identify a display again
+    CGDirectDisplayID displayID = [self displayIDForCurrentToggleDisplay:self.toggleDisplay];
+    CNDisplayIdentity identity = { CGDisplayVendorNumber(displayID), CGDisplayModelNumber(displayID), CGDisplaySerialNumber(displayID) };
+    return identity;
+}
+
+- (void)recordDraggedToggleSize
+{
+    NSRect applicationFrame = [_applicationView frame];
+    CGFloat draggedSize = (CNLayoutEdgeIsHorizontal((CNLayoutEdge)self.toggleEdge) ? NSWidth(applicationFrame) : NSHeight(applicationFrame));
+    if (CNDraggedSizesSet(&_draggedToggleSizes, [self identityOfCurrentToggleDisplay], (CNLayoutEdge)self.toggleEdge, (long)ceil(draggedSize))) {
+        [self setNeedsStateSave];
+    }
+}
+
+- (CGRect)fingerprintRectOfDisplayWithID:(CGDirectDisplayID)displayID
+{
+    /// same region as the snapshot, but in nominal resolution
+    CGRect displayBounds = CGDisplayBounds(displayID);
+    int statusBarThickness = [self thicknessOfSystemStatusBarForCurrentToggleDisplay];
+    return CGRectMake(CGRectGetMinX(displayBounds), CGRectGetMinY(displayBounds) + statusBarThickness,
+                      NSWidth(self.currentToggleDisplayFrame), NSHeight(self.currentToggleDisplayFrame) - statusBarThickness);
+}
+
+- (void)scheduleSnapshotReuseTimeout
+{
+    NSUInteger timerGeneration = ++_snapshotReuseGeneration;
+    if (self.snapshotReuseInterval <= 0)
+        return;
+
+    int64_t delay = (int64_t)(self.snapshotReuseInterval * NSEC_PER_SEC);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, delay), dispatch_get_main_queue(), ^{
+        if (timerGeneration == _snapshotReuseGeneration && _toggleState == CNToggleStateCollapsed && !_toggleAnimationIsRunning) {
+            [self discardReusableArtifacts];
+        }
+    });
+}
+
+- (void)discardReusableSnapshot
+{
+    if (_reusableSnapshot != NULL) {
+        CGImageRelease(_reusableSnapshot);
+        _reusableSnapshot = NULL;
+    }
+    CNSnapshotBufferRelease(_reusableSnapshotBuffer);
+    _reusableSnapshotBuffer = NULL;
+    CNFingerprintFree(&_reusableSnapshotFingerprint);
+}
+
+- (CGImageRef)createSharedSnapshotWithImage:(CGImageRef)imageRef snapshotBuffer:(CNSnapshotBuffer **)snapshotBuffer
+{
+    *snapshotBuffer = NULL;
+    if (imageRef == NULL)
+        return NULL;
+
+    /// 32 bit little endian xRGB or ARGB, which is BGRx or BGRA in memory
+    CGImageAlphaInfo alphaInfo = CGImageGetAlphaInfo(imageRef);
+    BOOL isOpaque = (alphaInfo == kCGImageAlphaNone || alphaInfo == kCGImageAlphaNoneSkipFirst || alphaInfo == kCGImageAlphaNoneSkipLast);
+    CGBitmapInfo bitmapInfo = kCGBitmapByteOrder32Little | (isOpaque ? kCGImageAlphaNoneSkipFirst : kCGImageAlphaPremultipliedFirst);
+
+    CNSnapshotBufferInfo info;
+    info.width = (int)CGImageGetWidth(imageRef);
+    info.height = (int)CGImageGetHeight(imageRef);
+    info.bytesPerRow = ((size_t)info.width * 4 + 63) & ~(size_t)63;
+    info.pixelFormat = CNImagePixelFormatBGRA;
+    info.isOpaque = isOpaque;
+    info.backingScale = [[self screenOfCurrentToggleDisplay] backingScaleFactor];
+    info.displayID = [self displayIDForCurrentToggleDisplay:self.toggleDisplay];
+
+    size_t length = info.bytesPerRow * (size_t)info.height;
+    void *bytes = (length > 0 ? malloc(length) : NULL);
+    if (bytes == NULL)
+        return NULL;
+
+    /// the capture is drawn once into memory the snapshot buffer owns, the image for the covers is made over the same bytes
+    CGColorSpaceRef colorSpace = CGImageGetColorSpace(imageRef);
+    if (colorSpace != NULL && CGColorSpaceGetModel(colorSpace) == kCGColorSpaceModelRGB) {
+        CGColorSpaceRetain(colorSpace);
+    } else {
+        colorSpace = CGColorSpaceCreateDeviceRGB();
+    }
+    CGContextRef context = CGBitmapContextCreate(bytes, info.width, info.height, 8, info.bytesPerRow, colorSpace, bitmapInfo);
+    if (context == NULL) {
+        CGColorSpaceRelease(colorSpace);
+        free(bytes);
+        return NULL;
+    }
+    CGContextSetBlendMode(context, kCGBlendModeCopy);
+    CGContextSetInterpolationQuality(context, kCGInterpolationNone);
+    CGContextDrawImage(context, CGRectMake(0, 0, info.width, info.height), imageRef);
+    CGContextRelease(context);
+
+    CNSnapshotBuffer *buffer = CNSnapshotBufferCreateWithBytes(&info, bytes, length, free, bytes);
+    if (buffer == NULL) {
+        CGColorSpaceRelease(colorSpace);
+        free(bytes);
+        return NULL;
+    }
+
+    /// the image holds a reference to the buffer, so the pixels live as long as a layer shows them
+    CGImageRef sharedImageRef = NULL;
+    CGDataProviderRef provider = CGDataProviderCreateWithData(CNSnapshotBufferRetain(buffer), bytes, length, CNSharedSnapshotReleaseBuffer);
+    if (provider != NULL) {
+        sharedImageRef = CGImageCreate(info.width, info.height, 8, 32, info.bytesPerRow, colorSpace, bitmapInfo, provider, NULL, false, kCGRenderingIntentDefault);
+        CGDataProviderRelease(provider);
+    } else {
+        CNSnapshotBufferRelease(buffer);
+    }
+    CGColorSpaceRelease(colorSpace);
+
+    if (sharedImageRef == NULL) {
+        CNSnapshotBufferRelease(buffer);
+        return NULL;
+    }
+    *snapshotBuffer = buffer;
+    return sharedImageRef;
+}
+
+- (void)discardCurrentSnapshot
+{
+    /// buffers handed out stay valid, they hold their own reference to the pixels
+    CNSnapshotBufferRelease(_currentSnapshotBuffer);
+    _currentSnapshotBuffer = NULL;
+    if (_currentSnapshot != NULL) {
+        CGImageRelease(_currentSnapshot);
+        _currentSnapshot = NULL;
+    }
+}
+
+- (void)discardReusableArtifacts
+{
+    [self discardReusableSnapshot];
+    if (_toggleState == CNToggleStateCollapsed && !_toggleAnimationIsRunning) {
+        _gaussianBlurFilter = nil;
+        [self.window close];
+        self.window = nil;
+    }
+}
+
+- (void)updateToggleActivationMonitors
+{
+    [self updateToggleActivationConfiguration];
+
+    BOOL shouldMonitor = (self.toggleActivation != CNToggleActivationManual);
+    if (shouldMonitor && _globalPointerMonitor == nil) {
+        __weak CNBackstageController *weakSelf = self;
+        _globalPointerMonitor = [NSEvent addGlobalMonitorForEventsMatchingMask:NSMouseMovedMask handler:^(NSEvent *theEvent) {
+            [weakSelf toggleActivationPointerMoved:theEvent];
+        }];
+        _localPointerMonitor = [NSEvent addLocalMonitorForEventsMatchingMask:NSMouseMovedMask handler:^NSEvent *(NSEvent *theEvent) {
+            [weakSelf toggleActivationPointerMoved:theEvent];
+            return theEvent;
+        }];
+        [_nc addObserver:self selector:@selector(screenParametersDidChange:) name:NSApplicationDidChangeScreenParametersNotification object:nil];
+    }
+
+    else if (!shouldMonitor && _globalPointerMonitor != nil) {
+        [NSEvent removeMonitor:_globalPointerMonitor];
+        [NSEvent removeMonitor:_localPointerMonitor];
+        _globalPointerMonitor = nil;
+        _localPointerMonitor = nil;
+        [_nc removeObserver:self name:NSApplicationDidChangeScreenParametersNotification object:nil];
+    }
+}
+
+- (void)updateToggleActivationConfiguration
+{
+    NSRect screenFrame = [[self screenOfCurrentToggleDisplay] frame];
+
+    CNEdgeActivationConfig config;
+    config.enabled              = (self.toggleActivation != CNToggleActivationManual && self.toggleEdge <= CNToggleEdgeRight);
+    config.x                    = NSMinX(screenFrame);
+    config.y                    = NSMinY(screenFrame);
+    config.width                = NSWidth(screenFrame);
+    config.height               = NSHeight(screenFrame);
+    config.edge                 = (config.enabled ? (CNActivationEdge)self.toggleEdge : CNActivationEdgeTop);
+    config.region               = (self.toggleActivation == CNToggleActivationHotCorner ? CNActivationRegionCorners : CNActivationRegionEdge);
+    config.triggerDistance      = kCNToggleActivationTriggerDistance;
+    config.releaseDistance      = kCNToggleActivationReleaseDistance;
+    config.cornerSize           = kCNToggleActivationCornerSize;
+    config.dwellTime            = self.toggleActivationDwellTime;
+    config.prepareTime          = self.toggleActivationDwellTime * kCNToggleActivationPrepareRatio;
+    config.velocityThreshold    = self.toggleActivationVelocityThreshold;
+    CNEdgeActivationDetectorSetConfig(&_activationDetector, config);
+
+    [self discardSpeculativeSnapshot];
+    [self scheduleToggleActivationTimer];
+}
+
+- (void)toggleActivationPointerMoved:(NSEvent *)theEvent
+{
+    if (_toggleState == CNToggleStateExpanded || _toggleAnimationIsRunning)
+        return;
+
+    NSPoint location = [NSEvent mouseLocation];
+    [self performToggleActivationEvent:CNEdgeActivationDetectorPointerMoved(&_activationDetector, location.x, location.y, [theEvent timestamp])];
+}
+
+- (void)performToggleActivationEvent:(CNEdgeActivationEvent)activationEvent
+{
+    switch (activationEvent) {
+        case CNEdgeActivationEventNone:
+        case CNEdgeActivationEventArmed:
+            break;
+
+        /// the snapshot is only taken for a pointer that stays, not for every one that grazes the edge
+        case CNEdgeActivationEventPrepare:
+            if ([self canUseLightweightOverlay])
+                break;
+            [self captureSpeculativeSnapshot];
+            break;
+
+        case CNEdgeActivationEventDisarmed:
+            [self discardSpeculativeSnapshot];
+            break;
+
+        case CNEdgeActivationEventActivate:
+            if (self.applicationViewController != nil && _toggleState == CNToggleStateCollapsed) {
+                [self expand];
+            }
+            break;
+    }
+    [self scheduleToggleActivationTimer];
+}
+
+- (void)scheduleToggleActivationTimer
+{
+    /// there is at most one timer, and only while the pointer is dwelling on the edge
+    double deadline = CNEdgeActivationDetectorDeadline(&_activationDetector);
+    if (deadline == _activationTimerDeadline)
+        return;
+
+    NSUInteger timerGeneration = ++_activationTimerGeneration;
+    _activationTimerDeadline = deadline;
+    if (deadline < 0)
+        return;
+
+    /// NSEvent timestamps and the system uptime share the same time base
+    int64_t delay = (int64_t)(MAX(deadline - [[NSProcessInfo processInfo] systemUptime], 0) * NSEC_PER_SEC);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, delay), dispatch_get_main_queue(), ^{
+        if (timerGeneration == _activationTimerGeneration) {
+            _activationTimerDeadline = -1;
+            if (_toggleState == CNToggleStateCollapsed && !_toggleAnimationIsRunning) {
+                [self performToggleActivationEvent:CNEdgeActivationDetectorTick(&_activationDetector, [[NSProcessInfo processInfo] systemUptime])];
+            }
+        }
+    });
+}
+
+- (void)captureSpeculativeSnapshot
+{
+    [self discardSpeculativeSnapshot];
+
+    /// the lightweight overlay doesn't show the screen snapshot at all
+    if (_toggleState == CNToggleStateCollapsed && ![self canUseLightweightOverlay]) {
+        _speculativeSnapshot = [self snapshotOfDisplayWithID:[self displayIDForCurrentToggleDisplay:self.toggleDisplay]];
+    }
+}
+
+- (void)discardSpeculativeSnapshot
+{
+    if (_speculativeSnapshot != NULL) {
+        CGImageRelease(_speculativeSnapshot);
+        _speculativeSnapshot = NULL;
+    }
+}
+
+- (void)startLiveCoverRefresh
+{
+    if (!self.shouldUseLiveCovers || _toggleState != CNToggleStateExpanded || _lightweightOverlayIsActive)
+        return;
+
+    _liveCoverGeneration++;
+    [self scheduleLiveCoverRefresh];
+}
+
+- (void)stopLiveCoverRefresh
+{
+    _liveCoverGeneration++;
+    for (NSMutableDictionary *tileLayers in _liveCoverTileLayers) {
+        [[tileLayers allValues] makeObjectsPerformSelector:@selector(removeFromSuperlayer)];
+        [tileLayers removeAllObjects];
+    }
+
+    /// the grids are only touched on the live cover queue, a running capture finishes first
+    dispatch_async(_liveCoverQueue, ^{
+        CNTileGridFree(&_liveCoverGrids[0]);
+        CNTileGridFree(&_liveCoverGrids[1]);
+    });
+}
+
+- (void)scheduleLiveCoverRefresh
+{
+    NSUInteger refreshGeneration = _liveCoverGeneration;
+    int64_t delay = (int64_t)(MAX(self.liveCoverRefreshInterval, kCNLiveCoverMinimumRefreshInterval) * NSEC_PER_SEC);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, delay), dispatch_get_main_queue(), ^{
+        if (refreshGeneration == _liveCoverGeneration) {
+            [self refreshLiveCovers];
+        }
+    });
+}
+
+- (void)refreshLiveCovers
+{
+    /// the covers are moving, the next refresh catches up
+    if (_applicationCoverIsDragging || _toggleAnimationIsRunning) {
+        [self scheduleLiveCoverRefresh];
+        return;
+    }
+
+    NSRect windowFrame = [[self window] frame];
+    NSRect contentViewBounds = [[[self window] contentView] bounds];
+    CGFloat primaryScreenHeight = NSHeight([[[NSScreen screens] objectAtIndex:0] frame]);
+    CGWindowID windowID = (CGWindowID)[[self window] windowNumber];
+
+    /// each cover shows the screen content that was below its collapsed position at the time of the snapshot
+    CNLayoutFrames collapsedFrames;
+    CNLayoutCollapsedFrames((CNLayoutEdge)self.toggleEdge, (CNLayoutAnimation)[self effectiveToggleAnimationEffect],
+                            NSWidth(windowFrame), NSHeight(windowFrame), [self thicknessOfApplicationViewForFrame:windowFrame], &collapsedFrames);
+    NSArray *coverViews = (collapsedFrames.hasSecondCover ? @[_applicationFirstCoverView, _applicationSecondCoverView] : @[_applicationFirstCoverView]);
+    NSArray *sourceFrames = @[[NSValue valueWithRect:NSRectFromLayoutRect(collapsedFrames.firstCoverFrame)],
+                              [NSValue valueWithRect:NSRectFromLayoutRect(collapsedFrames.secondCoverFrame)]];
+
+    NSMutableArray *visibleRects = [NSMutableArray array];
+    NSMutableArray *captureRects = [NSMutableArray array];
+    for (NSUInteger coverIndex = 0; coverIndex < [coverViews count]; coverIndex++) {
+        NSRect coverFrame = [[coverViews objectAtIndex:coverIndex] frame];
+        NSRect sourceFrame = [[sourceFrames objectAtIndex:coverIndex] rectValue];
+
+        /// only the part of the cover that isn't pushed out of the window is captured
+        NSRect visibleFrame = NSIntersectionRect(coverFrame, contentViewBounds);
+        if ([self supportsPanels]) {
+            visibleFrame = NSIntersectionRect(visibleFrame, NSRectFromLayoutRect(_remainingFrame));
+        }
+        NSRect visibleRect = NSIntegralRect(NSOffsetRect(visibleFrame, -NSMinX(coverFrame), -NSMinY(coverFrame)));
+        NSRect sourceRect = NSOffsetRect(visibleRect, NSMinX(windowFrame) + NSMinX(sourceFrame), NSMinY(windowFrame) + NSMinY(sourceFrame));
+        [visibleRects addObject:[NSValue valueWithRect:visibleRect]];
+        [captureRects addObject:[NSValue valueWithRect:NSMakeRect(NSMinX(sourceRect), primaryScreenHeight - NSMaxY(sourceRect), NSWidth(sourceRect), NSHeight(sourceRect))]];
+    }
+
+    NSUInteger refreshGeneration = _liveCoverGeneration;
+    dispatch_async(_liveCoverQueue, ^{
+        NSMutableArray *changedTiles = [NSMutableArray array];
+        for (NSUInteger coverIndex = 0; coverIndex < [coverViews count]; coverIndex++) {
+            NSArray *tiles = [self changedTilesOfLiveCoverAtIndex:coverIndex
+                                                      captureRect:NSRectToCGRect([[captureRects objectAtIndex:coverIndex] rectValue])
+                                                      visibleRect:[[visibleRects objectAtIndex:coverIndex] rectValue]
+                                                         windowID:windowID];
+            [changedTiles addObject:(tiles != nil ? tiles : @[])];
+        }
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (refreshGeneration != _liveCoverGeneration)
+                return;
+
+            for (NSUInteger coverIndex = 0; coverIndex < [coverViews count]; coverIndex++) {
+                [self applyLiveCoverTiles:[changedTiles objectAtIndex:coverIndex]
+                              toCoverView:[coverViews objectAtIndex:coverIndex]
+                               tileLayers:[_liveCoverTileLayers objectAtIndex:coverIndex]];
+            }
+            [self scheduleLiveCoverRefresh];
+        });
+    });
+}
+
+- (NSArray *)changedTilesOfLiveCoverAtIndex:(NSUInteger)coverIndex captureRect:(CGRect)captureRect visibleRect:(NSRect)visibleRect windowID:(CGWindowID)windowID
+{
+    /// everything below the backstage window, which is what the cover pretends to show
+    CGImageRef captureRef = CGWindowListCreateImage(captureRect, kCGWindowListOptionOnScreenBelowWindow, windowID, kCGWindowImageDefault);
+    if (captureRef == NULL)
+        return nil;
+
+    if (CGImageGetBitsPerPixel(captureRef) != 32) {
+        CGImageRelease(captureRef);
+        return nil;
+    }
+
+    CNTileGrid *grid = &_liveCoverGrids[coverIndex];
+    int width = (int)CGImageGetWidth(captureRef);
+    int height = (int)CGImageGetHeight(captureRef);
+    if (grid->width != width || grid->height != height) {
+        CNTileGridFree(grid);
+        CNTileGridInit(grid, width, height, kCNLiveCoverTileSize);
+    }
+
+    CFDataRef pixelData = CGDataProviderCopyData(CGImageGetDataProvider(captureRef));
+    int *changedTileIndexes = malloc(sizeof(int) * (size_t)MAX(CNTileGridTileCount(grid), 1));
+    int changedCount = CNTileGridUpdate(grid, CFDataGetBytePtr(pixelData), CGImageGetBytesPerRow(captureRef), changedTileIndexes);
+    CFRelease(pixelData);
+
+    /// tile rects are in pixels with rows top down, the layer frames in points of the cover view
+    CGFloat scaleX = NSWidth(visibleRect) / width;
+    CGFloat scaleY = NSHeight(visibleRect) / height;
+    NSMutableArray *tiles = [NSMutableArray arrayWithCapacity:changedCount];
+
+    if (changedCount > 0 && changedCount == CNTileGridTileCount(grid)) {
+        /// a single upload of the whole region is cheaper than one per tile
+        [tiles addObject:@[@(-1), [NSValue valueWithRect:visibleRect], (__bridge id)captureRef]];
+
+    } else {
+        for (int i = 0; i < changedCount; i++) {
+            int x, y, tileWidth, tileHeight;
+            CNTileGridTileRect(grid, changedTileIndexes[i], &x, &y, &tileWidth, &tileHeight);
+
+            CGImageRef tileRef = CGImageCreateWithImageInRect(captureRef, CGRectMake(x, y, tileWidth, tileHeight));
+            NSRect tileFrame = NSMakeRect(NSMinX(visibleRect) + x * scaleX, NSMinY(visibleRect) + (height - y - tileHeight) * scaleY,
+                                          tileWidth * scaleX, tileHeight * scaleY);
+            [tiles addObject:@[@(changedTileIndexes[i]), [NSValue valueWithRect:tileFrame], (__bridge id)tileRef]];
+            CGImageRelease(tileRef);
+        }
+    }
+    free(changedTileIndexes);
+    CGImageRelease(captureRef);
+    return tiles;
+}
+
+- (void)applyLiveCoverTiles:(NSArray *)tiles toCoverView:(NSView *)coverView tileLayers:(NSMutableDictionary *)tileLayers
+{
+    if ([tiles count] == 0)
+        return;
+
+    /// the tiles replace the snapshot, so they belong below the black overlay of the cover
+    NSView *overlayView = (coverView == _applicationFirstCoverView ? _applicationFirstCoverOverlayView : _applicationSecondCoverOverlayView);
+    CALayer *overlayLayer = ([overlayView superview] == coverView ? overlayView.layer : nil);
+
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    for (NSArray *tile in tiles) {
+        NSNumber *tileIndex = [tile objectAtIndex:0];
+
+        /// a capture of the whole region replaces all tiles of the previous refreshes
+        if ([tileIndex integerValue] < 0) {
+            [[tileLayers allValues] makeObjectsPerformSelector:@selector(removeFromSuperlayer)];
+            [tileLayers removeAllObjects];
+        }
+
+        CALayer *tileLayer = [tileLayers objectForKey:tileIndex];
+        if (tileLayer == nil) {
+            tileLayer = [CALayer layer];
+            if (overlayLayer != nil) {
+                [coverView.layer insertSublayer:tileLayer below:overlayLayer];
+            } else {
+                [coverView.layer addSublayer:tileLayer];
+            }
+            [tileLayers setObject:tileLayer forKey:tileIndex];
+        }
+        tileLayer.frame = NSRectToCGRect([[tile objectAtIndex:1] rectValue]);
+        tileLayer.contents = [tile objectAtIndex:2];
+    }
+    [CATransaction commit];
+}
+
+- (BOOL)supportsPanels
+{
+    /// the split edges push the covers apart, there is no free edge for additional panels
+    return (self.toggleEdge <= CNToggleEdgeRight);
+}
+
+- (CGFloat)thicknessOfPanelOnToggleEdge:(CNToggleEdge)aToggleEdge forFrame:(NSRect)aFrame
+{
+    BOOL isHorizontal = CNLayoutEdgeIsHorizontal((CNLayoutEdge)aToggleEdge);
+    NSInteger size = (isHorizontal ? _panelToggleSizes[aToggleEdge].width : _panelToggleSizes[aToggleEdge].height);
+    CGFloat frameSize = (isHorizontal ? NSWidth(aFrame) : NSHeight(aFrame));
+
+    switch (size) {
+        case CNToggleSizeHalfScreen:
+        case CNToggleSizeQuarterScreen:
+        case CNToggleSizeThreeQuarterScreen:
+        case CNToggleSizeOneThirdScreen:
+        case CNToggleSizeTwoThirdsScreen:
+            return ceil([self valueForToggleSize:size frameSize:frameSize]);
+        default:
+            return MIN(size, frameSize);
+    }
+}
+
+- (void)updatePanelLayout
+{
+    NSRect windowFrame = [[self window] frame];
+    memset(&_layoutPanels, 0, sizeof(CNLayoutPanels));
+
+    if ([self supportsPanels]) {
+        for (NSNumber *panelEdge in _panelViewControllers) {
+            CNToggleEdge toggleEdge = [panelEdge intValue];
+            _layoutPanels.thickness[toggleEdge] = [self thicknessOfPanelOnToggleEdge:toggleEdge forFrame:windowFrame];
+        }
+
+        /// the main panel always wins its edge, its current size may differ from toggleSize while it is dragged
+        NSRect applicationFrame = [_applicationView frame];
+        _layoutPanels.thickness[self.toggleEdge] = (CNLayoutEdgeIsHorizontal((CNLayoutEdge)self.toggleEdge) ? NSWidth(applicationFrame) : NSHeight(applicationFrame));
+    }
+    CNLayoutPanelFrames((CNLayoutEdge)self.toggleEdge, &_layoutPanels, NSWidth(windowFrame), NSHeight(windowFrame), _panelFrames, &_remainingFrame);
+}
+
+- (NSRect)frameOfPanelOnToggleEdge:(CNToggleEdge)aToggleEdge expanded:(BOOL)expanded
+{
+    CNLayoutRect panelFrame = _panelFrames[aToggleEdge];
+    if (!expanded) {
+        panelFrame = CNLayoutCollapsedPanelFrame((CNLayoutEdge)aToggleEdge, (CNLayoutAnimation)[self effectiveToggleAnimationEffect], panelFrame);
+    }
+    return NSRectFromLayoutRect(panelFrame);
+}
+
+- (void)buildPanelHierarchy
+{
+    [self updatePanelLayout];
+    if (![self supportsPanels])
+        return;
+
+    __weak NSView *controllerWindowContentView = [[self window] contentView];
+    for (NSNumber *panelEdge in _panelViewControllers) {
+        CNToggleEdge toggleEdge = [panelEdge intValue];
+        if (toggleEdge == self.toggleEdge || [_panelShadowViews objectForKey:panelEdge] != nil)
+            continue;
+
+        /// the panels lie above the covers, so they share the snapshot and the visual effects of the main panel
+        NSView *panelView = [[_panelViewControllers objectForKey:panelEdge] view];
+        panelView.frame = [self frameOfPanelOnToggleEdge:toggleEdge expanded:NO];
+        panelView.alphaValue = ([self effectiveToggleAnimationEffect] == CNToggleAnimationEffectFade ? 0.0 : 1.0);
+        [controllerWindowContentView addSubview:panelView];
+
+        CNBackstageShadowView *panelShadowView = [[CNBackstageShadowView alloc] initWithFrame:[panelView bounds]];
+        panelShadowView.toggleEdge = toggleEdge;
+        panelShadowView.shouldUseShadows = [self effectiveShadowUsage];
+        panelShadowView.shadowIntensity = self.shadowIntensity;
+        [panelShadowView setAutoresizingMask:NSViewWidthSizable | NSViewHeightSizable];
+        [panelView addSubview:panelShadowView];
+        [_panelShadowViews setObject:panelShadowView forKey:panelEdge];
+    }
+}
+
+- (void)layoutPanelViewsExpanded:(BOOL)expanded animated:(BOOL)animated
+{
+    [self updatePanelLayout];
+
+    for (NSNumber *panelEdge in _panelShadowViews) {
+        CNToggleEdge toggleEdge = [panelEdge intValue];
+        NSView *panelView = [[_panelViewControllers objectForKey:panelEdge] view];
+        id target = (animated ? [panelView animator] : panelView);
+
+        if ([self effectiveToggleAnimationEffect] == CNToggleAnimationEffectFade) {
+            [target setAlphaValue:(expanded ? 1.0 : 0.0)];
+        }
+        [target setFrame:[self frameOfPanelOnToggleEdge:toggleEdge expanded:expanded]];
+    }
+}
+
+- (void)removePanelViewOnToggleEdge:(CNToggleEdge)aToggleEdge
+{
+    CNBackstageShadowView *panelShadowView = [_panelShadowViews objectForKey:@(aToggleEdge)];
+    if (panelShadowView == nil)
+        return;
+
+    NSView *panelView = [[_panelViewControllers objectForKey:@(aToggleEdge)] view];
+    [panelShadowView removeFromSuperview];
+    [panelView removeFromSuperview];
+    panelView.alphaValue = 1.0;
+    [_panelShadowViews removeObjectForKey:@(aToggleEdge)];
+}
+
+- (BOOL)isPanelAtPoint:(NSPoint)aPoint
+{
+    return (CNLayoutPanelAtPoint(&_layoutPanels, _panelFrames, aPoint.x, aPoint.y) >= 0);
+}
+
+- (int)thicknessOfSystemStatusBarForCurrentToggleDisplay
+{
+    return ([self displayIDForCurrentToggleDisplay:self.toggleDisplay] == CGMainDisplayID() ? [[NSStatusBar systemStatusBar] thickness] : 0);
+}
+
+- (float)valueForToggleSize:(NSInteger)aToggleSize frameSize:(CGFloat)aSize
+{
+    float value = 0;
+    switch (aToggleSize) {
+        case CNToggleSizeHalfScreen:         value = aSize /  -2.00 * -1;      break;
+        case CNToggleSizeQuarterScreen:      value = aSize /  -4.00 * -1;      break;
+        case CNToggleSizeThreeQuarterScreen: value = (aSize / -4.00 * -1) * 3; break;
+        case CNToggleSizeOneThirdScreen:     value = aSize /  -3.00 * -1;      break;
+        case CNToggleSizeTwoThirdsScreen:    value = aSize /  -1.50 * -1;      break;
+    }
+    return value;
+}
+
+- (void)restorePresentationOptions
+{
+    /// the dock may stay hidden for `dockRestoreDelay` seconds, a quick re-expand doesn't touch it at all then
+    [self performDockPolicyAction:CNDockPolicyDidCollapse(&_dockPolicy, CACurrentMediaTime())];
+    [self scheduleDockRestore];
+}
+
+- (void)configurePresentationOptions
+{
+    [self showWindow:nil];
+    _dockRestoreGeneration++;
+    [self performDockPolicyAction:CNDockPolicyWillExpand(&_dockPolicy, [self dockOverlapsApplicationView])];
+}
+
+- (BOOL)dockOverlapsApplicationView
+{
+    CGDirectDisplayID displayID = [self displayIDForCurrentToggleDisplay:self.toggleDisplay];
+    NSRect dockFrame = [[self screenForDisplayWithID:displayID] dockFrame];
+    if (!NSIsEmptyRect(dockFrame)) {
+        [_dockFrames setObject:[NSValue valueWithRect:dockFrame] forKey:@(displayID)];
+    }
+    else if (_dockPolicy.dockIsHidden) {
+        /// a dock we have hidden ourselves is missing in the visible frame, so its last known frame has to stand in for it
+        NSValue *lastDockFrame = [_dockFrames objectForKey:@(displayID)];
+        if (lastDockFrame == nil)
+            return YES;
+        dockFrame = [lastDockFrame rectValue];
+    }
+    else {
+        return NO;
+    }
+
+    NSRect windowFrame = [[self window] frame];
+    CNLayoutRect dockRect = CNLayoutRectMake(NSMinX(dockFrame) - NSMinX(windowFrame), NSMinY(dockFrame) - NSMinY(windowFrame), NSWidth(dockFrame), NSHeight(dockFrame));
+
+    /// the applicationView and the panels matter on their whole way in and out, not only in their expanded place
+    CNLayoutFrames collapsedFrames, expandedFrames;
+    CGFloat thickness = [self thicknessOfApplicationViewForFrame:windowFrame];
+    CNLayoutCollapsedFrames((CNLayoutEdge)self.toggleEdge, (CNLayoutAnimation)[self effectiveToggleAnimationEffect],
+                            NSWidth(windowFrame), NSHeight(windowFrame), thickness, &collapsedFrames);
+    CNLayoutExpandedFrames((CNLayoutEdge)self.toggleEdge, (CNLayoutAnimation)[self effectiveToggleAnimationEffect],
+                           NSWidth(windowFrame), NSHeight(windowFrame), thickness, &expandedFrames);
+
+    CNLayoutRect coveredRects[5];
+    int coveredRectCount = 0;
+    coveredRects[coveredRectCount++] = CNLayoutRectUnion(collapsedFrames.applicationFrame, expandedFrames.applicationFrame);
+    for (NSNumber *panelEdge in [_panelViewControllers allKeys]) {
+        if (coveredRectCount == 5)
+            break;
+        NSRect panelFrame = NSUnionRect([self frameOfPanelOnToggleEdge:[panelEdge intValue] expanded:NO],
+                                        [self frameOfPanelOnToggleEdge:[panelEdge intValue] expanded:YES]);
+        coveredRects[coveredRectCount++] = CNLayoutRectMake(NSMinX(panelFrame), NSMinY(panelFrame), NSWidth(panelFrame), NSHeight(panelFrame));
+    }
+    return CNDockRectIntersectsRects(dockRect, coveredRects, coveredRectCount);
+}
+
+- (void)performDockPolicyAction:(CNDockPolicyAction)dockPolicyAction
+{
+    switch (dockPolicyAction) {
+        case CNDockPolicyActionNone:
+            break;
+
+        case CNDockPolicyActionHide:
+            _presentationOptionsBackup = [NSApp currentSystemPresentationOptions];
+            [NSApp setPresentationOptions:NSApplicationPresentationHideDock | NSApplicationPresentationDisableProcessSwitching | NSApplicationPresentationDisableAppleMenu | NSApplicationPresentationDisableHideApplication];
+            break;
+
+        case CNDockPolicyActionRestore:
+            [NSApp setPresentationOptions:_presentationOptionsBackup];
+            break;
+    }
+}
+
+- (void)scheduleDockRestore
+{
+    NSUInteger timerGeneration = ++_dockRestoreGeneration;
+    double deadline = CNDockPolicyNextDeadline(&_dockPolicy);
+    if (deadline < 0)
+        return;
+
+    /// an expand in between invalidates the timer
+    int64_t delay = (int64_t)(MAX(deadline - CACurrentMediaTime(), 0) * NSEC_PER_SEC);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, delay), dispatch_get_main_queue(), ^{
+        if (timerGeneration == _dockRestoreGeneration) {
+            [self performDockPolicyAction:CNDockPolicyTick(&_dockPolicy, CACurrentMediaTime())];
+        }
+    });
+}
+
+- (CGImageRef)snapshotOfDisplayWithID:(CGDirectDisplayID)displayID
+{
+    return CGDisplayCreateImageForRect(displayID, CGRectMake(0, 0 + [self thicknessOfSystemStatusBarForCurrentToggleDisplay],
+                                                             NSWidth(self.currentToggleDisplayFrame),
+                                                             NSHeight(self.currentToggleDisplayFrame) - [self thicknessOfSystemStatusBarForCurrentToggleDisplay]));
+}
+
+- (CGDirectDisplayID)displayIDForCurrentToggleDisplay:(CNToggleDisplay)aToggleDisplay
+{
+    uint32_t MAX_TOGGLE_DISPLAYS = kCNMaxNumberOfSupportedDisplays;   // number of supported displays
+    uint32_t displayCount;
+    CGDirectDisplayID toggleDisplays[MAX_TOGGLE_DISPLAYS];
+    CGGetOnlineDisplayList(MAX_TOGGLE_DISPLAYS, toggleDisplays, &displayCount);
 
-    return (aToggleDisplay > displayCount ? toggleDisplays[0]: toggleDisplays[aToggleDisplay]);
+    return (aToggleDisplay >= displayCount ? toggleDisplays[0]: toggleDisplays[aToggleDisplay]);
 }
 
 - (NSScreen*)screenForDisplayWithID:(CGDirectDisplayID)displayID
@@ -926,6 +2393,9 @@
             break;
         }
     }
+
+    /// the panels on the other axis follow the size of the main panel
+    [self layoutPanelViewsExpanded:YES animated:NO];
 }
 
 
@@ -935,9 +2405,17 @@
 
 - (void)mouseDragged:(NSEvent *)theEvent
 {
+    /// unhandled drags inside a panel must not resize the main panel
+    if (_applicationCoverIsDragging == NO && [self isPanelAtPoint:[theEvent locationInWindow]])
+        return;
+    /// the lightweight overlay has no covers to drag
+    if (_lightweightOverlayIsActive)
+        return;
+
     if (_applicationCoverIsDragging == NO) {
         /// inform the delegate
         [self backstageController:self willDragOnScreen:[self screenOfCurrentToggleDisplay] toggleEdge:self.toggleEdge];
+        [self beginQualitySession];
     }
     [self dragCoverageUsingAnchorPoint:[theEvent locationInWindow]];
 }
@@ -950,12 +2428,17 @@
 {
     if (!NSPointInRect([theEvent locationInWindow], [_applicationView frame])) {
         if (_applicationCoverIsDragging == NO) {
-            [self collapse];
+            if (![self isPanelAtPoint:[theEvent locationInWindow]]) {
+                [self collapse];
+            }
         } else {
             _applicationCoverIsDragging = NO;
             _applicationFirstCoverView.frame = _applicationFirstCoverView.layer.frame;
             _applicationSecondCoverView.frame = _applicationSecondCoverView.layer.frame;
 
+            [self endQualitySession];
+            [self recordDraggedToggleSize];
+
             /// inform the delegate
             [self backstageController:self didDragOnScreen:[self screenOfCurrentToggleDisplay] toggleEdge:self.toggleEdge];
         }
@@ -964,14 +2447,14 @@
 
 - (void)rightMouseDown:(NSEvent *)theEvent
 {
-    if (!NSPointInRect([theEvent locationInWindow], [_applicationView frame])) {
+    if (!NSPointInRect([theEvent locationInWindow], [_applicationView frame]) && ![self isPanelAtPoint:[theEvent locationInWindow]]) {
         [self collapse];
     }
 }
 
 - (void)otherMouseDown:(NSEvent *)theEvent
 {
-    if (!NSPointInRect([theEvent locationInWindow], [_applicationView frame])) {
+    if (!NSPointInRect([theEvent locationInWindow], [_applicationView frame]) && ![self isPanelAtPoint:[theEvent locationInWindow]]) {
         [self collapse];
     }
 }
@@ -988,6 +2471,18 @@
     }
 }
 
+- (void)applicationWillTerminate:(NSNotification *)notification
+{
+    /// write pending changes and wait for the background queue, the process is about to end
+    [self saveState];
+    dispatch_sync(_stateQueue, ^{});
+}
+
+- (void)screenParametersDidChange:(NSNotification *)notification
+{
+    [self updateToggleActivationConfiguration];
+}
+
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1071,6 +2566,62 @@
     }
 }
 
+- (void)backstageController:(CNBackstageController *)backstageController willHibernateOnScreen:(NSScreen *)toggleScreen toggleEdge:(CNToggleEdge)toggleEdge
+{
+    [_nc postNotificationName:CNBackstageControllerWillHibernateOnScreenNotification
+                       object:backstageController
+                     userInfo:[NSDictionary dictionaryWithObjectsAndKeys:
+                               toggleScreen, CNToggleScreenUserInfoKey,
+                               [NSNumber numberWithInteger:toggleEdge], CNToggleEdgeUserInfoKey,
+                               nil]];
+    if ([self.delegate respondsToSelector:_cmd]) {
+        [self.delegate backstageController:backstageController willHibernateOnScreen:toggleScreen toggleEdge:toggleEdge];
+    }
+}
+
+- (void)backstageController:(CNBackstageController *)backstageController willWakeUpOnScreen:(NSScreen *)toggleScreen toggleEdge:(CNToggleEdge)toggleEdge
+{
+    [_nc postNotificationName:CNBackstageControllerWillWakeUpOnScreenNotification
+                       object:backstageController
+                     userInfo:[NSDictionary dictionaryWithObjectsAndKeys:
+                               toggleScreen, CNToggleScreenUserInfoKey,
+                               [NSNumber numberWithInteger:toggleEdge], CNToggleEdgeUserInfoKey,
+                               nil]];
+    if ([self.delegate respondsToSelector:_cmd]) {
+        [self.delegate backstageController:backstageController willWakeUpOnScreen:toggleScreen toggleEdge:toggleEdge];
+    }
+}
+
+- (void)backstageController:(CNBackstageController *)backstageController didChangeQuality:(CNToggleQuality)quality onScreen:(NSScreen *)toggleScreen toggleEdge:(CNToggleEdge)toggleEdge
+{
+    [_nc postNotificationName:CNBackstageControllerDidChangeQualityNotification
+                       object:backstageController
+                     userInfo:[NSDictionary dictionaryWithObjectsAndKeys:
+                               toggleScreen, CNToggleScreenUserInfoKey,
+                               [NSNumber numberWithInteger:toggleEdge], CNToggleEdgeUserInfoKey,
+                               [NSNumber numberWithInteger:quality], CNToggleQualityUserInfoKey,
+                               nil]];
+    if ([self.delegate respondsToSelector:_cmd]) {
+        [self.delegate backstageController:backstageController didChangeQuality:quality onScreen:toggleScreen toggleEdge:toggleEdge];
+    }
+}
+
+- (void)backstageController:(CNBackstageController *)backstageController didCaptureSnapshot:(CNSnapshotBuffer *)snapshot onScreen:(NSScreen *)toggleScreen toggleEdge:(CNToggleEdge)toggleEdge
+{
+    [_nc postNotificationName:CNBackstageControllerDidCaptureSnapshotNotification
+                       object:backstageController
+                     userInfo:[NSDictionary dictionaryWithObjectsAndKeys:
+                               toggleScreen, CNToggleScreenUserInfoKey,
+                               [NSNumber numberWithInteger:toggleEdge], CNToggleEdgeUserInfoKey,
+                               [NSNumber numberWithUnsignedInteger:_currentSnapshotGeneration], CNSnapshotGenerationUserInfoKey,
+                               [NSNumber numberWithUnsignedInteger:CGImageGetWidth(_currentSnapshot)], CNSnapshotWidthUserInfoKey,
+                               [NSNumber numberWithUnsignedInteger:CGImageGetHeight(_currentSnapshot)], CNSnapshotHeightUserInfoKey,
+                               nil]];
+    if ([self.delegate respondsToSelector:_cmd]) {
+        [self.delegate backstageController:backstageController didCaptureSnapshot:snapshot onScreen:toggleScreen toggleEdge:toggleEdge];
+    }
+}
+
 
 @end
 
@@ -1082,6 +2633,9 @@
 
 const CGFloat kCNAnimationDuration = 0.42;
 const uint32_t kCNMaxNumberOfSupportedDisplays = 16;
+const NSTimeInterval kCNDefaultHibernationInterval = 180.0;
+const NSTimeInterval kCNDefaultLiveCoverRefreshInterval = 0.25;
+const NSTimeInterval kCNDefaultSnapshotReuseInterval = 0.0;
 
 /// NSUserDefaults keys
 NSString *CNToggleEdgePreferencesKey = @"CNToggleEdge";
@@ -1093,6 +2647,7 @@ NSString *CNToggleVisualEffectPreferencesKey = @"CNToggleVisualEffect";
 NSString *CNToggleAnimationEffectPreferencesKey = @"CNToggleAnimationEffect";
 NSString *CNToggleAlphaValuePreferencesKey = @"CNToggleAlphaValue";
 NSString *CNToggleUseShadowsPreferencesKey = @"CNToggleUseShadows";
+NSString *CNBackstageStatePreferencesKey = @"CNBackstageState";
 
 
 /// Notifications
@@ -1102,11 +2657,19 @@ NSString *CNBackstageControllerWillCollapseOnScreenNotification = @"CNBackstageC
 NSString *CNBackstageControllerDidCollapseOnScreenNotification = @"CNBackstageControllerDidCollapseOnScreen";
 NSString *CNBackstageControllerWillDragOnScreenNotification = @"CNBackstageControllerWillDragOnScreen";
 NSString *CNBackstageControllerDidDragOnScreenNotification = @"CNBackstageControllerDidDragOnScreen";
+NSString *CNBackstageControllerWillHibernateOnScreenNotification = @"CNBackstageControllerWillHibernateOnScreen";
+NSString *CNBackstageControllerWillWakeUpOnScreenNotification = @"CNBackstageControllerWillWakeUpOnScreen";
+NSString *CNBackstageControllerDidChangeQualityNotification = @"CNBackstageControllerDidChangeQuality";
+NSString *CNBackstageControllerDidCaptureSnapshotNotification = @"CNBackstageControllerDidCaptureSnapshot";
 
 
 /// Keys that are used for the userInfo dictionary in the notifications from above
 NSString *CNToggleScreenUserInfoKey = @"toggleScreen";
 NSString *CNToggleEdgeUserInfoKey = @"toggleEdge";
+NSString *CNToggleQualityUserInfoKey = @"quality";
+NSString *CNSnapshotGenerationUserInfoKey = @"snapshotGeneration";
+NSString *CNSnapshotWidthUserInfoKey = @"snapshotWidth";
+NSString *CNSnapshotHeightUserInfoKey = @"snapshotHeight";
 
 
 
@@ -37,6 +37,9 @@
 
 extern const uint32_t kCNMaxNumberOfSupportedDisplays;
 extern const CGFloat kCNAnimationDuration;
+extern const NSTimeInterval kCNDefaultHibernationInterval;
+extern const NSTimeInterval kCNDefaultLiveCoverRefreshInterval;
+extern const NSTimeInterval kCNDefaultSnapshotReuseInterval;
 
 typedef enum {
     CNToggleStateCollapsed = -1,                        // indictates that the current state of CNBackstageController is 'closed' (meaning: no applicationView is visible)
@@ -88,17 +91,33 @@ typedef struct {
     CGFloat deltaY;
 } CNToggleFrameDeltas;
 
+typedef enum {
+    CNToggleActivationManual = 0,                       // the applicationView appears only by calling `toggleViewState` or `expand`
+    CNToggleActivationScreenEdge,                       // the applicationView appears if the pointer rests on the toggle edge of the toggle display
+    CNToggleActivationHotCorner                         // the applicationView appears if the pointer rests in one of the two corners of the toggle edge
+} CNToggleActivation;
+
 typedef enum {
     CNShadowIntensityNormal = 0,
     CNShadowIntensityLighter,
     CNShadowIntensityDarker
 } CNShadowIntensity;
 
+typedef enum {
+    CNToggleQualityFull = 0,                            // all configured effects are used
+    CNToggleQualityReducedBlur,                         // the gaussian blur uses a smaller radius
+    CNToggleQualityNoBlur,                              // the gaussian blur is left out, a black overlay is still used
+    CNToggleQualityNoShadows,                           // additionally no shadows are drawn
+    CNToggleQualityFade,                                // additionally a slide animation is replaced by a fade animation
+    CNToggleQualityStatic                               // additionally the applicationView appears without any animation
+} CNToggleQuality;
+
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// NSUserDefaults keys
-/// These keys are used to save the enum values from above. CNBackstageController will handle the serialization of it automatically.
+/// These keys are used to save the enum values from above. CNBackstageController will handle the serialization of it automatically
+/// as soon as a `stateStore` is assigned. The whole state is kept in one versioned record, by default under `CNBackstageStatePreferencesKey`.
 extern NSString *CNToggleEdgePreferencesKey;
 extern NSString *CNToggleSizePreferencesKey;
 extern NSString *CNToggleSizeWidthPreferencesKey;
@@ -108,6 +127,7 @@ extern NSString *CNToggleVisualEffectPreferencesKey;
 extern NSString *CNToggleAnimationEffectPreferencesKey;
 extern NSString *CNToggleAlphaValuePreferencesKey;
 extern NSString *CNToggleUseShadowsPreferencesKey;
+extern NSString *CNBackstageStatePreferencesKey;
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -121,12 +141,20 @@ extern NSString *CNBackstageControllerWillCollapseOnScreenNotification;
 extern NSString *CNBackstageControllerDidCollapseOnScreenNotification;
 extern NSString *CNBackstageControllerWillDragOnScreenNotification;
 extern NSString *CNBackstageControllerDidDragOnScreenNotification;
+extern NSString *CNBackstageControllerWillHibernateOnScreenNotification;
+extern NSString *CNBackstageControllerWillWakeUpOnScreenNotification;
+extern NSString *CNBackstageControllerDidChangeQualityNotification;
+extern NSString *CNBackstageControllerDidCaptureSnapshotNotification;
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// Keys that are used for the userInfo dictionary in the notifications from above
 extern NSString *CNToggleScreenUserInfoKey;
 extern NSString *CNToggleEdgeUserInfoKey;
+extern NSString *CNToggleQualityUserInfoKey;                // only used by `CNBackstageControllerDidChangeQualityNotification`
+extern NSString *CNSnapshotGenerationUserInfoKey;           // only used by `CNBackstageControllerDidCaptureSnapshotNotification`
+extern NSString *CNSnapshotWidthUserInfoKey;                // only used by `CNBackstageControllerDidCaptureSnapshotNotification`, in pixels
+extern NSString *CNSnapshotHeightUserInfoKey;               // only used by `CNBackstageControllerDidCaptureSnapshotNotification`, in pixels
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
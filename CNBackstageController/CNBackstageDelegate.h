@@ -8,6 +8,7 @@
 
 #import <Foundation/Foundation.h>
 #import "CNBackstageDefinitions.h"
+#import "CNBackstageSnapshotBuffer.h"
 
 
 /**
@@ -63,4 +64,62 @@
  ...
  */
 - (void)backstageController:(CNBackstageController *)backstageController didDragOnScreen:(NSScreen *)toggleScreen toggleEdge:(CNToggleEdge)toggleEdge;
+
+/**
+ Informs the delegate that the controller has been collapsed for `hibernationInterval` seconds (or the system signaled memory pressure)
+ and is about to release its backstage resources.
+
+ This is the right place for the applicationViewController to release its own heavy content. The controller drops its reference
+ to the application view right after this call. A view loaded from a nib is released by the controller, any other view has to be
+ released here, e.g. by setting the `view` of the applicationViewController to `nil` and building it again in `loadView`.
+
+ This delegate also post a `CNBackstageControllerWillHibernateOnScreenNotification` notification to the `NSNotificationCenter`.
+
+ @param toggleScreen    The screen of the current toggle display.
+ @param toggleEdge      The current toggle edge.
+ */
+- (void)backstageController:(CNBackstageController *)backstageController willHibernateOnScreen:(NSScreen *)toggleScreen toggleEdge:(CNToggleEdge)toggleEdge;
+
+/**
+ Informs the delegate that the controller is about to rebuild its backstage resources, either on the first expand, on `prewarm`
+ or on the first expand after a hibernation.
+
+ The view of the applicationViewController is requested right after this call, so this is the right place to rebuild
+ content that was released in `backstageController:willHibernateOnScreen:toggleEdge:`.
+
+ This delegate also post a `CNBackstageControllerWillWakeUpOnScreenNotification` notification to the `NSNotificationCenter`.
+
+ @param toggleScreen    The screen of the current toggle display.
+ @param toggleEdge      The current toggle edge.
+ */
+- (void)backstageController:(CNBackstageController *)backstageController willWakeUpOnScreen:(NSScreen *)toggleScreen toggleEdge:(CNToggleEdge)toggleEdge;
+
+/**
+ Informs the delegate that the measured frame times made the controller change its quality level (see `shouldAdaptQuality`).
+
+ The new level is used from the next expand on. This delegate also post a `CNBackstageControllerDidChangeQualityNotification`
+ notification to the `NSNotificationCenter`. Additionally to the usual userInfo items it sends the new quality level wrapped in a
+ NSNumber object using the key `CNToggleQualityUserInfoKey`.
+
+ @param quality         The new quality level.
+ @param toggleScreen    The screen of the current toggle display.
+ @param toggleEdge      The current toggle edge.
+ */
+- (void)backstageController:(CNBackstageController *)backstageController didChangeQuality:(CNToggleQuality)quality onScreen:(NSScreen *)toggleScreen toggleEdge:(CNToggleEdge)toggleEdge;
+
+/**
+ Informs the delegate that the screen snapshot of an expand has been captured, before the applicationView appears.
+
+ The snapshot is passed as a read-only buffer of the pixels the controller shows in its covers. It is only valid for
+ the duration of this call, retain it with `CNSnapshotBufferRetain` to keep it and balance that with `CNSnapshotBufferRelease`.
+ `snapshot` is `NULL` if the display couldn't be captured. This delegate also post a `CNBackstageControllerDidCaptureSnapshotNotification`
+ notification to the `NSNotificationCenter`. Additionally to the usual userInfo items it sends the size of the snapshot in
+ pixels using the keys `CNSnapshotWidthUserInfoKey` and `CNSnapshotHeightUserInfoKey` and its generation using the key
+ `CNSnapshotGenerationUserInfoKey`, observers get the buffer by calling `copySnapshotBufferOfGeneration:` on the controller.
+
+ @param snapshot        The snapshot of the toggle display without the menu bar.
+ @param toggleScreen    The screen of the current toggle display.
+ @param toggleEdge      The edge the CNBackstageController's view will appear.
+ */
+- (void)backstageController:(CNBackstageController *)backstageController didCaptureSnapshot:(CNSnapshotBuffer *)snapshot onScreen:(NSScreen *)toggleScreen toggleEdge:(CNToggleEdge)toggleEdge;
 @end
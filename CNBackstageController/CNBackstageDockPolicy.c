@@ -0,0 +1,149 @@
+//
+//  CNBackstageDockPolicy.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include <math.h>
+#include "CNBackstageDockPolicy.h"
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Geometry
+
+CNLayoutRect CNDockRect(CNDockOrientation orientation, CNLayoutRect screenFrame, CNLayoutRect visibleFrame)
+{
+    double thickness = 0;
+    switch (orientation) {
+        case CNDockOrientationLeft:
+            thickness = visibleFrame.x - screenFrame.x;
+            return (thickness > 0 ? CNLayoutRectMake(0, 0, thickness, screenFrame.height) : CNLayoutRectMake(0, 0, 0, 0));
+
+        case CNDockOrientationRight:
+            thickness = (screenFrame.x + screenFrame.width) - (visibleFrame.x + visibleFrame.width);
+            return (thickness > 0 ? CNLayoutRectMake(screenFrame.width - thickness, 0, thickness, screenFrame.height) : CNLayoutRectMake(0, 0, 0, 0));
+
+        case CNDockOrientationBottom:
+            thickness = visibleFrame.y - screenFrame.y;
+            return (thickness > 0 ? CNLayoutRectMake(0, 0, screenFrame.width, thickness) : CNLayoutRectMake(0, 0, 0, 0));
+    }
+    return CNLayoutRectMake(0, 0, 0, 0);
+}
+
+CNLayoutRect CNDockRectWithWindowBounds(CNLayoutRect dockRect, CNLayoutRect windowBounds)
+{
+    double minX = fmax(dockRect.x, windowBounds.x);
+    double minY = fmax(dockRect.y, windowBounds.y);
+    double maxX = fmin(dockRect.x + dockRect.width, windowBounds.x + windowBounds.width);
+    double maxY = fmin(dockRect.y + dockRect.height, windowBounds.y + windowBounds.height);
+
+    if (windowBounds.width <= 0 || windowBounds.height <= 0 || maxX <= minX || maxY <= minY)
+        return dockRect;
+    return CNLayoutRectMake(minX, minY, maxX - minX, maxY - minY);
+}
+
+bool CNDockRectIntersectsRects(CNLayoutRect dockRect, const CNLayoutRect *rects, int count)
+{
+    if (dockRect.width <= 0 || dockRect.height <= 0)
+        return false;
+
+    for (int i = 0; i < count; i++) {
+        const CNLayoutRect *rect = &rects[i];
+        if (rect->width <= 0 || rect->height <= 0)
+            continue;
+
+        if (rect->x < dockRect.x + dockRect.width && dockRect.x < rect->x + rect->width &&
+            rect->y < dockRect.y + dockRect.height && dockRect.y < rect->y + rect->height)
+            return true;
+    }
+    return false;
+}
+
+CNLayoutRect CNLayoutRectUnion(CNLayoutRect rect1, CNLayoutRect rect2)
+{
+    double minX = fmin(rect1.x, rect2.x);
+    double minY = fmin(rect1.y, rect2.y);
+    double maxX = fmax(rect1.x + rect1.width, rect2.x + rect2.width);
+    double maxY = fmax(rect1.y + rect1.height, rect2.y + rect2.height);
+    return CNLayoutRectMake(minX, minY, maxX - minX, maxY - minY);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Policy
+
+void CNDockPolicyInit(CNDockPolicy *policy, double restoreDelay)
+{
+    policy->restoreDelay = restoreDelay;
+    policy->dockIsHidden = false;
+    policy->restoreDeadline = -1;
+}
+
+CNDockPolicyAction CNDockPolicyWillExpand(CNDockPolicy *policy, bool dockOverlapsPanel)
+{
+    policy->restoreDeadline = -1;
+
+    if (dockOverlapsPanel == policy->dockIsHidden)
+        return CNDockPolicyActionNone;
+
+    /// a dock that is still hidden from the last expand is given back if the new layout doesn't overlap it anymore
+    policy->dockIsHidden = dockOverlapsPanel;
+    return (dockOverlapsPanel ? CNDockPolicyActionHide : CNDockPolicyActionRestore);
+}
+
+CNDockPolicyAction CNDockPolicyDidCollapse(CNDockPolicy *policy, double now)
+{
+    if (!policy->dockIsHidden)
+        return CNDockPolicyActionNone;
+
+    if (policy->restoreDelay <= 0) {
+        policy->dockIsHidden = false;
+        return CNDockPolicyActionRestore;
+    }
+    policy->restoreDeadline = now + policy->restoreDelay;
+    return CNDockPolicyActionNone;
+}
+
+CNDockPolicyAction CNDockPolicyTick(CNDockPolicy *policy, double now)
+{
+    double deadline = CNDockPolicyNextDeadline(policy);
+    if (deadline < 0 || now < deadline)
+        return CNDockPolicyActionNone;
+
+    policy->dockIsHidden = false;
+    policy->restoreDeadline = -1;
+    return CNDockPolicyActionRestore;
+}
+
+double CNDockPolicyNextDeadline(const CNDockPolicy *policy)
+{
+    return (policy->dockIsHidden ? policy->restoreDeadline : -1);
+}
@@ -0,0 +1,92 @@
+//
+//  CNBackstageDockPolicy.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+
+#ifndef CNBackstageDockPolicy_h
+#define CNBackstageDockPolicy_h
+
+#include <stdbool.h>
+#include "CNBackstageLayout.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The dock policy decides when `CNBackstageController` hides the dock. The dock is only hidden if it overlaps the region
+/// the applicationView (or a panel) covers when expanded or on its way in and out, and it can stay hidden for a while
+/// after a collapse, so rapid toggles don't make the dock slide in and out every time. Like the idle policy it does not
+/// read any clock on its own.
+
+typedef enum {
+    CNDockOrientationLeft = 0,                          // same order as the "orientation" values of the dock preferences
+    CNDockOrientationRight,
+    CNDockOrientationBottom
+} CNDockOrientation;
+
+typedef enum {
+    CNDockPolicyActionNone = 0,                         // nothing to do
+    CNDockPolicyActionHide,                             // the presentation options that hide the dock have to be applied now
+    CNDockPolicyActionRestore                           // the previous presentation options have to be restored now
+} CNDockPolicyAction;
+
+typedef struct {
+    double restoreDelay;                                // seconds the dock stays hidden after a collapse, a value <= 0 restores it immediately
+    bool dockIsHidden;
+    double restoreDeadline;                             // a negative value if no restore is pending
+} CNDockPolicy;
+
+
+/// Returns the rect of the dock relative to the screen origin, computed from the orientation and the difference between the
+/// screen frame and its visible frame. The rect is empty if the dock isn't on this screen or hides itself automatically.
+extern CNLayoutRect CNDockRect(CNDockOrientation orientation, CNLayoutRect screenFrame, CNLayoutRect visibleFrame);
+
+/// The strip of `CNDockRect` spans the whole edge, the dock itself is usually shorter. Returns the part of the strip that is
+/// covered by the bounds of the dock window, or the whole strip if the bounds are unknown (empty) or don't touch it.
+extern CNLayoutRect CNDockRectWithWindowBounds(CNLayoutRect dockRect, CNLayoutRect windowBounds);
+
+/// Returns `true` if `dockRect` intersects one of the rects, touching edges don't count.
+extern bool CNDockRectIntersectsRects(CNLayoutRect dockRect, const CNLayoutRect *rects, int count);
+
+/// Returns the smallest rect containing both rects, e.g. the region a sliding view sweeps between two frames.
+extern CNLayoutRect CNLayoutRectUnion(CNLayoutRect rect1, CNLayoutRect rect2);
+
+extern void CNDockPolicyInit(CNDockPolicy *policy, double restoreDelay);
+
+/// Call these on the related state changes of the controller.
+extern CNDockPolicyAction CNDockPolicyWillExpand(CNDockPolicy *policy, bool dockOverlapsPanel);
+extern CNDockPolicyAction CNDockPolicyDidCollapse(CNDockPolicy *policy, double now);
+
+/// Call this when the deadline returned by `CNDockPolicyNextDeadline` has been reached.
+extern CNDockPolicyAction CNDockPolicyTick(CNDockPolicy *policy, double now);
+
+/// Returns the point in time the next `CNDockPolicyTick` call is due, or a negative value if no tick is needed.
+extern double CNDockPolicyNextDeadline(const CNDockPolicy *policy);
+
+#endif
@@ -0,0 +1,166 @@
+//
+//  CNBackstageEdgeActivation.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include <math.h>
+#include "CNBackstageEdgeActivation.h"
+
+
+static bool CNEdgeActivationContainsPoint(const CNEdgeActivationConfig *config, double x, double y)
+{
+    /// Cocoa reports the top row at the maximum y, the rightmost column is one less than the maximum x
+    return (x >= config->x && x < config->x + config->width && y >= config->y && y <= config->y + config->height);
+}
+
+/// distance to the configured edge and position along that edge, both relative to the display frame
+static void CNEdgeActivationMeasure(const CNEdgeActivationConfig *config, double x, double y, double *distance, double *position, double *length)
+{
+    switch (config->edge) {
+        case CNActivationEdgeTop:       *distance = config->y + config->height - y;     *position = x - config->x; *length = config->width; break;
+        case CNActivationEdgeBottom:    *distance = y - config->y;                      *position = x - config->x; *length = config->width; break;
+        case CNActivationEdgeLeft:      *distance = x - config->x;                      *position = y - config->y; *length = config->height; break;
+        case CNActivationEdgeRight:     *distance = config->x + config->width - 1 - x;  *position = y - config->y; *length = config->height; break;
+    }
+}
+
+static bool CNEdgeActivationIsInZone(const CNEdgeActivationConfig *config, double x, double y, double maxDistance, double cornerSize)
+{
+    if (!CNEdgeActivationContainsPoint(config, x, y))
+        return false;
+
+    double distance = 0, position = 0, length = 0;
+    CNEdgeActivationMeasure(config, x, y, &distance, &position, &length);
+    if (distance > maxDistance)
+        return false;
+
+    switch (config->region) {
+        case CNActivationRegionEdge:    return true;
+        case CNActivationRegionCorners: return (position < cornerSize || position >= length - cornerSize);
+    }
+    return false;
+}
+
+void CNEdgeActivationDetectorInit(CNEdgeActivationDetector *detector, CNEdgeActivationConfig config)
+{
+    detector->config = config;
+    CNEdgeActivationDetectorReset(detector);
+}
+
+void CNEdgeActivationDetectorSetConfig(CNEdgeActivationDetector *detector, CNEdgeActivationConfig config)
+{
+    CNEdgeActivationDetectorInit(detector, config);
+}
+
+void CNEdgeActivationDetectorReset(CNEdgeActivationDetector *detector)
+{
+    detector->state = CNEdgeActivationStateIdle;
+    detector->armedAt = 0;
+    detector->isPrepared = false;
+    detector->lastX = detector->lastY = detector->lastTime = 0;
+    detector->hasLastSample = false;
+}
+
+CNEdgeActivationEvent CNEdgeActivationDetectorPointerMoved(CNEdgeActivationDetector *detector, double x, double y, double time)
+{
+    const CNEdgeActivationConfig *config = &detector->config;
+    if (!config->enabled)
+        return CNEdgeActivationEventNone;
+
+    double velocity = 0;
+    if (detector->hasLastSample && time > detector->lastTime) {
+        velocity = hypot(x - detector->lastX, y - detector->lastY) / (time - detector->lastTime);
+    }
+    detector->lastX = x;
+    detector->lastY = y;
+    detector->lastTime = time;
+    detector->hasLastSample = true;
+
+    bool isFast = (config->velocityThreshold > 0 && velocity > config->velocityThreshold);
+
+    switch (detector->state) {
+        case CNEdgeActivationStateIdle: {
+            if (!isFast && CNEdgeActivationIsInZone(config, x, y, config->triggerDistance, config->cornerSize)) {
+                detector->state = CNEdgeActivationStateDwelling;
+                detector->armedAt = time;
+                detector->isPrepared = false;
+                return CNEdgeActivationEventArmed;
+            }
+            return CNEdgeActivationEventNone;
+        }
+
+        case CNEdgeActivationStateDwelling: {
+            double hysteresis = config->releaseDistance - config->triggerDistance;
+            if (!CNEdgeActivationIsInZone(config, x, y, config->releaseDistance, config->cornerSize + hysteresis)) {
+                detector->state = CNEdgeActivationStateIdle;
+                return CNEdgeActivationEventDisarmed;
+            }
+            /// a pointer that is flicked along the edge is just passing by
+            if (isFast) {
+                detector->armedAt = time;
+                return CNEdgeActivationEventNone;
+            }
+            return CNEdgeActivationDetectorTick(detector, time);
+        }
+
+        case CNEdgeActivationStateLatched: {
+            double hysteresis = config->releaseDistance - config->triggerDistance;
+            if (!CNEdgeActivationIsInZone(config, x, y, config->releaseDistance, config->cornerSize + hysteresis)) {
+                detector->state = CNEdgeActivationStateIdle;
+            }
+            return CNEdgeActivationEventNone;
+        }
+    }
+    return CNEdgeActivationEventNone;
+}
+
+CNEdgeActivationEvent CNEdgeActivationDetectorTick(CNEdgeActivationDetector *detector, double time)
+{
+    double deadline = CNEdgeActivationDetectorDeadline(detector);
+    if (deadline < 0 || time < deadline)
+        return CNEdgeActivationEventNone;
+
+    if (time < detector->armedAt + detector->config.dwellTime) {
+        detector->isPrepared = true;
+        return CNEdgeActivationEventPrepare;
+    }
+    detector->state = CNEdgeActivationStateLatched;
+    return CNEdgeActivationEventActivate;
+}
+
+double CNEdgeActivationDetectorDeadline(const CNEdgeActivationDetector *detector)
+{
+    if (detector->state != CNEdgeActivationStateDwelling)
+        return -1;
+
+    /// a pointer that only grazes the edge never gets to the prepare event
+    if (!detector->isPrepared && detector->config.prepareTime < detector->config.dwellTime)
+        return detector->armedAt + detector->config.prepareTime;
+    return detector->armedAt + detector->config.dwellTime;
+}
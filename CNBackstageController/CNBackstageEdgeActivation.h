@@ -0,0 +1,109 @@
+//
+//  CNBackstageEdgeActivation.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#ifndef CNBackstageEdgeActivation_h
+#define CNBackstageEdgeActivation_h
+
+#include <stdbool.h>
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The edge activation detector turns a stream of pointer positions into activation events for one edge of one display.
+/// It is plain C and purely event driven: it only changes its state on a pointer sample or on a tick at the deadline
+/// it returns itself, so an idle pointer never needs a timer. All coordinates use the Cocoa convention (origin bottom left),
+/// the top row of a display is reported as its maximum y coordinate.
+
+typedef enum {
+    CNActivationEdgeTop = 0,                            // same order as CNToggleEdge
+    CNActivationEdgeBottom,
+    CNActivationEdgeLeft,
+    CNActivationEdgeRight
+} CNActivationEdge;
+
+typedef enum {
+    CNActivationRegionEdge = 0,                         // the whole edge is sensitive
+    CNActivationRegionCorners                           // only the two corners at the ends of the edge are sensitive
+} CNActivationRegion;
+
+typedef enum {
+    CNEdgeActivationEventNone = 0,
+    CNEdgeActivationEventArmed,                         // the pointer rests on the edge, the dwell time starts now
+    CNEdgeActivationEventPrepare,                       // the pointer has been resting for `prepareTime`, an activation is likely
+    CNEdgeActivationEventDisarmed,                      // the pointer left the edge before the dwell time was over
+    CNEdgeActivationEventActivate                       // the dwell time is over, toggle now
+} CNEdgeActivationEvent;
+
+typedef enum {
+    CNEdgeActivationStateIdle = 0,
+    CNEdgeActivationStateDwelling,
+    CNEdgeActivationStateLatched                        // activated, waits for the pointer to leave the release zone
+} CNEdgeActivationState;
+
+typedef struct {
+    bool enabled;
+    double x, y, width, height;                         // frame of the display in global coordinates
+    CNActivationEdge edge;
+    CNActivationRegion region;
+    double triggerDistance;                             // max. distance to the edge that arms the detector
+    double releaseDistance;                             // distance to the edge the pointer has to exceed to disarm (hysteresis)
+    double cornerSize;                                  // side length of a sensitive corner square
+    double dwellTime;                                   // seconds the pointer has to stay in the release zone
+    double prepareTime;                                 // seconds after arming until the prepare event, not after `dwellTime`
+    double velocityThreshold;                           // pointers faster than this (points per second) don't arm and restart the dwell time
+} CNEdgeActivationConfig;
+
+typedef struct {
+    CNEdgeActivationConfig config;
+    CNEdgeActivationState state;
+    double armedAt;
+    bool isPrepared;
+    double lastX, lastY, lastTime;
+    bool hasLastSample;
+} CNEdgeActivationDetector;
+
+
+extern void CNEdgeActivationDetectorInit(CNEdgeActivationDetector *detector, CNEdgeActivationConfig config);
+
+/// Replaces the configuration and resets the detector to idle.
+extern void CNEdgeActivationDetectorSetConfig(CNEdgeActivationDetector *detector, CNEdgeActivationConfig config);
+extern void CNEdgeActivationDetectorReset(CNEdgeActivationDetector *detector);
+
+/// Feeds one pointer sample, `time` is in seconds and must be monotonic.
+extern CNEdgeActivationEvent CNEdgeActivationDetectorPointerMoved(CNEdgeActivationDetector *detector, double x, double y, double time);
+
+/// Call this when the deadline returned by `CNEdgeActivationDetectorDeadline` has been reached.
+extern CNEdgeActivationEvent CNEdgeActivationDetectorTick(CNEdgeActivationDetector *detector, double time);
+
+/// Returns the point in time of the next prepare or activate event, or a negative value if the detector isn't dwelling.
+extern double CNEdgeActivationDetectorDeadline(const CNEdgeActivationDetector *detector);
+
+#endif
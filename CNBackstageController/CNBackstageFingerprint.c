@@ -0,0 +1,97 @@
+//
+//  CNBackstageFingerprint.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "CNBackstageFingerprint.h"
+#include "CNBackstageTileDiff.h"
+
+
+bool CNFingerprintInit(CNFingerprint *fingerprint, int width, int height, int blockSize, int rowStep)
+{
+    memset(fingerprint, 0, sizeof(CNFingerprint));
+    if (width <= 0 || height <= 0 || blockSize <= 0 || rowStep <= 0)
+        return false;
+
+    fingerprint->width = width;
+    fingerprint->height = height;
+    fingerprint->blockSize = blockSize;
+    fingerprint->rowStep = rowStep;
+    fingerprint->columns = (width + blockSize - 1) / blockSize;
+    fingerprint->rows = (height + blockSize - 1) / blockSize;
+    fingerprint->blockHashes = calloc((size_t)fingerprint->columns * (size_t)fingerprint->rows, sizeof(uint64_t));
+    return (fingerprint->blockHashes != NULL);
+}
+
+void CNFingerprintFree(CNFingerprint *fingerprint)
+{
+    free(fingerprint->blockHashes);
+    memset(fingerprint, 0, sizeof(CNFingerprint));
+}
+
+void CNFingerprintCompute(CNFingerprint *fingerprint, const uint8_t *pixels, size_t bytesPerRow)
+{
+    if (fingerprint->blockHashes == NULL)
+        return;
+
+    int blockSize = fingerprint->blockSize;
+    int rowStep = fingerprint->rowStep;
+    for (int row = 0; row < fingerprint->rows; row++) {
+        int y = row * blockSize;
+        int height = (y + blockSize <= fingerprint->height ? blockSize : fingerprint->height - y);
+
+        /// the sampled rows are every rowStep'th row of the whole capture, hashed as if they were adjacent
+        int firstSampledRow = (y + rowStep - 1) / rowStep * rowStep;
+        int sampledRowCount = (firstSampledRow < y + height ? (y + height - firstSampledRow + rowStep - 1) / rowStep : 0);
+        const uint8_t *sampledRows = pixels + (size_t)firstSampledRow * bytesPerRow;
+        uint64_t *blockHashes = fingerprint->blockHashes + (size_t)row * (size_t)fingerprint->columns;
+
+        for (int column = 0; column < fingerprint->columns; column++) {
+            int x = column * blockSize;
+            int width = (x + blockSize <= fingerprint->width ? blockSize : fingerprint->width - x);
+            blockHashes[column] = (sampledRowCount > 0 ? CNTileHash(sampledRows, bytesPerRow * (size_t)rowStep, x, 0, width, sampledRowCount) : 0);
+        }
+    }
+}
+
+bool CNFingerprintMatches(const CNFingerprint *fingerprint, const CNFingerprint *otherFingerprint)
+{
+    if (fingerprint->blockHashes == NULL || otherFingerprint->blockHashes == NULL)
+        return false;
+
+    if (fingerprint->width != otherFingerprint->width || fingerprint->height != otherFingerprint->height ||
+        fingerprint->blockSize != otherFingerprint->blockSize || fingerprint->rowStep != otherFingerprint->rowStep)
+        return false;
+
+    size_t blockCount = (size_t)fingerprint->columns * (size_t)fingerprint->rows;
+    return (memcmp(fingerprint->blockHashes, otherFingerprint->blockHashes, blockCount * sizeof(uint64_t)) == 0);
+}
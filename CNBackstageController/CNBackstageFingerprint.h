@@ -0,0 +1,73 @@
+//
+//  CNBackstageFingerprint.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+
+#ifndef CNBackstageFingerprint_h
+#define CNBackstageFingerprint_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A fingerprint is a cheap summary of a low resolution screen capture. It decides on a re-expand whether the screen
+/// snapshot of the previous expand still shows the current screen content and can be reused.
+///
+/// The capture is divided into square blocks and every `rowStep`th pixel row of a block is hashed with `CNTileHash`, so
+/// the position and the channel of every sampled byte matter. Two fingerprints match if all block hashes are equal. A
+/// change is missed only if it is confined to rows that aren't sampled. With a `rowStep` of 1 every row is sampled.
+///
+/// Pixels are 32 bit, rows top down. It is plain C and has no dependency on AppKit or the window server.
+
+typedef struct {
+    int width;                                          // size of the capture in pixels
+    int height;
+    int blockSize;                                      // edge length of a block in pixels
+    int rowStep;                                        // every rowStep'th row is sampled
+    int columns;
+    int rows;
+    uint64_t *blockHashes;                              // one hash per block, row by row
+} CNFingerprint;
+
+
+/// Allocates the block hashes with `malloc`, release them with `CNFingerprintFree`.
+extern bool CNFingerprintInit(CNFingerprint *fingerprint, int width, int height, int blockSize, int rowStep);
+extern void CNFingerprintFree(CNFingerprint *fingerprint);
+
+/// Computes the fingerprint of a capture with the size given on `CNFingerprintInit`.
+extern void CNFingerprintCompute(CNFingerprint *fingerprint, const uint8_t *pixels, size_t bytesPerRow);
+
+/// Returns `true` if both fingerprints have the same geometry and equal block hashes.
+extern bool CNFingerprintMatches(const CNFingerprint *fingerprint, const CNFingerprint *otherFingerprint);
+
+#endif
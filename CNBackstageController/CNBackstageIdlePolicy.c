@@ -0,0 +1,94 @@
+//
+//  CNBackstageIdlePolicy.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CNBackstageIdlePolicy.h"
+
+
+void CNIdlePolicyInit(CNIdlePolicy *policy, double idleInterval, bool hibernatesOnMemoryPressure)
+{
+    policy->idleInterval = idleInterval;
+    policy->hibernatesOnMemoryPressure = hibernatesOnMemoryPressure;
+    policy->state = CNIdlePolicyStateHibernating;
+    policy->collapsedSince = 0;
+}
+
+CNIdlePolicyAction CNIdlePolicyPrewarm(CNIdlePolicy *policy, double now)
+{
+    if (policy->state != CNIdlePolicyStateHibernating)
+        return CNIdlePolicyActionNone;
+
+    /// a prewarmed controller counts as collapsed, so unused resources will hibernate again
+    policy->state = CNIdlePolicyStateCollapsed;
+    policy->collapsedSince = now;
+    return CNIdlePolicyActionWakeUp;
+}
+
+CNIdlePolicyAction CNIdlePolicyWillExpand(CNIdlePolicy *policy)
+{
+    CNIdlePolicyState previousState = policy->state;
+    policy->state = CNIdlePolicyStateExpanded;
+    return (previousState == CNIdlePolicyStateHibernating ? CNIdlePolicyActionWakeUp : CNIdlePolicyActionNone);
+}
+
+void CNIdlePolicyDidCollapse(CNIdlePolicy *policy, double now)
+{
+    if (policy->state == CNIdlePolicyStateExpanded) {
+        policy->state = CNIdlePolicyStateCollapsed;
+        policy->collapsedSince = now;
+    }
+}
+
+CNIdlePolicyAction CNIdlePolicyTick(CNIdlePolicy *policy, double now)
+{
+    double deadline = CNIdlePolicyNextDeadline(policy);
+    if (deadline < 0 || now < deadline)
+        return CNIdlePolicyActionNone;
+
+    policy->state = CNIdlePolicyStateHibernating;
+    return CNIdlePolicyActionHibernate;
+}
+
+CNIdlePolicyAction CNIdlePolicyMemoryPressure(CNIdlePolicy *policy, CNMemoryPressure pressure)
+{
+    /// resources in use are never taken away, the next collapse will be covered by the idle timeout
+    if (policy->state != CNIdlePolicyStateCollapsed || !policy->hibernatesOnMemoryPressure || pressure == CNMemoryPressureNormal)
+        return CNIdlePolicyActionNone;
+
+    policy->state = CNIdlePolicyStateHibernating;
+    return CNIdlePolicyActionHibernate;
+}
+
+double CNIdlePolicyNextDeadline(const CNIdlePolicy *policy)
+{
+    if (policy->state != CNIdlePolicyStateCollapsed || policy->idleInterval <= 0)
+        return -1;
+    return policy->collapsedSince + policy->idleInterval;
+}
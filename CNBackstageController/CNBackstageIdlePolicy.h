@@ -0,0 +1,87 @@
+//
+//  CNBackstageIdlePolicy.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#ifndef CNBackstageIdlePolicy_h
+#define CNBackstageIdlePolicy_h
+
+#include <stdbool.h>
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The idle policy decides when `CNBackstageController` builds and releases its backstage resources (cover views, snapshots,
+/// baked effects and the reference to the application view). It is plain C and does not read any clock on its own. Every
+/// call gets the current time passed in, so it can be driven by a simulated clock and synthetic memory pressure events.
+
+typedef enum {
+    CNIdlePolicyStateHibernating = 0,                   // no backstage resources are allocated (this is also the initial state)
+    CNIdlePolicyStateCollapsed,                         // resources are allocated, the applicationView is not visible
+    CNIdlePolicyStateExpanded                           // resources are allocated and in use
+} CNIdlePolicyState;
+
+typedef enum {
+    CNIdlePolicyActionNone = 0,                         // nothing to do
+    CNIdlePolicyActionWakeUp,                           // the resources have to be (re)built now
+    CNIdlePolicyActionHibernate                         // the resources have to be released now
+} CNIdlePolicyAction;
+
+typedef enum {
+    CNMemoryPressureNormal = 0,
+    CNMemoryPressureWarning,
+    CNMemoryPressureCritical
+} CNMemoryPressure;
+
+typedef struct {
+    double idleInterval;                                // seconds in collapsed state until hibernation, a value <= 0 disables the timeout
+    bool hibernatesOnMemoryPressure;                    // hibernate on warning or critical memory pressure while collapsed
+    CNIdlePolicyState state;
+    double collapsedSince;
+} CNIdlePolicy;
+
+
+extern void CNIdlePolicyInit(CNIdlePolicy *policy, double idleInterval, bool hibernatesOnMemoryPressure);
+
+/// Call these on the related state changes of the controller.
+extern CNIdlePolicyAction CNIdlePolicyPrewarm(CNIdlePolicy *policy, double now);
+extern CNIdlePolicyAction CNIdlePolicyWillExpand(CNIdlePolicy *policy);
+extern void CNIdlePolicyDidCollapse(CNIdlePolicy *policy, double now);
+
+/// Call this when the deadline returned by `CNIdlePolicyNextDeadline` has been reached.
+extern CNIdlePolicyAction CNIdlePolicyTick(CNIdlePolicy *policy, double now);
+
+/// Call this when the system signals memory pressure.
+extern CNIdlePolicyAction CNIdlePolicyMemoryPressure(CNIdlePolicy *policy, CNMemoryPressure pressure);
+
+/// Returns the point in time the next `CNIdlePolicyTick` call is due, or a negative value if no tick is needed at all.
+/// Nothing has to be polled in between.
+extern double CNIdlePolicyNextDeadline(const CNIdlePolicy *policy);
+
+#endif
@@ -0,0 +1,87 @@
+//
+//  CNBackstageImageEncoder.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+
+#ifndef CNBackstageImageEncoder_h
+#define CNBackstageImageEncoder_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A row streaming PNG encoder. Rows are converted, filtered and deflated as they are appended, so the caller never has
+/// to hold a second copy of the image, and the encoded file grows in a buffer that is owned by the encoder and kept
+/// across images. Encoding many snapshots with one encoder therefore doesn't allocate once the buffer has reached the
+/// size of a typical image. It depends on zlib only, so it runs and can be measured on any platform.
+///
+/// An encoder is not thread safe, use one per thread or serial queue.
+
+typedef enum {
+    CNImagePixelFormatRGBA = 0,                         // 8 bit per channel, in memory order
+    CNImagePixelFormatBGRA                              // 8 bit per channel, in memory order, e.g. 32 bit little endian ARGB
+} CNImagePixelFormat;
+
+typedef struct {
+    int width;
+    int height;
+    CNImagePixelFormat pixelFormat;
+    bool isPremultiplied;                               // PNG stores straight alpha, premultiplied rows are converted
+    bool isOpaque;                                      // the alpha channel is dropped and the image written as RGB
+    int compressionLevel;                               // zlib level 0-9
+} CNImageEncoderParameters;
+
+typedef struct CNImageEncoder CNImageEncoder;
+
+
+/// Fills in an opaque RGBA image of the given size with a fast compression level that suits screen content.
+extern void CNImageEncoderDefaultParameters(CNImageEncoderParameters *parameters, int width, int height);
+
+extern CNImageEncoder *CNImageEncoderCreate(void);
+extern void CNImageEncoderFree(CNImageEncoder *encoder);
+
+/// Starts a new image. The data of the previous image becomes invalid.
+extern bool CNImageEncoderBegin(CNImageEncoder *encoder, const CNImageEncoderParameters *parameters);
+
+/// Appends the next `rowCount` rows, top down. Returns `false` if the encoder ran out of memory or more rows than the
+/// height were appended, the image is invalid then.
+extern bool CNImageEncoderAppendRows(CNImageEncoder *encoder, const uint8_t *rows, size_t bytesPerRow, int rowCount);
+
+/// Finishes the image after all rows were appended. The returned PNG data is owned by the encoder and valid until the
+/// next call of `CNImageEncoderBegin` or `CNImageEncoderFree`. Returns NULL if the image is incomplete or invalid.
+extern const uint8_t *CNImageEncoderFinish(CNImageEncoder *encoder, size_t *length);
+
+/// The capacity of the output buffer, exposed for benchmarking.
+extern size_t CNImageEncoderCapacity(const CNImageEncoder *encoder);
+
+#endif
@@ -0,0 +1,227 @@
+//
+//  CNBackstageLayout.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include <math.h>
+#include "CNBackstageLayout.h"
+
+
+CNLayoutRect CNLayoutRectMake(double x, double y, double width, double height)
+{
+    CNLayoutRect rect = { x, y, width, height };
+    return rect;
+}
+
+bool CNLayoutEdgeIsHorizontal(CNLayoutEdge edge)
+{
+    return (edge == CNLayoutEdgeLeft || edge == CNLayoutEdgeRight || edge == CNLayoutEdgeSplitHorizontal);
+}
+
+void CNLayoutCollapsedFrames(CNLayoutEdge edge, CNLayoutAnimation animation, double windowWidth, double windowHeight, double thickness, CNLayoutFrames *frames)
+{
+    bool isSliding = (animation == CNLayoutAnimationSlide);
+    CNLayoutRect applicationFrame = CNLayoutRectMake(0, 0, 0, 0);
+
+    switch (edge) {
+        case CNLayoutEdgeTop:
+            applicationFrame = CNLayoutRectMake(0, 0, windowWidth, thickness);
+            applicationFrame.y = (isSliding ? windowHeight : windowHeight - thickness);
+            break;
+
+        case CNLayoutEdgeBottom:
+            applicationFrame = CNLayoutRectMake(0, 0, windowWidth, thickness);
+            applicationFrame.y = (isSliding ? -thickness : 0);
+            break;
+
+        case CNLayoutEdgeLeft:
+            applicationFrame = CNLayoutRectMake(0, 0, thickness, windowHeight);
+            applicationFrame.x = (isSliding ? -thickness : 0);
+            break;
+
+        case CNLayoutEdgeRight:
+            applicationFrame = CNLayoutRectMake(0, 0, thickness, windowHeight);
+            applicationFrame.x = (isSliding ? windowWidth : windowWidth - thickness);
+            break;
+
+        case CNLayoutEdgeSplitHorizontal:
+            applicationFrame = CNLayoutRectMake(floor((windowWidth - thickness) / 2), 0, thickness, windowHeight);
+            break;
+
+        case CNLayoutEdgeSplitVertical:
+            applicationFrame = CNLayoutRectMake(0, floor((windowHeight - thickness) / 2), windowWidth, thickness);
+            break;
+    }
+    frames->applicationFrame = applicationFrame;
+
+    /// the covers show the screen snapshot, on split edges it is cut into two halves
+    switch (edge) {
+        case CNLayoutEdgeSplitHorizontal:
+            frames->firstCoverFrame = CNLayoutRectMake(0, 0, windowWidth / 2, windowHeight);
+            frames->secondCoverFrame = CNLayoutRectMake(windowWidth / 2 + 1, 0, windowWidth / 2, windowHeight);
+            frames->hasSecondCover = true;
+            break;
+
+        case CNLayoutEdgeSplitVertical:
+            frames->firstCoverFrame = CNLayoutRectMake(0, windowHeight - floor(windowHeight / 2), windowWidth, floor(windowHeight / 2));
+            frames->secondCoverFrame = CNLayoutRectMake(0, 0, windowWidth, floor(windowHeight / 2));
+            frames->hasSecondCover = true;
+            break;
+
+        default:
+            frames->firstCoverFrame = CNLayoutRectMake(0, 0, windowWidth, windowHeight);
+            frames->secondCoverFrame = CNLayoutRectMake(0, 0, 0, 0);
+            frames->hasSecondCover = false;
+            break;
+    }
+}
+
+void CNLayoutExpandedFrames(CNLayoutEdge edge, CNLayoutAnimation animation, double windowWidth, double windowHeight, double thickness, CNLayoutFrames *frames)
+{
+    CNLayoutCollapsedFrames(edge, animation, windowWidth, windowHeight, thickness, frames);
+
+    double width = ceil(frames->applicationFrame.width);
+    double height = ceil(frames->applicationFrame.height);
+
+    if (animation == CNLayoutAnimationSlide) {
+        switch (edge) {
+            case CNLayoutEdgeTop:       frames->applicationFrame.y -= height; break;
+            case CNLayoutEdgeBottom:    frames->applicationFrame.y += height; break;
+            case CNLayoutEdgeLeft:      frames->applicationFrame.x += width; break;
+            case CNLayoutEdgeRight:     frames->applicationFrame.x -= width; break;
+            default: break;
+        }
+    }
+
+    switch (edge) {
+        case CNLayoutEdgeTop:       frames->firstCoverFrame.y -= height; break;
+        case CNLayoutEdgeBottom:    frames->firstCoverFrame.y += height; break;
+        case CNLayoutEdgeLeft:      frames->firstCoverFrame.x += width; break;
+        case CNLayoutEdgeRight:     frames->firstCoverFrame.x -= width; break;
+
+        case CNLayoutEdgeSplitHorizontal:
+            frames->firstCoverFrame.x -= ceil(width / 2) - 1;
+            frames->secondCoverFrame.x += ceil(width / 2) - 1;
+            break;
+
+        case CNLayoutEdgeSplitVertical:
+            frames->firstCoverFrame.y += ceil(height / 2) - 1;
+            frames->secondCoverFrame.y -= ceil(height / 2) - 1;
+            break;
+    }
+}
+
+void CNLayoutPanelFrames(CNLayoutEdge mainEdge, const CNLayoutPanels *panels, double windowWidth, double windowHeight,
+                         CNLayoutRect panelFrames[4], CNLayoutRect *remainingFrame)
+{
+    double top = panels->thickness[CNLayoutEdgeTop];
+    double bottom = panels->thickness[CNLayoutEdgeBottom];
+    double left = panels->thickness[CNLayoutEdgeLeft];
+    double right = panels->thickness[CNLayoutEdgeRight];
+
+    /// the panels on the axis of the main panel span the whole window, like the main panel itself
+    if (CNLayoutEdgeIsHorizontal(mainEdge)) {
+        panelFrames[CNLayoutEdgeLeft] = CNLayoutRectMake(0, 0, left, windowHeight);
+        panelFrames[CNLayoutEdgeRight] = CNLayoutRectMake(windowWidth - right, 0, right, windowHeight);
+        panelFrames[CNLayoutEdgeTop] = CNLayoutRectMake(left, windowHeight - top, windowWidth - left - right, top);
+        panelFrames[CNLayoutEdgeBottom] = CNLayoutRectMake(left, 0, windowWidth - left - right, bottom);
+    } else {
+        panelFrames[CNLayoutEdgeTop] = CNLayoutRectMake(0, windowHeight - top, windowWidth, top);
+        panelFrames[CNLayoutEdgeBottom] = CNLayoutRectMake(0, 0, windowWidth, bottom);
+        panelFrames[CNLayoutEdgeLeft] = CNLayoutRectMake(0, bottom, left, windowHeight - top - bottom);
+        panelFrames[CNLayoutEdgeRight] = CNLayoutRectMake(windowWidth - right, bottom, right, windowHeight - top - bottom);
+    }
+
+    for (int edge = CNLayoutEdgeTop; edge <= CNLayoutEdgeRight; edge++) {
+        if (panels->thickness[edge] <= 0) {
+            panelFrames[edge] = CNLayoutRectMake(0, 0, 0, 0);
+        }
+    }
+    *remainingFrame = CNLayoutRectMake(left, bottom, fmax(windowWidth - left - right, 0), fmax(windowHeight - top - bottom, 0));
+}
+
+CNLayoutRect CNLayoutCollapsedPanelFrame(CNLayoutEdge edge, CNLayoutAnimation animation, CNLayoutRect panelFrame)
+{
+    if (animation == CNLayoutAnimationSlide) {
+        switch (edge) {
+            case CNLayoutEdgeTop:       panelFrame.y += panelFrame.height; break;
+            case CNLayoutEdgeBottom:    panelFrame.y -= panelFrame.height; break;
+            case CNLayoutEdgeLeft:      panelFrame.x -= panelFrame.width; break;
+            case CNLayoutEdgeRight:     panelFrame.x += panelFrame.width; break;
+            default: break;
+        }
+    }
+    return panelFrame;
+}
+
+int CNLayoutPanelAtPoint(const CNLayoutPanels *panels, const CNLayoutRect panelFrames[4], double x, double y)
+{
+    for (int edge = CNLayoutEdgeTop; edge <= CNLayoutEdgeRight; edge++) {
+        const CNLayoutRect *frame = &panelFrames[edge];
+        if (panels->thickness[edge] > 0 &&
+            x >= frame->x && x < frame->x + frame->width && y >= frame->y && y < frame->y + frame->height) {
+            return edge;
+        }
+    }
+    return -1;
+}
+
+static CNLayoutRect CNLayoutInterpolateRect(CNLayoutRect from, CNLayoutRect to, double progress)
+{
+    return CNLayoutRectMake(from.x + (to.x - from.x) * progress,
+                            from.y + (to.y - from.y) * progress,
+                            from.width + (to.width - from.width) * progress,
+                            from.height + (to.height - from.height) * progress);
+}
+
+void CNLayoutInterpolateFrames(const CNLayoutFrames *from, const CNLayoutFrames *to, double progress, CNLayoutFrames *frames)
+{
+    frames->applicationFrame = CNLayoutInterpolateRect(from->applicationFrame, to->applicationFrame, progress);
+    frames->firstCoverFrame = CNLayoutInterpolateRect(from->firstCoverFrame, to->firstCoverFrame, progress);
+    frames->secondCoverFrame = CNLayoutInterpolateRect(from->secondCoverFrame, to->secondCoverFrame, progress);
+    frames->hasSecondCover = from->hasSecondCover;
+}
+
+double CNLayoutEaseInEaseOut(double time)
+{
+    /// cubic bezier with the control points (0.42, 0) and (0.58, 1), solved for x by Newton iteration
+    static const double x1 = 0.42, x2 = 0.58;
+    if (time <= 0) return 0;
+    if (time >= 1) return 1;
+
+    double t = time;
+    for (int i = 0; i < 8; i++) {
+        double x = 3 * (1 - t) * (1 - t) * t * x1 + 3 * (1 - t) * t * t * x2 + t * t * t - time;
+        double dx = 3 * (1 - t) * (1 - t) * x1 + 6 * (1 - t) * t * (x2 - x1) + 3 * t * t * (1 - x2);
+        if (fabs(x) < 1e-7 || dx == 0)
+            break;
+        t -= x / dx;
+    }
+    return 3 * (1 - t) * t * t + t * t * t;
+}
@@ -0,0 +1,108 @@
+//
+//  CNBackstageLayout.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#ifndef CNBackstageLayout_h
+#define CNBackstageLayout_h
+
+#include <stdbool.h>
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Plain C geometry of the backstage window: the frames of the application view and of the screen snapshot covers in
+/// collapsed and expanded state. `CNBackstageController` and the reference compositor both use it, so they can't drift
+/// apart. All rects use the Cocoa convention (origin bottom left) and are relative to the window content.
+
+typedef struct {
+    double x;
+    double y;
+    double width;
+    double height;
+} CNLayoutRect;
+
+typedef enum {
+    CNLayoutEdgeTop = 0,                                // same order as CNToggleEdge
+    CNLayoutEdgeBottom,
+    CNLayoutEdgeLeft,
+    CNLayoutEdgeRight,
+    CNLayoutEdgeSplitHorizontal,
+    CNLayoutEdgeSplitVertical
+} CNLayoutEdge;
+
+typedef enum {
+    CNLayoutAnimationStatic = 0,                        // same order as CNToggleAnimationEffect
+    CNLayoutAnimationFade,
+    CNLayoutAnimationSlide
+} CNLayoutAnimation;
+
+typedef struct {
+    CNLayoutRect applicationFrame;
+    CNLayoutRect firstCoverFrame;
+    CNLayoutRect secondCoverFrame;
+    bool hasSecondCover;                                // only the split edges have a second cover
+} CNLayoutFrames;
+
+typedef struct {
+    double thickness[4];                                // indexed by CNLayoutEdgeTop to CNLayoutEdgeRight, 0 means no panel on that edge
+} CNLayoutPanels;
+
+
+extern CNLayoutRect CNLayoutRectMake(double x, double y, double width, double height);
+
+/// Returns `true` if the thickness of the application view is measured horizontally on this edge.
+extern bool CNLayoutEdgeIsHorizontal(CNLayoutEdge edge);
+
+/// Frames right before the expand animation starts (and right after the collapse animation ended).
+/// `thickness` is the width or height of the application view, dependent on the edge.
+extern void CNLayoutCollapsedFrames(CNLayoutEdge edge, CNLayoutAnimation animation, double windowWidth, double windowHeight, double thickness, CNLayoutFrames *frames);
+
+/// Frames at the end of the expand animation.
+extern void CNLayoutExpandedFrames(CNLayoutEdge edge, CNLayoutAnimation animation, double windowWidth, double windowHeight, double thickness, CNLayoutFrames *frames);
+
+/// Linear interpolation of all frames, `progress` runs from 0 (`from`) to 1 (`to`).
+extern void CNLayoutInterpolateFrames(const CNLayoutFrames *from, const CNLayoutFrames *to, double progress, CNLayoutFrames *frames);
+
+/// Expanded frames of the panels on the four non split edges, the main panel on `mainEdge` included, and the remaining
+/// region in which the covers stay visible. Panels on the axis of the main panel span the whole window, the panels on the
+/// other axis fill the space between them. A panel slot without thickness gets an empty frame.
+extern void CNLayoutPanelFrames(CNLayoutEdge mainEdge, const CNLayoutPanels *panels, double windowWidth, double windowHeight,
+                                CNLayoutRect panelFrames[4], CNLayoutRect *remainingFrame);
+
+/// Frame of a panel right before it appears (and right after it has disappeared).
+extern CNLayoutRect CNLayoutCollapsedPanelFrame(CNLayoutEdge edge, CNLayoutAnimation animation, CNLayoutRect panelFrame);
+
+/// Returns the edge of the panel that contains the point, or -1. It checks at most four frames.
+extern int CNLayoutPanelAtPoint(const CNLayoutPanels *panels, const CNLayoutRect panelFrames[4], double x, double y);
+
+/// The ease in/ease out timing curve of the toggle animations (`kCAMediaTimingFunctionEaseInEaseOut`).
+extern double CNLayoutEaseInEaseOut(double time);
+
+#endif
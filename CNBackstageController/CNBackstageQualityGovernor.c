@@ -0,0 +1,190 @@
+//
+//  CNBackstageQualityGovernor.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include <math.h>
+#include "CNBackstageQualityGovernor.h"
+
+
+static const unsigned int kCNQualityWindowFrames = 30;          // nominal frames of one measuring window (0.5 seconds at 60 Hz)
+static const unsigned int kCNQualityMinimumWindowFrames = 10;   // shorter rests of a session are not evaluated
+static const unsigned int kCNQualityMaximumMissedFramesPerGap = 3;
+static const double kCNQualityStepDownMissedRatio = 0.1;
+static const double kCNQualityStepUpMissedRatio = 0.02;
+static const unsigned int kCNQualityGoodWindowsRequired = 4;
+static const unsigned int kCNQualityMaximumGoodWindowsRequired = 64;
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Level Steps
+
+static bool CNQualityGovernorStep(CNQualityGovernor *governor, int direction)
+{
+    int level = (int)governor->level + direction;
+    while (level >= CNQualityLevelFull && level < CNQualityLevelCount) {
+        if (level == CNQualityLevelFull || (governor->applicableLevels & CNQualityLevelMask(level))) {
+            governor->level = (CNQualityLevel)level;
+            return true;
+        }
+        level += direction;
+    }
+    return false;
+}
+
+static void CNQualityGovernorResetWindow(CNQualityGovernor *governor)
+{
+    governor->windowFrames = 0;
+    governor->windowMissedFrames = 0;
+}
+
+static bool CNQualityGovernorEvaluateWindow(CNQualityGovernor *governor)
+{
+    double missedRatio = (double)governor->windowMissedFrames / governor->windowFrames;
+    CNQualityGovernorResetWindow(governor);
+
+    if (missedRatio > kCNQualityStepDownMissedRatio) {
+        /// a step up that immediately fails makes the next try more expensive, so the level doesn't oscillate
+        if (governor->isProbing && governor->goodWindowsRequired < kCNQualityMaximumGoodWindowsRequired) {
+            governor->goodWindowsRequired *= 2;
+        }
+        governor->isProbing = false;
+        governor->goodWindows = 0;
+        return CNQualityGovernorStep(governor, +1);
+    }
+
+    if (missedRatio > kCNQualityStepUpMissedRatio) {
+        /// no jank worth a step down, but no headroom either
+        governor->isProbing = false;
+        governor->goodWindows = 0;
+        return false;
+    }
+
+    if (governor->isProbing) {
+        governor->isProbing = false;
+        if (governor->goodWindowsRequired > kCNQualityGoodWindowsRequired) {
+            governor->goodWindowsRequired /= 2;
+        }
+    }
+
+    governor->goodWindows++;
+    if (governor->goodWindows < governor->goodWindowsRequired)
+        return false;
+
+    governor->goodWindows = 0;
+    if (!CNQualityGovernorStep(governor, -1))
+        return false;
+    governor->isProbing = true;
+    return true;
+}
+
+
+static bool CNQualityGovernorEvaluateSessionWindow(CNQualityGovernor *governor)
+{
+    /// a new level is applied on the next expand, the rest of the session would still measure the previous one
+    if (governor->levelDidChangeInSession) {
+        CNQualityGovernorResetWindow(governor);
+        return false;
+    }
+    governor->levelDidChangeInSession = CNQualityGovernorEvaluateWindow(governor);
+    return governor->levelDidChangeInSession;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Public
+
+void CNQualityGovernorInit(CNQualityGovernor *governor, unsigned int applicableLevels)
+{
+    governor->applicableLevels = applicableLevels;
+    governor->frameInterval = 1.0 / 60.0;
+    CNQualityGovernorReset(governor);
+}
+
+void CNQualityGovernorReset(CNQualityGovernor *governor)
+{
+    governor->level = CNQualityLevelFull;
+    governor->lastFrameTime = -1;
+    governor->goodWindows = 0;
+    governor->goodWindowsRequired = kCNQualityGoodWindowsRequired;
+    governor->isProbing = false;
+    governor->levelDidChangeInSession = false;
+    CNQualityGovernorResetWindow(governor);
+}
+
+void CNQualityGovernorSetApplicableLevels(CNQualityGovernor *governor, unsigned int applicableLevels)
+{
+    governor->applicableLevels = applicableLevels;
+}
+
+void CNQualityGovernorBeginSession(CNQualityGovernor *governor, double frameInterval)
+{
+    if (frameInterval > 0) {
+        governor->frameInterval = frameInterval;
+    }
+    governor->lastFrameTime = -1;
+    governor->levelDidChangeInSession = false;
+    CNQualityGovernorResetWindow(governor);
+}
+
+bool CNQualityGovernorAddFrame(CNQualityGovernor *governor, double timestamp)
+{
+    if (governor->lastFrameTime < 0 || timestamp <= governor->lastFrameTime) {
+        governor->lastFrameTime = timestamp;
+        return false;
+    }
+
+    /// a gap of n frame intervals means n-1 missed frames, a single long stall must not dominate the whole window
+    unsigned int frames = (unsigned int)fmax(1.0, floor((timestamp - governor->lastFrameTime) / governor->frameInterval + 0.5));
+    unsigned int missedFrames = frames - 1;
+    if (missedFrames > kCNQualityMaximumMissedFramesPerGap) {
+        missedFrames = kCNQualityMaximumMissedFramesPerGap;
+    }
+    governor->lastFrameTime = timestamp;
+    governor->windowFrames += missedFrames + 1;
+    governor->windowMissedFrames += missedFrames;
+
+    if (governor->windowFrames < kCNQualityWindowFrames)
+        return false;
+    return CNQualityGovernorEvaluateSessionWindow(governor);
+}
+
+bool CNQualityGovernorEndSession(CNQualityGovernor *governor)
+{
+    bool levelDidChange = false;
+    if (governor->windowFrames >= kCNQualityMinimumWindowFrames) {
+        levelDidChange = CNQualityGovernorEvaluateSessionWindow(governor);
+    }
+    governor->lastFrameTime = -1;
+    CNQualityGovernorResetWindow(governor);
+    return levelDidChange;
+}
@@ -0,0 +1,91 @@
+//
+//  CNBackstageQualityGovernor.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+
+#ifndef CNBackstageQualityGovernor_h
+#define CNBackstageQualityGovernor_h
+
+#include <stdbool.h>
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The quality governor decides how much of the configured effects `CNBackstageController` can afford. It is fed with the
+/// frame timestamps of expand, collapse and drag sessions and steps down one quality level when too many frames were missed,
+/// and back up when there was enough headroom for a while. Like the idle policy it does not read any clock on its own, so it
+/// can be driven by synthetic frame time traces.
+
+typedef enum {
+    CNQualityLevelFull = 0,                             // all configured effects
+    CNQualityLevelReducedBlur,                          // the gaussian blur uses a smaller radius
+    CNQualityLevelNoBlur,                               // no gaussian blur, a black overlay is still used
+    CNQualityLevelNoShadows,                            // no shadows
+    CNQualityLevelFade,                                 // a slide animation is replaced by a fade animation
+    CNQualityLevelStatic,                               // no animation at all
+    CNQualityLevelCount
+} CNQualityLevel;
+
+#define CNQualityLevelMask(level)   (1u << (level))
+
+typedef struct {
+    unsigned int applicableLevels;                      // mask of the levels that make a difference, CNQualityLevelFull is always applicable
+    CNQualityLevel level;
+
+    double frameInterval;                               // nominal frame interval of the display of the current session
+    double lastFrameTime;                               // a negative value until the first frame of a session arrived
+    unsigned int windowFrames;                          // nominal frames of the current window, presented and missed ones
+    unsigned int windowMissedFrames;
+    bool levelDidChangeInSession;
+
+    unsigned int goodWindows;                           // consecutive windows with headroom since the last level change
+    unsigned int goodWindowsRequired;                   // grows with every step up that had to be taken back
+    bool isProbing;                                     // the last change was a step up that has not proven to be sustainable yet
+} CNQualityGovernor;
+
+
+extern void CNQualityGovernorInit(CNQualityGovernor *governor, unsigned int applicableLevels);
+
+/// Forgets all measurements and returns to `CNQualityLevelFull`.
+extern void CNQualityGovernorReset(CNQualityGovernor *governor);
+
+/// Levels that are not applicable are skipped when stepping up or down, e.g. there is nothing to reduce without a blur.
+extern void CNQualityGovernorSetApplicableLevels(CNQualityGovernor *governor, unsigned int applicableLevels);
+
+/// A session is one expand animation, collapse animation or drag. Frames of different sessions are never compared
+/// with each other, so the pause in between is not counted as missed frames.
+extern void CNQualityGovernorBeginSession(CNQualityGovernor *governor, double frameInterval);
+
+/// Call these with the timestamp of each presented frame and at the end of a session. Both return `true` if the level
+/// has changed.
+extern bool CNQualityGovernorAddFrame(CNQualityGovernor *governor, double timestamp);
+extern bool CNQualityGovernorEndSession(CNQualityGovernor *governor);
+
+#endif
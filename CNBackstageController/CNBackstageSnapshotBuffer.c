@@ -0,0 +1,272 @@
+//
+//  CNBackstageSnapshotBuffer.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+/// shm_open, ftruncate and strdup are POSIX, without this they aren't declared in strict C99 or C11 mode
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CNBackstageSnapshotBuffer.h"
+
+
+static const uint32_t kCNSnapshotBufferMagic        = 0x434E5342;      // "CNSB"
+static const uint32_t kCNSnapshotBufferVersion      = 1;
+static const size_t kCNSnapshotBufferHeaderLength   = 64;              // the pixels of a shared memory object start here
+
+/// Layout of the header in front of the pixels of a shared memory object. Only fixed size types, so processes built
+/// for different architectures agree on it.
+typedef struct {
+    uint32_t magic;                                     // written last, an object without it is incomplete
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    uint64_t bytesPerRow;
+    uint32_t pixelFormat;
+    uint32_t isOpaque;
+    double backingScale;
+    uint32_t displayID;
+    uint32_t reserved;
+} CNSnapshotBufferSharedHeader;
+
+struct CNSnapshotBuffer {
+    volatile int32_t referenceCount;
+    CNSnapshotBufferInfo info;
+    CNSnapshotBufferBacking backing;
+    const uint8_t *bytes;
+
+    CNSnapshotBufferReleaseCallback releaseCallback;    // bytes backing
+    void *context;
+
+    void *mapping;                                      // shared memory backing
+    size_t mappingLength;
+    char *sharedName;                                   // only set for the creator, which unlinks the name
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Private Helper
+
+/// The number of bytes the pixels of `info` span, the last row doesn't need to be padded to the full stride.
+static bool CNSnapshotBufferInfoLength(const CNSnapshotBufferInfo *info, size_t *length)
+{
+    if (info->width <= 0 || info->height <= 0 || info->backingScale <= 0 ||
+        (info->pixelFormat != CNImagePixelFormatRGBA && info->pixelFormat != CNImagePixelFormatBGRA))
+        return false;
+
+    size_t rowLength = (size_t)info->width * 4;
+    if (info->bytesPerRow < rowLength || (size_t)(info->height - 1) > (SIZE_MAX - rowLength) / info->bytesPerRow)
+        return false;
+
+    *length = info->bytesPerRow * (size_t)(info->height - 1) + rowLength;
+    return true;
+}
+
+static CNSnapshotBuffer *CNSnapshotBufferAlloc(const CNSnapshotBufferInfo *info, CNSnapshotBufferBacking backing)
+{
+    CNSnapshotBuffer *buffer = calloc(1, sizeof(CNSnapshotBuffer));
+    if (buffer == NULL)
+        return NULL;
+    buffer->referenceCount = 1;
+    buffer->info = *info;
+    buffer->backing = backing;
+    return buffer;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// API
+
+CNSnapshotBuffer *CNSnapshotBufferCreateWithBytes(const CNSnapshotBufferInfo *info, const void *bytes, size_t length,
+                                                  CNSnapshotBufferReleaseCallback releaseCallback, void *context)
+{
+    size_t requiredLength;
+    if (bytes == NULL || !CNSnapshotBufferInfoLength(info, &requiredLength) || length < requiredLength)
+        return NULL;
+
+    CNSnapshotBuffer *buffer = CNSnapshotBufferAlloc(info, CNSnapshotBufferBackingBytes);
+    if (buffer == NULL)
+        return NULL;
+    buffer->bytes = bytes;
+    buffer->releaseCallback = releaseCallback;
+    buffer->context = context;
+    return buffer;
+}
+
+CNSnapshotBuffer *CNSnapshotBufferCreateShared(const CNSnapshotBufferInfo *info, const void *bytes, const char *name)
+{
+    size_t pixelLength;
+    if (bytes == NULL || name == NULL || !CNSnapshotBufferInfoLength(info, &pixelLength) ||
+        pixelLength > SIZE_MAX - kCNSnapshotBufferHeaderLength)
+        return NULL;
+
+    CNSnapshotBuffer *buffer = CNSnapshotBufferAlloc(info, CNSnapshotBufferBackingSharedMemory);
+    char *sharedName = strdup(name);
+    if (buffer == NULL || sharedName == NULL) {
+        free(buffer);
+        free(sharedName);
+        return NULL;
+    }
+
+    /// only the user who created it may open it
+    int fileDescriptor = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fileDescriptor < 0) {
+        free(buffer);
+        free(sharedName);
+        return NULL;
+    }
+
+    size_t mappingLength = kCNSnapshotBufferHeaderLength + pixelLength;
+    void *mapping = MAP_FAILED;
+    if (ftruncate(fileDescriptor, (off_t)mappingLength) == 0)
+        mapping = mmap(NULL, mappingLength, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name);
+        free(buffer);
+        free(sharedName);
+        return NULL;
+    }
+
+    CNSnapshotBufferSharedHeader *header = mapping;
+    header->version = kCNSnapshotBufferVersion;
+    header->width = info->width;
+    header->height = info->height;
+    header->bytesPerRow = info->bytesPerRow;
+    header->pixelFormat = (uint32_t)info->pixelFormat;
+    header->isOpaque = info->isOpaque;
+    header->backingScale = info->backingScale;
+    header->displayID = info->displayID;
+    memcpy((uint8_t *)mapping + kCNSnapshotBufferHeaderLength, bytes, pixelLength);
+
+    /// the pixels have to be visible before the magic, a process opening the object in between sees an incomplete one
+    __sync_synchronize();
+    header->magic = kCNSnapshotBufferMagic;
+    mprotect(mapping, mappingLength, PROT_READ);
+
+    buffer->bytes = (const uint8_t *)mapping + kCNSnapshotBufferHeaderLength;
+    buffer->mapping = mapping;
+    buffer->mappingLength = mappingLength;
+    buffer->sharedName = sharedName;
+    return buffer;
+}
+
+CNSnapshotBuffer *CNSnapshotBufferOpenShared(const char *name)
+{
+    if (name == NULL)
+        return NULL;
+
+    int fileDescriptor = shm_open(name, O_RDONLY, 0);
+    if (fileDescriptor < 0)
+        return NULL;
+
+    struct stat status;
+    void *mapping = MAP_FAILED;
+    size_t mappingLength = 0;
+    if (fstat(fileDescriptor, &status) == 0 && status.st_size >= (off_t)kCNSnapshotBufferHeaderLength) {
+        mappingLength = (size_t)status.st_size;
+        mapping = mmap(NULL, mappingLength, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    }
+    close(fileDescriptor);
+    if (mapping == MAP_FAILED)
+        return NULL;
+
+    /// the rest of the header and the pixels are read after the magic, see CNSnapshotBufferCreateShared
+    const CNSnapshotBufferSharedHeader *header = mapping;
+    bool isComplete = (header->magic == kCNSnapshotBufferMagic);
+    __sync_synchronize();
+
+    CNSnapshotBufferInfo info;
+    info.width = header->width;
+    info.height = header->height;
+    info.bytesPerRow = (size_t)header->bytesPerRow;
+    info.pixelFormat = (CNImagePixelFormat)header->pixelFormat;
+    info.isOpaque = (header->isOpaque != 0);
+    info.backingScale = header->backingScale;
+    info.displayID = header->displayID;
+
+    size_t pixelLength;
+    CNSnapshotBuffer *buffer = NULL;
+    if (isComplete && header->version == kCNSnapshotBufferVersion && (uint64_t)info.bytesPerRow == header->bytesPerRow &&
+        CNSnapshotBufferInfoLength(&info, &pixelLength) && pixelLength <= mappingLength - kCNSnapshotBufferHeaderLength) {
+        buffer = CNSnapshotBufferAlloc(&info, CNSnapshotBufferBackingSharedMemory);
+    }
+    if (buffer == NULL) {
+        munmap(mapping, mappingLength);
+        return NULL;
+    }
+
+    buffer->bytes = (const uint8_t *)mapping + kCNSnapshotBufferHeaderLength;
+    buffer->mapping = mapping;
+    buffer->mappingLength = mappingLength;
+    return buffer;
+}
+
+CNSnapshotBuffer *CNSnapshotBufferRetain(CNSnapshotBuffer *buffer)
+{
+    if (buffer != NULL)
+        __sync_add_and_fetch(&buffer->referenceCount, 1);
+    return buffer;
+}
+
+void CNSnapshotBufferRelease(CNSnapshotBuffer *buffer)
+{
+    if (buffer == NULL || __sync_sub_and_fetch(&buffer->referenceCount, 1) > 0)
+        return;
+
+    if (buffer->releaseCallback != NULL)
+        buffer->releaseCallback(buffer->context);
+    if (buffer->mapping != NULL)
+        munmap(buffer->mapping, buffer->mappingLength);
+    if (buffer->sharedName != NULL) {
+        shm_unlink(buffer->sharedName);
+        free(buffer->sharedName);
+    }
+    free(buffer);
+}
+
+const CNSnapshotBufferInfo *CNSnapshotBufferGetInfo(const CNSnapshotBuffer *buffer)
+{
+    return &buffer->info;
+}
+
+const uint8_t *CNSnapshotBufferGetBytes(const CNSnapshotBuffer *buffer)
+{
+    return buffer->bytes;
+}
+
+CNSnapshotBufferBacking CNSnapshotBufferGetBacking(const CNSnapshotBuffer *buffer)
+{
+    return buffer->backing;
+}
@@ -0,0 +1,103 @@
+//
+//  CNBackstageSnapshotBuffer.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+
+#ifndef CNBackstageSnapshotBuffer_h
+#define CNBackstageSnapshotBuffer_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CNBackstageImageEncoder.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A snapshot buffer is a read-only, reference counted handle to the pixels of a screen snapshot together with their
+/// geometry, the backing scale and the display they were captured from. `CNBackstageController` hands out the snapshot
+/// of an expand as such a buffer, so the application doesn't need to capture the display a second time.
+///
+/// Backings:
+///   - bytes           pixels owned by someone else, e.g. the memory a capture is drawn into and a `CGImage` is made
+///                     over, they are not copied and the release callback is called when the last reference is gone.
+///   - shared memory   pixels in a named POSIX shared memory object, so another process can map the same snapshot.
+///                     Creating one copies the pixels once, opening one maps them read-only without a copy.
+///
+/// Lifetime rules:
+///   - Every Create, Open and Retain has to be balanced by one `CNSnapshotBufferRelease`. Retain and release are
+///     thread safe.
+///   - The pixels never change and stay valid until the last reference is released. Reading them needs no locking.
+///   - The name of a shared memory object is unlinked when the last reference of its creator is released. Processes
+///     that have opened it before keep their mapping until they release it, opening it afterwards fails.
+///
+/// It is plain C with POSIX shared memory and has no dependency on AppKit or the window server.
+
+typedef enum {
+    CNSnapshotBufferBackingBytes = 0,
+    CNSnapshotBufferBackingSharedMemory
+} CNSnapshotBufferBacking;
+
+typedef struct {
+    int width;                                          // in pixels
+    int height;
+    size_t bytesPerRow;                                 // stride, rows top down
+    CNImagePixelFormat pixelFormat;                     // 8 bit per channel, premultiplied alpha
+    bool isOpaque;                                      // the alpha channel is undefined
+    double backingScale;                                // pixels per point
+    uint32_t displayID;                                 // the CGDirectDisplayID the snapshot was captured from
+} CNSnapshotBufferInfo;
+
+typedef struct CNSnapshotBuffer CNSnapshotBuffer;
+
+typedef void (*CNSnapshotBufferReleaseCallback)(void *context);
+
+
+/// Wraps `length` bytes of pixels without copying them. `releaseCallback` may be NULL, otherwise it is called with
+/// `context` when the last reference is released. Returns NULL if the info doesn't fit `length`, the callback is not
+/// called then.
+extern CNSnapshotBuffer *CNSnapshotBufferCreateWithBytes(const CNSnapshotBufferInfo *info, const void *bytes, size_t length,
+                                                          CNSnapshotBufferReleaseCallback releaseCallback, void *context);
+
+/// Creates the shared memory object `name` (a POSIX name like "/snapshot", at most 31 characters on OS X) and copies
+/// the pixels of `info` and `bytes` into it. Fails if an object with that name exists.
+extern CNSnapshotBuffer *CNSnapshotBufferCreateShared(const CNSnapshotBufferInfo *info, const void *bytes, const char *name);
+
+/// Maps the shared memory object `name` read-only. Fails if it doesn't exist or isn't a complete snapshot buffer.
+extern CNSnapshotBuffer *CNSnapshotBufferOpenShared(const char *name);
+
+extern CNSnapshotBuffer *CNSnapshotBufferRetain(CNSnapshotBuffer *buffer);
+extern void CNSnapshotBufferRelease(CNSnapshotBuffer *buffer);
+
+extern const CNSnapshotBufferInfo *CNSnapshotBufferGetInfo(const CNSnapshotBuffer *buffer);
+extern const uint8_t *CNSnapshotBufferGetBytes(const CNSnapshotBuffer *buffer);
+extern CNSnapshotBufferBacking CNSnapshotBufferGetBacking(const CNSnapshotBuffer *buffer);
+
+#endif
@@ -0,0 +1,382 @@
+//
+//  CNBackstageState.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CNBackstageState.h"
+#include "CNBackstageCompositor.h"
+
+
+static const char *kCNStateRecordHeader         = "CNBackstageState";
+static const long kCNStateMaxSize               = 1L << 20;                 // points, far beyond any display
+static const double kCNStateAlphaScale          = 1000000.0;                // the alpha is written in millionths
+
+enum {
+    kCNStateMaxLineLength                       = 128,
+    kCNStateMaxValues                           = 5
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Dragged Sizes
+
+static int CNDraggedSizesIndex(const CNDraggedSizes *sizes, CNDisplayIdentity display, CNLayoutEdge edge)
+{
+    for (int i = 0; i < sizes->count; i++) {
+        const CNDraggedSize *entry = &sizes->entries[i];
+        if (entry->display.vendor == display.vendor && entry->display.model == display.model &&
+            entry->display.serial == display.serial && entry->edge == edge)
+            return i;
+    }
+    return -1;
+}
+
+static bool CNStateEdgeIsValid(long edge)
+{
+    return (edge >= CNLayoutEdgeTop && edge <= CNLayoutEdgeSplitVertical);
+}
+
+bool CNDraggedSizesGet(const CNDraggedSizes *sizes, CNDisplayIdentity display, CNLayoutEdge edge, long *size)
+{
+    int index = CNDraggedSizesIndex(sizes, display, edge);
+    if (index < 0)
+        return false;
+    *size = sizes->entries[index].size;
+    return true;
+}
+
+bool CNDraggedSizesSet(CNDraggedSizes *sizes, CNDisplayIdentity display, CNLayoutEdge edge, long size)
+{
+    if (!CNStateEdgeIsValid(edge) || size <= 0 || size > kCNStateMaxSize)
+        return false;
+
+    int index = CNDraggedSizesIndex(sizes, display, edge);
+    if (index < 0) {
+        if (sizes->count == sizes->capacity) {
+            int capacity = (sizes->capacity > 0 ? sizes->capacity * 2 : 8);
+            CNDraggedSize *entries = realloc(sizes->entries, (size_t)capacity * sizeof(CNDraggedSize));
+            if (entries == NULL)
+                return false;
+            sizes->entries = entries;
+            sizes->capacity = capacity;
+        }
+        index = sizes->count++;
+        sizes->entries[index].display = display;
+        sizes->entries[index].edge = edge;
+    }
+    sizes->entries[index].size = size;
+    return true;
+}
+
+void CNDraggedSizesRemove(CNDraggedSizes *sizes, CNDisplayIdentity display, CNLayoutEdge edge)
+{
+    int index = CNDraggedSizesIndex(sizes, display, edge);
+    if (index < 0)
+        return;
+    sizes->entries[index] = sizes->entries[sizes->count - 1];
+    sizes->count--;
+}
+
+bool CNDraggedSizesCopy(CNDraggedSizes *destination, const CNDraggedSizes *source)
+{
+    if (destination == source)
+        return true;
+
+    CNDraggedSizesFree(destination);
+    if (source->count == 0)
+        return true;
+
+    destination->entries = malloc((size_t)source->count * sizeof(CNDraggedSize));
+    if (destination->entries == NULL)
+        return false;
+    memcpy(destination->entries, source->entries, (size_t)source->count * sizeof(CNDraggedSize));
+    destination->count = destination->capacity = source->count;
+    return true;
+}
+
+void CNDraggedSizesFree(CNDraggedSizes *sizes)
+{
+    free(sizes->entries);
+    memset(sizes, 0, sizeof(CNDraggedSizes));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Record
+
+void CNStateRecordInit(CNStateRecord *record)
+{
+    memset(record, 0, sizeof(CNStateRecord));
+}
+
+void CNStateRecordFree(CNStateRecord *record)
+{
+    CNDraggedSizesFree(&record->draggedSizes);
+    memset(record, 0, sizeof(CNStateRecord));
+}
+
+typedef struct {
+    char *buffer;
+    size_t bufferSize;
+    size_t length;
+} CNStateWriter;
+
+static void CNStateWrite(CNStateWriter *writer, const char *format, ...)
+{
+    char line[kCNStateMaxLineLength];
+    va_list arguments;
+    va_start(arguments, format);
+    int lineLength = vsnprintf(line, sizeof(line), format, arguments);
+    va_end(arguments);
+    if (lineLength <= 0)
+        return;
+
+    /// like snprintf, the text is cut at the end of the buffer but the whole length is counted
+    if (writer->length < writer->bufferSize) {
+        size_t available = writer->bufferSize - writer->length - 1;
+        size_t count = ((size_t)lineLength < available ? (size_t)lineLength : available);
+        memcpy(writer->buffer + writer->length, line, count);
+        writer->buffer[writer->length + count] = '\0';
+    }
+    writer->length += (size_t)lineLength;
+}
+
+size_t CNStateRecordEncode(const CNStateRecord *record, char *buffer, size_t bufferSize)
+{
+    CNStateWriter writer = { buffer, (buffer != NULL ? bufferSize : 0), 0 };
+    if (writer.bufferSize > 0)
+        buffer[0] = '\0';
+
+    CNStateWrite(&writer, "%s %d\n", kCNStateRecordHeader, CNStateRecordVersion);
+    if (record->fields & CNStateFieldEdge)
+        CNStateWrite(&writer, "edge %d\n", (int)record->edge);
+    if (record->fields & CNStateFieldSize)
+        CNStateWrite(&writer, "size %lu %lu\n", record->sizeWidth, record->sizeHeight);
+    if (record->fields & CNStateFieldDisplay)
+        CNStateWrite(&writer, "display %d\n", record->display);
+    if (record->fields & CNStateFieldVisualEffects)
+        CNStateWrite(&writer, "visualEffects %u\n", record->visualEffects);
+    if (record->fields & CNStateFieldAnimation)
+        CNStateWrite(&writer, "animation %d\n", (int)record->animation);
+    if ((record->fields & CNStateFieldOverlayAlpha) && !isnan(record->overlayAlpha)) {
+        double alpha = fmin(fmax(record->overlayAlpha, 0), 1);
+        CNStateWrite(&writer, "overlayAlpha %ld\n", lround(alpha * kCNStateAlphaScale));
+    }
+    if (record->fields & CNStateFieldShadows)
+        CNStateWrite(&writer, "shadows %d\n", (record->shouldUseShadows ? 1 : 0));
+
+    for (int i = 0; i < record->draggedSizes.count; i++) {
+        const CNDraggedSize *entry = &record->draggedSizes.entries[i];
+        CNStateWrite(&writer, "dragged %u %u %u %d %ld\n", entry->display.vendor, entry->display.model, entry->display.serial,
+                     (int)entry->edge, entry->size);
+    }
+    return writer.length;
+}
+
+/// Splits `line` into its key and up to `kCNStateMaxValues` unsigned integers separated by single spaces. Returns the
+/// number of integers, or -1 if the line has another form.
+static int CNStateParseLine(char *line, const char **key, long long *values)
+{
+    char *separator = strchr(line, ' ');
+    if (separator == line)
+        return -1;
+    *key = line;
+    if (separator == NULL)
+        return 0;
+    *separator = '\0';
+
+    int count = 0;
+    const char *token = separator + 1;
+    while (*token != '\0') {
+        if (count == kCNStateMaxValues || *token < '0' || *token > '9')
+            return -1;
+        char *end;
+        errno = 0;
+        values[count++] = strtoll(token, &end, 10);
+        if (errno != 0 || (*end != ' ' && *end != '\0') || (*end == ' ' && end[1] == '\0'))
+            return -1;
+        token = (*end == ' ' ? end + 1 : end);
+    }
+    return count;
+}
+
+static bool CNStateIsInRange(long long value, long long minimum, long long maximum)
+{
+    return (value >= minimum && value <= maximum);
+}
+
+static void CNStateDecodeLine(CNStateRecord *record, const char *key, const long long *values, int count, int displayCount)
+{
+    if (strcmp(key, "edge") == 0 && count == 1) {
+        if (CNStateIsInRange(values[0], CNLayoutEdgeTop, CNLayoutEdgeSplitVertical)) {
+            record->edge = (CNLayoutEdge)values[0];
+            record->fields |= CNStateFieldEdge;
+        }
+    }
+    else if (strcmp(key, "size") == 0 && count == 2) {
+        if (CNStateIsInRange(values[0], 0, kCNStateMaxSize) && CNStateIsInRange(values[1], 0, kCNStateMaxSize)) {
+            record->sizeWidth = (unsigned long)values[0];
+            record->sizeHeight = (unsigned long)values[1];
+            record->fields |= CNStateFieldSize;
+        }
+    }
+    else if (strcmp(key, "display") == 0 && count == 1) {
+        int maximum = (displayCount < CNStateRecordMaxDisplays ? displayCount : CNStateRecordMaxDisplays) - 1;
+        if (CNStateIsInRange(values[0], 0, maximum)) {
+            record->display = (int)values[0];
+            record->fields |= CNStateFieldDisplay;
+        }
+    }
+    else if (strcmp(key, "visualEffects") == 0 && count == 1) {
+        if (CNStateIsInRange(values[0], 0, CNCompositorEffectOverlayBlack | CNCompositorEffectGaussianBlur)) {
+            record->visualEffects = (unsigned int)values[0];
+            record->fields |= CNStateFieldVisualEffects;
+        }
+    }
+    else if (strcmp(key, "animation") == 0 && count == 1) {
+        if (CNStateIsInRange(values[0], CNLayoutAnimationStatic, CNLayoutAnimationSlide)) {
+            record->animation = (CNLayoutAnimation)values[0];
+            record->fields |= CNStateFieldAnimation;
+        }
+    }
+    else if (strcmp(key, "overlayAlpha") == 0 && count == 1) {
+        /// clamped rather than skipped, an edited record still gets the nearest valid alpha
+        long long alpha = (values[0] < 0 ? 0 : (values[0] > (long long)kCNStateAlphaScale ? (long long)kCNStateAlphaScale : values[0]));
+        record->overlayAlpha = (double)alpha / kCNStateAlphaScale;
+        record->fields |= CNStateFieldOverlayAlpha;
+    }
+    else if (strcmp(key, "shadows") == 0 && count == 1) {
+        if (CNStateIsInRange(values[0], 0, 1)) {
+            record->shouldUseShadows = (values[0] == 1);
+            record->fields |= CNStateFieldShadows;
+        }
+    }
+    else if (strcmp(key, "dragged") == 0 && count == 5) {
+        if (CNStateIsInRange(values[0], 0, UINT32_MAX) && CNStateIsInRange(values[1], 0, UINT32_MAX) &&
+            CNStateIsInRange(values[2], 0, UINT32_MAX) && CNStateIsInRange(values[3], 0, CNLayoutEdgeSplitVertical)) {
+            CNDisplayIdentity display = { (uint32_t)values[0], (uint32_t)values[1], (uint32_t)values[2] };
+            if (CNStateIsInRange(values[4], 1, kCNStateMaxSize))
+                CNDraggedSizesSet(&record->draggedSizes, display, (CNLayoutEdge)values[3], (long)values[4]);
+        }
+    }
+}
+
+bool CNStateRecordDecode(CNStateRecord *record, const char *data, size_t length, int displayCount)
+{
+    CNStateRecordInit(record);
+
+    bool hasHeader = false;
+    size_t start = 0;
+    while (start < length) {
+        size_t end = start;
+        while (end < length && data[end] != '\n')
+            end++;
+
+        /// lines of any other form, including overlong ones, are skipped
+        char line[kCNStateMaxLineLength];
+        const char *key = NULL;
+        long long values[kCNStateMaxValues];
+        int count = -1;
+        if (end - start < sizeof(line) && memchr(data + start, '\0', end - start) == NULL) {
+            memcpy(line, data + start, end - start);
+            line[end - start] = '\0';
+            count = CNStateParseLine(line, &key, values);
+        }
+
+        if (!hasHeader) {
+            /// records of another version are left alone, they might mean something different
+            if (count != 1 || strcmp(key, kCNStateRecordHeader) != 0 || values[0] != CNStateRecordVersion) {
+                CNStateRecordFree(record);
+                return false;
+            }
+            hasHeader = true;
+        }
+        else if (count >= 0) {
+            CNStateDecodeLine(record, key, values, count, displayCount);
+        }
+        start = end + 1;
+    }
+    return hasHeader;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Save Scheduler
+
+void CNStateSaveSchedulerInit(CNStateSaveScheduler *scheduler, double delay)
+{
+    scheduler->delay = delay;
+    scheduler->isPending = false;
+    scheduler->tickIsScheduled = false;
+    scheduler->deadline = 0;
+}
+
+bool CNStateSaveSchedulerChange(CNStateSaveScheduler *scheduler, double now)
+{
+    /// every change moves the deadline, the tick that is already scheduled finds it and waits for the rest
+    scheduler->isPending = true;
+    scheduler->deadline = now + scheduler->delay;
+    if (scheduler->tickIsScheduled)
+        return false;
+    scheduler->tickIsScheduled = true;
+    return true;
+}
+
+CNStateSaveAction CNStateSaveSchedulerTick(CNStateSaveScheduler *scheduler, double now)
+{
+    if (!scheduler->isPending) {
+        scheduler->tickIsScheduled = false;
+        return CNStateSaveActionNone;
+    }
+    if (now < scheduler->deadline)
+        return CNStateSaveActionWait;
+
+    scheduler->isPending = false;
+    scheduler->tickIsScheduled = false;
+    return CNStateSaveActionSave;
+}
+
+bool CNStateSaveSchedulerFlush(CNStateSaveScheduler *scheduler)
+{
+    bool wasPending = scheduler->isPending;
+    scheduler->isPending = false;
+    return wasPending;
+}
+
+void CNStateSaveSchedulerReset(CNStateSaveScheduler *scheduler)
+{
+    scheduler->isPending = false;
+}
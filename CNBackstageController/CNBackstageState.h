@@ -0,0 +1,154 @@
+//
+//  CNBackstageState.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+
+#ifndef CNBackstageState_h
+#define CNBackstageState_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CNBackstageLayout.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The state record is what `CNBackstageController` hands to its state store: the configuration and the size the user
+/// has dragged on each display and edge. It is a short text, a header line with the version and one `key value...` line
+/// per field, e.g. `overlayAlpha 750000`. All values are integers, so neither the locale nor the float formatting of the
+/// platform changes a record.
+///
+/// A record of another version is rejected as a whole. Unknown keys and values out of their range are skipped on decoding,
+/// the controller keeps its current value for them. An index or an edge read from a record is never used unchecked.
+///
+/// The save scheduler decides when a changed state is written, a burst of changes results in a single write. Like the idle
+/// policy it does not read any clock on its own.
+///
+/// It is plain C and has no dependency on AppKit or Foundation.
+
+#define CNStateRecordVersion                1
+#define CNStateRecordMaxDisplays            4           // number of CNToggleDisplay values
+
+typedef enum {
+    CNStateFieldEdge            = 1 << 0,
+    CNStateFieldSize            = 1 << 1,
+    CNStateFieldDisplay         = 1 << 2,
+    CNStateFieldVisualEffects   = 1 << 3,
+    CNStateFieldAnimation       = 1 << 4,
+    CNStateFieldOverlayAlpha    = 1 << 5,
+    CNStateFieldShadows         = 1 << 6
+} CNStateField;
+
+typedef struct {
+    uint32_t vendor;                                    // display IDs may change between launches, vendor, model and
+    uint32_t model;                                     // serial number identify a display again
+    uint32_t serial;
+} CNDisplayIdentity;
+
+typedef struct {
+    CNDisplayIdentity display;
+    CNLayoutEdge edge;
+    long size;                                          // width or height of the applicationView in points, always > 0
+} CNDraggedSize;
+
+typedef struct {
+    CNDraggedSize *entries;                             // at most one entry per display and edge
+    int count;
+    int capacity;
+} CNDraggedSizes;
+
+typedef struct {
+    unsigned int fields;                                // combination of the CNStateField values that are set
+    CNLayoutEdge edge;
+    unsigned long sizeWidth;                            // a CNToggleSize value or a size in points
+    unsigned long sizeHeight;
+    int display;                                        // same values as CNToggleDisplay
+    unsigned int visualEffects;                         // combination of CNCompositorEffect values
+    CNLayoutAnimation animation;
+    double overlayAlpha;                                // 0...1
+    bool shouldUseShadows;
+    CNDraggedSizes draggedSizes;
+} CNStateRecord;
+
+typedef enum {
+    CNStateSaveActionNone = 0,                          // nothing to do
+    CNStateSaveActionSave,                              // the state has to be written now
+    CNStateSaveActionWait                               // changes are pending, tick again at `deadline`
+} CNStateSaveAction;
+
+typedef struct {
+    double delay;                                       // seconds without a change before the state is written
+    bool isPending;                                     // there are changes that aren't written yet
+    bool tickIsScheduled;
+    double deadline;
+} CNStateSaveScheduler;
+
+
+/// Returns `true` and the size dragged on `display` and `edge`, or `false` if there is none.
+extern bool CNDraggedSizesGet(const CNDraggedSizes *sizes, CNDisplayIdentity display, CNLayoutEdge edge, long *size);
+
+/// Adds or replaces the size of `display` and `edge`. Returns `false` if the size is out of range or memory is exhausted.
+extern bool CNDraggedSizesSet(CNDraggedSizes *sizes, CNDisplayIdentity display, CNLayoutEdge edge, long size);
+extern void CNDraggedSizesRemove(CNDraggedSizes *sizes, CNDisplayIdentity display, CNLayoutEdge edge);
+
+/// Replaces the content of `destination` by a copy of `source`.
+extern bool CNDraggedSizesCopy(CNDraggedSizes *destination, const CNDraggedSizes *source);
+extern void CNDraggedSizesFree(CNDraggedSizes *sizes);
+
+/// A record owns its dragged sizes, release them with `CNStateRecordFree`.
+extern void CNStateRecordInit(CNStateRecord *record);
+extern void CNStateRecordFree(CNStateRecord *record);
+
+/// Writes the set fields and the dragged sizes to `buffer`, like `snprintf` at most `bufferSize` bytes including the
+/// terminating zero. Returns the length of the whole text, so a call with a `NULL` buffer measures it.
+extern size_t CNStateRecordEncode(const CNStateRecord *record, char *buffer, size_t bufferSize);
+
+/// Decodes `length` bytes of `data`, which don't have to be zero terminated. `displayCount` is the number of displays
+/// that are online, a display index beyond is skipped. Returns `false` and an empty record if the data isn't a record of
+/// `CNStateRecordVersion`.
+extern bool CNStateRecordDecode(CNStateRecord *record, const char *data, size_t length, int displayCount);
+
+extern void CNStateSaveSchedulerInit(CNStateSaveScheduler *scheduler, double delay);
+
+/// Call this on every change of the state. Returns `true` if a tick has to be scheduled `delay` seconds from now, `false`
+/// if a scheduled tick is still to come.
+extern bool CNStateSaveSchedulerChange(CNStateSaveScheduler *scheduler, double now);
+
+/// Call this when a scheduled tick is due. On `CNStateSaveActionWait` the caller schedules the next tick at `deadline`.
+extern CNStateSaveAction CNStateSaveSchedulerTick(CNStateSaveScheduler *scheduler, double now);
+
+/// Returns `true` if changes are pending and marks them as written, e.g. before the application terminates.
+extern bool CNStateSaveSchedulerFlush(CNStateSaveScheduler *scheduler);
+
+/// Drops pending changes, e.g. when another store is assigned. A scheduled tick is still to come and will do nothing.
+extern void CNStateSaveSchedulerReset(CNStateSaveScheduler *scheduler);
+
+#endif
@@ -0,0 +1,78 @@
+//
+//  CNBackstageStateStore.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ A state store keeps the serialized state of a `CNBackstageController`, its configuration and the sizes the user has
+ chosen by dragging. The controller owns the record format, a store only has to keep the bytes. Implement this protocol
+ to persist the state somewhere else than in the user defaults, e.g. in memory for headless tests.
+ */
+@protocol CNBackstageStateStore <NSObject>
+
+/**
+ Returns the record that was given to the last `saveStateRecord:` call, or `nil` if there is none.
+
+ The controller calls this method once on the main thread when the store is assigned to its `stateStore` property.
+ */
+- (NSData *)loadStateRecord;
+
+/**
+ Replaces the stored record by `record`.
+
+ The controller calls this method on a private serial background queue. Changes are coalesced, so there is at most one
+ call for a burst of changes (e.g. while a slider is dragged).
+ */
+- (void)saveStateRecord:(NSData *)record;
+
+@end
+
+
+
+/**
+ The default state store, it keeps the record as a data object in the user defaults.
+ */
+@interface CNBackstageUserDefaultsStateStore : NSObject <CNBackstageStateStore>
+
+/**
+ Creates a store that uses `[NSUserDefaults standardUserDefaults]` and the key `CNBackstageStatePreferencesKey`.
+ */
+- (id)init;
+
+/**
+ Creates a store that uses `userDefaults` and the given key. This is the designated initializer.
+ */
+- (id)initWithUserDefaults:(NSUserDefaults *)userDefaults key:(NSString *)key;
+
+@property (strong, readonly) NSUserDefaults *userDefaults;
+@property (copy, readonly) NSString *key;
+
+@end
@@ -0,0 +1,72 @@
+//
+//  CNBackstageStateStore.m
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#import "CNBackstageStateStore.h"
+#import "CNBackstageDefinitions.h"
+
+
+@implementation CNBackstageUserDefaultsStateStore
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark - Initialization
+
+- (id)init
+{
+    return [self initWithUserDefaults:[NSUserDefaults standardUserDefaults] key:CNBackstageStatePreferencesKey];
+}
+
+- (id)initWithUserDefaults:(NSUserDefaults *)userDefaults key:(NSString *)key
+{
+    self = [super init];
+    if (self) {
+        _userDefaults = userDefaults;
+        _key = [key copy];
+    }
+    return self;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark - CNBackstageStateStore Protocol
+
+- (NSData *)loadStateRecord
+{
+    id record = [self.userDefaults objectForKey:self.key];
+    return ([record isKindOfClass:[NSData class]] ? record : nil);
+}
+
+- (void)saveStateRecord:(NSData *)record
+{
+    /// NSUserDefaults is thread safe and writes its changes to disk on its own, there is no need to synchronize
+    [self.userDefaults setObject:record forKey:self.key];
+}
+
+@end
@@ -0,0 +1,215 @@
+//
+//  CNBackstageTileDiff.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "CNBackstageTileDiff.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+static const uint64_t kCNTilePrime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t kCNTilePrime2 = 0xC2B2AE3D27D4EB4FULL;
+
+/// secrets xor'ed into the pixel data, one pair of 64 bit lanes per 16 byte stripe of a row. Stripe `n` uses
+/// `kCNTileSecrets[n & 3] + n * (kCNTilePrime1, kCNTilePrime2)`, so equal content at another position hashes differently.
+static const uint64_t kCNTileSecrets[4][2] = {
+    { 0xBE4BA423396CFEB8ULL, 0x1CAD21F72C81017CULL },
+    { 0xDB979083E96DD4DEULL, 0x1F67B3B7A4A44072ULL },
+    { 0x78E5C0CC4EE679CBULL, 0x2172FFCC7DD05A82ULL },
+    { 0x8E2443F7744608B8ULL, 0x4C263A81E69035E0ULL }
+};
+
+static const int kCNTileStripeRotation = 17;
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Hashing
+
+static inline uint64_t CNTileRotate(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/// final avalanche of the 64 bit hash, so small changes spread over all bits
+static inline uint64_t CNTileAvalanche(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= kCNTilePrime2;
+    value ^= value >> 29;
+    value *= kCNTilePrime1;
+    value ^= value >> 32;
+    return value;
+}
+
+static inline uint64_t CNTileLoad64(const uint8_t *bytes)
+{
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static inline uint32_t CNTileLoad32(const uint8_t *bytes)
+{
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+/// Hashes one row. Each 16 byte stripe is mixed into two 64 bit accumulators by a 32x32 bit multiplication of the data
+/// xor'ed with the secret of the stripe, plus the data of the other lane. The accumulators are rotated before every
+/// stripe, so the order of the stripes matters. The remaining pixels of the row are mixed in one by one.
+static uint64_t CNTileHashRow(const uint8_t *row, int byteCount)
+{
+    uint64_t accumulator[2] = { kCNTilePrime1, kCNTilePrime2 };
+    uint64_t secretOffset[2] = { 0, 0 };
+    int i = 0;
+    int stripe = 0;
+
+#if defined(__SSE2__)
+    __m128i acc = _mm_set_epi64x((long long)accumulator[1], (long long)accumulator[0]);
+    __m128i offset = _mm_setzero_si128();
+    const __m128i offsetStep = _mm_set_epi64x((long long)kCNTilePrime2, (long long)kCNTilePrime1);
+    for (; i + 16 <= byteCount; i += 16, stripe++) {
+        const uint64_t *secret = kCNTileSecrets[stripe & 3];
+        __m128i data = _mm_loadu_si128((const __m128i *)(row + i));
+        __m128i key = _mm_add_epi64(_mm_set_epi64x((long long)secret[1], (long long)secret[0]), offset);
+        __m128i dataKey = _mm_xor_si128(data, key);
+        __m128i dataKeyHigh = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+        __m128i product = _mm_mul_epu32(dataKey, dataKeyHigh);
+        __m128i dataSwap = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        acc = _mm_or_si128(_mm_slli_epi64(acc, kCNTileStripeRotation), _mm_srli_epi64(acc, 64 - kCNTileStripeRotation));
+        acc = _mm_add_epi64(acc, _mm_add_epi64(product, dataSwap));
+        offset = _mm_add_epi64(offset, offsetStep);
+    }
+    _mm_storeu_si128((__m128i *)accumulator, acc);
+    _mm_storeu_si128((__m128i *)secretOffset, offset);
+#endif
+
+    for (; i + 16 <= byteCount; i += 16, stripe++) {
+        const uint64_t *secret = kCNTileSecrets[stripe & 3];
+        uint64_t data0 = CNTileLoad64(row + i);
+        uint64_t data1 = CNTileLoad64(row + i + 8);
+        uint64_t dataKey0 = data0 ^ (secret[0] + secretOffset[0]);
+        uint64_t dataKey1 = data1 ^ (secret[1] + secretOffset[1]);
+        accumulator[0] = CNTileRotate(accumulator[0], kCNTileStripeRotation) + (dataKey0 & 0xFFFFFFFFULL) * (dataKey0 >> 32) + data1;
+        accumulator[1] = CNTileRotate(accumulator[1], kCNTileStripeRotation) + (dataKey1 & 0xFFFFFFFFULL) * (dataKey1 >> 32) + data0;
+        secretOffset[0] += kCNTilePrime1;
+        secretOffset[1] += kCNTilePrime2;
+    }
+
+    uint64_t tail = (uint64_t)byteCount * kCNTilePrime2;
+    for (; i + 4 <= byteCount; i += 4) {
+        tail = CNTileRotate(tail ^ CNTileLoad32(row + i), 23) * kCNTilePrime1;
+    }
+    return accumulator[0] ^ CNTileRotate(accumulator[1], 29) ^ tail;
+}
+
+uint64_t CNTileHash(const uint8_t *pixels, size_t bytesPerRow, int x, int y, int width, int height)
+{
+    uint64_t hash = ((uint64_t)width << 32 | (uint64_t)height) * kCNTilePrime1;
+    const uint8_t *row = pixels + (size_t)y * bytesPerRow + (size_t)x * 4;
+    for (int r = 0; r < height; r++, row += bytesPerRow) {
+        hash = CNTileAvalanche(hash ^ CNTileHashRow(row, width * 4));
+    }
+    return hash;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Tile Grid
+
+bool CNTileGridInit(CNTileGrid *grid, int width, int height, int tileSize)
+{
+    memset(grid, 0, sizeof(CNTileGrid));
+    if (width <= 0 || height <= 0 || tileSize <= 0)
+        return false;
+
+    grid->width = width;
+    grid->height = height;
+    grid->tileSize = tileSize;
+    grid->columns = (width + tileSize - 1) / tileSize;
+    grid->rows = (height + tileSize - 1) / tileSize;
+    grid->hashes = calloc((size_t)grid->columns * (size_t)grid->rows, sizeof(uint64_t));
+    grid->hasHashes = false;
+    return (grid->hashes != NULL);
+}
+
+void CNTileGridFree(CNTileGrid *grid)
+{
+    free(grid->hashes);
+    memset(grid, 0, sizeof(CNTileGrid));
+}
+
+void CNTileGridInvalidate(CNTileGrid *grid)
+{
+    grid->hasHashes = false;
+}
+
+int CNTileGridTileCount(const CNTileGrid *grid)
+{
+    return grid->columns * grid->rows;
+}
+
+void CNTileGridTileRect(const CNTileGrid *grid, int tileIndex, int *x, int *y, int *width, int *height)
+{
+    int column = tileIndex % grid->columns;
+    int row = tileIndex / grid->columns;
+    *x = column * grid->tileSize;
+    *y = row * grid->tileSize;
+    *width = (*x + grid->tileSize <= grid->width ? grid->tileSize : grid->width - *x);
+    *height = (*y + grid->tileSize <= grid->height ? grid->tileSize : grid->height - *y);
+}
+
+int CNTileGridUpdate(CNTileGrid *grid, const uint8_t *pixels, size_t bytesPerRow, int *changedTiles)
+{
+    if (grid->hashes == NULL)
+        return 0;
+
+    int changedCount = 0;
+    int tileCount = CNTileGridTileCount(grid);
+    for (int tileIndex = 0; tileIndex < tileCount; tileIndex++) {
+        int x, y, width, height;
+        CNTileGridTileRect(grid, tileIndex, &x, &y, &width, &height);
+
+        uint64_t hash = CNTileHash(pixels, bytesPerRow, x, y, width, height);
+        if (!grid->hasHashes || hash != grid->hashes[tileIndex]) {
+            grid->hashes[tileIndex] = hash;
+            changedTiles[changedCount++] = tileIndex;
+        }
+    }
+    grid->hasHashes = true;
+    return changedCount;
+}
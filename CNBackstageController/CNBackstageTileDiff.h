@@ -0,0 +1,81 @@
+//
+//  CNBackstageTileDiff.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+
+#ifndef CNBackstageTileDiff_h
+#define CNBackstageTileDiff_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A tile grid detects which parts of a repeatedly captured screen region have changed. The region is divided into
+/// square tiles, every tile is hashed on each update and compared with its hash of the previous update. Only the changed
+/// tiles have to be uploaded into the cover layers again.
+///
+/// Pixels are 32 bit (e.g. RGBA or BGRA, the channel order doesn't matter), rows top down. The hashing is SSE2
+/// accelerated where available, the scalar fallback computes identical hashes. It is plain C and has no dependency on
+/// AppKit or the window server, so it can be measured headless on synthetic frame sequences.
+
+typedef struct {
+    int width;                                          // size of the captured region in pixels
+    int height;
+    int tileSize;                                       // edge length of a tile in pixels, the last column and row may be smaller
+    int columns;
+    int rows;
+    uint64_t *hashes;                                   // one hash per tile, row by row
+    bool hasHashes;                                     // false until the first update, then all tiles are reported as changed
+} CNTileGrid;
+
+
+/// Allocates the hash table with `malloc`, release it with `CNTileGridFree`.
+extern bool CNTileGridInit(CNTileGrid *grid, int width, int height, int tileSize);
+extern void CNTileGridFree(CNTileGrid *grid);
+
+/// Forgets all hashes, so the next update reports every tile as changed.
+extern void CNTileGridInvalidate(CNTileGrid *grid);
+
+extern int CNTileGridTileCount(const CNTileGrid *grid);
+
+/// The pixel rect of the tile with index `tileIndex` (rows top down).
+extern void CNTileGridTileRect(const CNTileGrid *grid, int tileIndex, int *x, int *y, int *width, int *height);
+
+/// Hashes a new capture of the region and writes the indexes of all changed tiles to `changedTiles`, which must have room
+/// for `CNTileGridTileCount` entries. Returns the number of changed tiles.
+extern int CNTileGridUpdate(CNTileGrid *grid, const uint8_t *pixels, size_t bytesPerRow, int *changedTiles);
+
+/// Hashes a single rect of 32 bit pixels. Exposed for benchmarking.
+extern uint64_t CNTileHash(const uint8_t *pixels, size_t bytesPerRow, int x, int y, int width, int height);
+
+#endif
@@ -64,6 +64,16 @@
  */
 - (BOOL)containsDock;
 
+/**
+ Returns the frame of the Dock in screen coordinates.
+
+ The Dock's orientation is read from the Dock preferences once and cached until the screen parameters change. Its thickness
+ is derived from the visible frame of the receiver, its length from the bounds of the Dock window.
+
+ @return    The frame of the Dock, or `NSZeroRect` if the receiver doesn't contain the Dock or the Dock hides automatically.
+ */
+- (NSRect)dockFrame;
+
 /**
  Boolean value that indicates whether the current screen contains the system menu bar.
  
@@ -98,9 +108,27 @@
  
  These values are defined in the [NSBitmapImageRep Class Reference](http://developer.apple.com/library/mac/#documentation/cocoa/reference/applicationkit/classes/nsbitmapimagerep_class/reference/reference.html).
  
+ The image file type is only validated, the returned image is not encoded. Use `snapshotOfType:region:scale:completionHandler:`
+ to get the encoded image data.
+ 
+ @return    An autoreleased `CGImageRef`, or `NULL` if the image file type is unknown.
  */
 - (CGImageRef)snapshotOfType:(NSBitmapImageFileType)imageFileType;
 
+/**
+ Takes a snapshot of the screen and encodes it with given image file type in the background.
+ 
+ The screen is captured before this method returns, only scaling and encoding happen on a serial background queue. PNG
+ images are streamed in bands of rows into a `CNBackstageImageEncoder` whose buffers are reused by all snapshots, all other
+ image file types are encoded by `NSBitmapImageRep`.
+ 
+ @param     imageFileType       The image file type of the data, see `snapshotOfType:` for the allowed values.
+ @param     region              The captured region in screen coordinates, or `NSZeroRect` for the whole screen. It is clipped to the frame of the receiver.
+ @param     scale               A factor between 0 and 1 the snapshot is scaled down with, `1.0` keeps the pixel resolution of the display.
+ @param     completionHandler   Called on the main queue with the encoded image data, or `nil` if the snapshot failed.
+ */
+- (void)snapshotOfType:(NSBitmapImageFileType)imageFileType region:(NSRect)region scale:(CGFloat)scale completionHandler:(void(^)(NSData *imageData))completionHandler;
+
 /**
  Returns the file path of the current desktop image.
  
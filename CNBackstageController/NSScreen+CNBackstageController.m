@@ -29,6 +29,8 @@
  */
 
 #import "NSScreen+CNBackstageController.h"
+#import "CNBackstageDockPolicy.h"
+#import "CNBackstageImageEncoder.h"
 
 
 static NSString *kDefaultsDockDomainKey     = @"com.apple.dock";
@@ -36,17 +38,28 @@ static NSString *kDefaultsDesktopDomainKey  = @"com.apple.desktop";
 static NSString *kNSScreenNumberKey         = @"NSScreenNumber";
 static NSString *kImageFilePathKey          = @"ImageFilePath";
 
-enum {
-    CNDockOrientationLeft = 0,
-    CNDockOrientationRight,
-    CNDockOrientationBottom
-};
-typedef NSUInteger CNDockOrientation;
+static NSString *kDockProcessName           = @"Dock";
+
+static CNDockOrientation cachedDockOrientation = CNDockOrientationBottom;
+static BOOL dockOrientationIsCached = NO;
+
+static const size_t kSnapshotBandRows       = 64;
+
+/// only accessed on the snapshot encoder queue
+static CNImageEncoder *snapshotEncoder = NULL;
+static void *snapshotBandBuffer = NULL;
+static size_t snapshotBandBufferLength = 0;
 
 
 @interface NSScreen (CNBackstageControllerExtension)
 + (CNDockOrientation)dockOrientation;
 + (NSArray*)dockOrientations;
+- (NSRect)dockWindowFrame;
++ (dispatch_queue_t)snapshotEncoderQueue;
++ (BOOL)isSnapshotFileType:(NSBitmapImageFileType)imageFileType;
+- (CGImageRef)createSnapshotImageOfRegion:(NSRect)region;
++ (CGImageRef)createImageWithImage:(CGImageRef)image scale:(CGFloat)scale;
++ (NSData*)PNGDataOfImage:(CGImageRef)image scale:(CGFloat)scale;
 @end
 
 
@@ -93,15 +106,25 @@ typedef NSUInteger CNDockOrientation;
 {
     NSRect totalFrame = [self frame];
     NSRect visibleFrame = [self visibleFrame];
-    int statusBarThickness = (self.isMainScreen ? [[NSStatusBar systemStatusBar] thickness] : 0);
-    BOOL result = YES;
-    
-    switch ([NSScreen dockOrientation]) {
-        case CNDockOrientationLeft:
-        case CNDockOrientationRight:    result = (NSWidth(visibleFrame) == NSWidth(totalFrame) ? NO : YES); break;
-        case CNDockOrientationBottom:   result = (NSHeight(visibleFrame) == (NSHeight(totalFrame) - statusBarThickness) ? NO : YES); break;
-    }
-    return result;
+    CNLayoutRect dockRect = CNDockRect([NSScreen dockOrientation],
+                                       CNLayoutRectMake(NSMinX(totalFrame), NSMinY(totalFrame), NSWidth(totalFrame), NSHeight(totalFrame)),
+                                       CNLayoutRectMake(NSMinX(visibleFrame), NSMinY(visibleFrame), NSWidth(visibleFrame), NSHeight(visibleFrame)));
+    return (dockRect.width > 0 && dockRect.height > 0);
+}
+
+- (NSRect)dockFrame
+{
+    NSRect totalFrame = [self frame];
+    NSRect visibleFrame = [self visibleFrame];
+    CNLayoutRect dockRect = CNDockRect([NSScreen dockOrientation],
+                                       CNLayoutRectMake(NSMinX(totalFrame), NSMinY(totalFrame), NSWidth(totalFrame), NSHeight(totalFrame)),
+                                       CNLayoutRectMake(NSMinX(visibleFrame), NSMinY(visibleFrame), NSWidth(visibleFrame), NSHeight(visibleFrame)));
+    if (dockRect.width <= 0 || dockRect.height <= 0)
+        return NSZeroRect;
+
+    NSRect windowFrame = [self dockWindowFrame];
+    dockRect = CNDockRectWithWindowBounds(dockRect, CNLayoutRectMake(NSMinX(windowFrame), NSMinY(windowFrame), NSWidth(windowFrame), NSHeight(windowFrame)));
+    return NSMakeRect(NSMinX(totalFrame) + dockRect.x, NSMinY(totalFrame) + dockRect.y, dockRect.width, dockRect.height);
 }
 
 - (BOOL)containsMenuBar
@@ -128,12 +151,9 @@ typedef NSUInteger CNDockOrientation;
             case NSJPEGFileType:
             case NSPNGFileType:
             case NSJPEG2000FileType: {
-                CGDirectDisplayID displayID = (CGDirectDisplayID)[[[self deviceDescription] valueForKey:kNSScreenNumberKey] unsignedIntValue];
-                CGRect rect = NSRectToCGRect([self frame]);
-                rect.origin = CGPointMake(0, 0);
-                CGImageRef snapshotImageRef = CGDisplayCreateImageForRect(displayID, rect);
-                NSBitmapImageRep *snapshot = [[NSBitmapImageRep alloc] initWithCGImage:snapshotImageRef];
-                return [snapshot CGImage];
+                /// the created image is handed over to the autorelease pool, the caller doesn't own it
+                __autoreleasing id snapshot = CFBridgingRelease([self createSnapshotImageOfRegion:[self frame]]);
+                return (__bridge CGImageRef)snapshot;
                 break;
             }
                 
@@ -152,6 +172,43 @@ typedef NSUInteger CNDockOrientation;
     return NULL;
 }
 
+- (void)snapshotOfType:(NSBitmapImageFileType)imageFileType region:(NSRect)region scale:(CGFloat)scale completionHandler:(void(^)(NSData *imageData))completionHandler
+{
+    if (![NSScreen isSnapshotFileType:imageFileType]) {
+        NSLog(@"ERROR: The given bitmap image file type is unknown (%li).", imageFileType);
+        if (completionHandler)
+            completionHandler(nil);
+        return;
+    }
+
+    /// capture now, so the snapshot shows the screen at the time of the call, and encode in the background
+    CGImageRef snapshotImageRef = [self createSnapshotImageOfRegion:(NSIsEmptyRect(region) ? [self frame] : region)];
+    scale = (scale <= 0 || scale > 1 ? 1 : scale);
+
+    dispatch_async([NSScreen snapshotEncoderQueue], ^{
+        NSData *imageData = nil;
+        if (snapshotImageRef != NULL) {
+            if (imageFileType == NSPNGFileType) {
+                imageData = [NSScreen PNGDataOfImage:snapshotImageRef scale:scale];
+            } else {
+                CGImageRef scaledImageRef = [NSScreen createImageWithImage:snapshotImageRef scale:scale];
+                if (scaledImageRef != NULL) {
+                    NSBitmapImageRep *snapshot = [[NSBitmapImageRep alloc] initWithCGImage:scaledImageRef];
+                    imageData = [snapshot representationUsingType:imageFileType properties:[NSDictionary dictionary]];
+                    CGImageRelease(scaledImageRef);
+                }
+            }
+            CGImageRelease(snapshotImageRef);
+        }
+
+        if (completionHandler) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completionHandler(imageData);
+            });
+        }
+    });
+}
+
 - (NSString*)desktopImageFilePath
 {
     NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
@@ -172,11 +229,162 @@ typedef NSUInteger CNDockOrientation;
 
 + (CNDockOrientation)dockOrientation
 {
-    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
-    NSDictionary *dockDefaults = [defaults persistentDomainForName:kDefaultsDockDomainKey];
-    return [self.dockOrientations indexOfObject:[dockDefaults valueForKey:@"orientation"]];
+    /// reading the Dock preferences hits the disk, a changed orientation changes the visible frames of the screens as well
+    static dispatch_once_t predicate;
+    dispatch_once(&predicate, ^{
+        [[NSNotificationCenter defaultCenter] addObserverForName:NSApplicationDidChangeScreenParametersNotification object:nil queue:nil usingBlock:^(NSNotification *note) {
+            dockOrientationIsCached = NO;
+        }];
+    });
+
+    if (!dockOrientationIsCached) {
+        NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+        NSDictionary *dockDefaults = [defaults persistentDomainForName:kDefaultsDockDomainKey];
+        NSUInteger orientation = [self.dockOrientations indexOfObject:[dockDefaults valueForKey:@"orientation"]];
+        /// without an orientation entry the Dock is at the bottom
+        cachedDockOrientation = (orientation == NSNotFound ? CNDockOrientationBottom : (CNDockOrientation)orientation);
+        dockOrientationIsCached = YES;
+    }
+    return cachedDockOrientation;
 }
 
 + (NSArray*)dockOrientations { return [NSArray arrayWithObjects:@"left", @"right", @"bottom", nil]; }
 
+- (NSRect)dockWindowFrame
+{
+    NSRect result = NSZeroRect;
+    NSRect screenFrame = [self frame];
+    /// window bounds have their origin in the top left corner of the primary screen
+    CGFloat primaryScreenHeight = NSHeight([[[NSScreen screens] objectAtIndex:0] frame]);
+    CGWindowLevel dockWindowLevel = CGWindowLevelForKey(kCGDockWindowLevelKey);
+
+    CFArrayRef windowList = CGWindowListCopyWindowInfo(kCGWindowListOptionOnScreenOnly | kCGWindowListExcludeDesktopElements, kCGNullWindowID);
+    if (windowList == NULL)
+        return result;
+
+    for (NSDictionary *windowInfo in (__bridge NSArray *)windowList) {
+        if (![[windowInfo objectForKey:(__bridge NSString *)kCGWindowOwnerName] isEqualToString:kDockProcessName] ||
+            [[windowInfo objectForKey:(__bridge NSString *)kCGWindowLayer] intValue] != dockWindowLevel)
+            continue;
+
+        CGRect bounds;
+        if (!CGRectMakeWithDictionaryRepresentation((__bridge CFDictionaryRef)[windowInfo objectForKey:(__bridge NSString *)kCGWindowBounds], &bounds))
+            continue;
+
+        NSRect windowFrame = NSMakeRect(CGRectGetMinX(bounds), primaryScreenHeight - CGRectGetMaxY(bounds), CGRectGetWidth(bounds), CGRectGetHeight(bounds));
+        if (NSIntersectsRect(windowFrame, screenFrame)) {
+            result = NSOffsetRect(windowFrame, -NSMinX(screenFrame), -NSMinY(screenFrame));
+            break;
+        }
+    }
+    CFRelease(windowList);
+    return result;
+}
+
++ (dispatch_queue_t)snapshotEncoderQueue
+{
+    /// serial, so all snapshots share one encoder and its buffers
+    static dispatch_queue_t snapshotEncoderQueue = NULL;
+    static dispatch_once_t predicate;
+    dispatch_once(&predicate, ^{
+        snapshotEncoderQueue = dispatch_queue_create("com.cocoanaut.CNBackstageController.snapshotEncoder", DISPATCH_QUEUE_SERIAL);
+    });
+    return snapshotEncoderQueue;
+}
+
++ (BOOL)isSnapshotFileType:(NSBitmapImageFileType)imageFileType
+{
+    switch (imageFileType) {
+        case NSTIFFFileType:
+        case NSBMPFileType:
+        case NSGIFFileType:
+        case NSJPEGFileType:
+        case NSPNGFileType:
+        case NSJPEG2000FileType:
+            return YES;
+        default:
+            return NO;
+    }
+}
+
+- (CGImageRef)createSnapshotImageOfRegion:(NSRect)region
+{
+    /// display coordinates have their origin in the top left corner of the display
+    NSRect screenFrame = [self frame];
+    region = NSIntersectionRect(region, screenFrame);
+    if (NSIsEmptyRect(region))
+        return NULL;
+
+    CGDirectDisplayID displayID = (CGDirectDisplayID)[[[self deviceDescription] valueForKey:kNSScreenNumberKey] unsignedIntValue];
+    CGRect rect = CGRectMake(NSMinX(region) - NSMinX(screenFrame), NSMaxY(screenFrame) - NSMaxY(region), NSWidth(region), NSHeight(region));
+    return CGDisplayCreateImageForRect(displayID, rect);
+}
+
++ (CGImageRef)createImageWithImage:(CGImageRef)image scale:(CGFloat)scale
+{
+    if (scale >= 1)
+        return CGImageRetain(image);
+
+    size_t width = MAX(1, (size_t)round(CGImageGetWidth(image) * scale));
+    size_t height = MAX(1, (size_t)round(CGImageGetHeight(image) * scale));
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, width * 4, colorSpace, kCGImageAlphaNoneSkipLast | kCGBitmapByteOrder32Big);
+    CGColorSpaceRelease(colorSpace);
+    if (context == NULL)
+        return NULL;
+
+    CGContextSetInterpolationQuality(context, kCGInterpolationHigh);
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+    CGImageRef result = CGBitmapContextCreateImage(context);
+    CGContextRelease(context);
+    return result;
+}
+
++ (NSData*)PNGDataOfImage:(CGImageRef)image scale:(CGFloat)scale
+{
+    /// The image is drawn in bands of a few rows into a reused bitmap, which also scales it and converts whatever the
+    /// display delivers into 8 bit RGBX. Each band is streamed into the encoder, so there is never a full size copy.
+    size_t width = MAX(1, (size_t)round(CGImageGetWidth(image) * scale));
+    size_t height = MAX(1, (size_t)round(CGImageGetHeight(image) * scale));
+    size_t bytesPerRow = width * 4;
+    size_t bandRows = MIN(kSnapshotBandRows, height);
+    if (width > INT_MAX || height > INT_MAX)
+        return nil;
+
+    if (snapshotEncoder == NULL)
+        snapshotEncoder = CNImageEncoderCreate();
+    if (snapshotEncoder == NULL)
+        return nil;
+    if (snapshotBandBufferLength < bytesPerRow * bandRows) {
+        void *bandBuffer = realloc(snapshotBandBuffer, bytesPerRow * bandRows);
+        if (bandBuffer == NULL)
+            return nil;
+        snapshotBandBuffer = bandBuffer;
+        snapshotBandBufferLength = bytesPerRow * bandRows;
+    }
+
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(snapshotBandBuffer, width, bandRows, 8, bytesPerRow, colorSpace, kCGImageAlphaNoneSkipLast | kCGBitmapByteOrder32Big);
+    CGColorSpaceRelease(colorSpace);
+    if (context == NULL)
+        return nil;
+    CGContextSetInterpolationQuality(context, kCGInterpolationHigh);
+    CGContextSetBlendMode(context, kCGBlendModeCopy);
+
+    CNImageEncoderParameters parameters;
+    CNImageEncoderDefaultParameters(&parameters, (int)width, (int)height);
+    BOOL success = CNImageEncoderBegin(snapshotEncoder, &parameters);
+    for (size_t row = 0; success && row < height; row += bandRows) {
+        /// the bitmap context has its origin at the bottom, move the image up until the current band is at its top
+        CGContextDrawImage(context, CGRectMake(0, (CGFloat)bandRows - height + row, width, height), image);
+        success = CNImageEncoderAppendRows(snapshotEncoder, snapshotBandBuffer, bytesPerRow, (int)MIN(bandRows, height - row));
+    }
+    CGContextRelease(context);
+
+    size_t length = 0;
+    const uint8_t *bytes = (success ? CNImageEncoderFinish(snapshotEncoder, &length) : NULL);
+    /// the encoder keeps its buffer for the next snapshot
+    return (bytes != NULL ? [NSData dataWithBytes:bytes length:length] : nil);
+}
+
 @end
@@ -50,6 +50,9 @@
     self.backstageController.shouldUseShadows = NO;
 //    self.backstageController.shadowIntensity = CNShadowIntensityLighter;
     [self configureBackstageController];
+
+    /// the stored state of the last launch wins over the defaults from above
+    self.backstageController.stateStore = [[CNBackstageUserDefaultsStateStore alloc] init];
 }
 
 - (void)configureBackstageController
@@ -84,7 +87,6 @@
     if ([self.backstageController currentViewState] == CNToggleStateExpanded) {
         [self.backstageController collapse];
     }
-    [self configureBackstageController];
 }
 
 - (void)backstageControllerNotification:(NSNotification *)notification
@@ -8,13 +8,15 @@
 
 #import <Cocoa/Cocoa.h>
 
+@class CNBackstageController;
+
 @interface PreferencesController : NSWindowController <NSToolbarDelegate> {
     IBOutlet NSView         *contentView;
     IBOutlet NSToolbarItem  *toolbarItemAppBehavior;
     IBOutlet NSView         *viewAppBehavior;
 }
 
-@property (nonatomic, strong) NSUserDefaults *userDefaults;
+@property (nonatomic, strong) CNBackstageController *backstageController;
 
 @property (nonatomic, strong) IBOutlet NSTextField *toggleEdgeLabel;
 @property (nonatomic, strong) IBOutlet NSPopUpButton *toggleEdgePopupButton;
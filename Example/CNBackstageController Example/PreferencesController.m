@@ -118,19 +118,21 @@ typedef enum {
 // ---------------------------------------------------------------------------------------------------------------------
 
 - (void)restorePreferences {
-    self.userDefaults = [NSUserDefaults standardUserDefaults];
-    [self.toggleEdgePopupButton selectItemAtIndex:[self.userDefaults integerForKey:CNToggleEdgePreferencesKey]];
-    [self.toggleDisplayPopupButton selectItemAtIndex:[self.userDefaults integerForKey:CNToggleDisplayPreferencesKey]];
+    /// the backstage controller persists its configuration on its own
+    self.backstageController = [CNBackstageController sharedInstance];
+    [self.toggleEdgePopupButton selectItemAtIndex:self.backstageController.toggleEdge];
+    [self.toggleDisplayPopupButton selectItemAtIndex:self.backstageController.toggleDisplay];
     
-    [self.toggleSizeWidthPopupButton selectItemAtIndex:[self.userDefaults integerForKey:CNToggleSizeWidthPreferencesKey]];
-    [self.toggleSizeHeightPopupButton selectItemAtIndex:[self.userDefaults integerForKey:CNToggleSizeHeightPreferencesKey]];
+    [self.toggleSizeWidthPopupButton selectItemAtIndex:self.backstageController.toggleSize.width];
+    [self.toggleSizeHeightPopupButton selectItemAtIndex:self.backstageController.toggleSize.height];
 
-    self.visualEffectBlackOverlayCheckbox.state = ([self.userDefaults integerForKey:CNToggleVisualEffectPreferencesKey] & CNToggleVisualEffectOverlayBlack);
+    self.visualEffectBlackOverlayCheckbox.state = ((self.backstageController.toggleVisualEffect & CNToggleVisualEffectOverlayBlack) ? NSOnState : NSOffState);
     [self.alphaValueSlider setEnabled:(self.visualEffectBlackOverlayCheckbox.state == NSOnState)];
-    self.visualEffectGaussianBlurCheckbox.state = ([self.userDefaults integerForKey:CNToggleVisualEffectPreferencesKey] & CNToggleVisualEffectGaussianBlur);
+    self.visualEffectGaussianBlurCheckbox.state = ((self.backstageController.toggleVisualEffect & CNToggleVisualEffectGaussianBlur) ? NSOnState : NSOffState);
 
-    [self.animationEffectPopupButton selectItemAtIndex:[self.userDefaults integerForKey:CNToggleAnimationEffectPreferencesKey]];
-    self.alphaValueSlider.integerValue = [self.userDefaults integerForKey:CNToggleAlphaValuePreferencesKey];
+    [self.animationEffectPopupButton selectItemAtIndex:self.backstageController.toggleAnimationEffect];
+    self.alphaValueSlider.integerValue = round(self.backstageController.overlayAlpha * 100);
+    self.useShadowsCheckbox.state = (self.backstageController.shouldUseShadows ? NSOnState : NSOffState);
 }
 
 - (void)defaultsChangedNotification
@@ -146,7 +148,7 @@ typedef enum {
 - (IBAction)preferencesChangedAction:(id)sender
 {
 
-    NSUInteger visualEffects = [self.userDefaults integerForKey:CNToggleVisualEffectPreferencesKey];
+    NSUInteger visualEffects = self.backstageController.toggleVisualEffect;
     if (sender == self.visualEffectBlackOverlayCheckbox) {
         switch (self.visualEffectBlackOverlayCheckbox.state) {
             case NSOnState: visualEffects |= CNToggleVisualEffectOverlayBlack; break;
@@ -160,32 +162,33 @@ typedef enum {
             case NSOffState: visualEffects &= ~CNToggleVisualEffectGaussianBlur; break;
         }
     }
-    [self.userDefaults setInteger:visualEffects forKey:CNToggleVisualEffectPreferencesKey];
+    /// the view has to disappear before its configuration changes
+    [[NSNotificationCenter defaultCenter] postNotificationName:kDefaultsChangedNotificationKey object:nil];
+
+    /// the backstage controller writes all changes at once on a background queue, no need to synchronize anything here
+    self.backstageController.toggleVisualEffect = visualEffects;
 
     if (sender == self.toggleEdgePopupButton) {
-        [self.userDefaults setInteger:[self.toggleEdgePopupButton indexOfSelectedItem] forKey:CNToggleEdgePreferencesKey];
+        self.backstageController.toggleEdge = [self.toggleEdgePopupButton indexOfSelectedItem];
     }
     else if (sender == self.toggleDisplayPopupButton) {
-        [self.userDefaults setInteger:[self.toggleDisplayPopupButton indexOfSelectedItem] forKey:CNToggleDisplayPreferencesKey];
+        self.backstageController.toggleDisplay = [self.toggleDisplayPopupButton indexOfSelectedItem];
     }
     else if (sender == self.toggleSizeWidthPopupButton) {
-        [self.userDefaults setInteger:[self.toggleSizeWidthPopupButton indexOfSelectedItem] forKey:CNToggleSizeWidthPreferencesKey];
+        self.backstageController.toggleSize = CNMakeToggleSize([self.toggleSizeWidthPopupButton indexOfSelectedItem], self.backstageController.toggleSize.height);
     }
     else if (sender == self.toggleSizeHeightPopupButton) {
-        [self.userDefaults setInteger:[self.toggleSizeHeightPopupButton indexOfSelectedItem] forKey:CNToggleSizeHeightPreferencesKey];
+        self.backstageController.toggleSize = CNMakeToggleSize(self.backstageController.toggleSize.width, [self.toggleSizeHeightPopupButton indexOfSelectedItem]);
     }
     else if (sender == self.animationEffectPopupButton) {
-        [self.userDefaults setInteger:[self.animationEffectPopupButton indexOfSelectedItem] forKey:CNToggleAnimationEffectPreferencesKey];
+        self.backstageController.toggleAnimationEffect = [self.animationEffectPopupButton indexOfSelectedItem];
     }
     else if (sender == self.alphaValueSlider) {
-        [self.userDefaults setInteger:self.alphaValueSlider.integerValue forKey:CNToggleAlphaValuePreferencesKey];
+        self.backstageController.overlayAlpha = self.alphaValueSlider.integerValue * 0.01;
     }
     else if (sender == self.useShadowsCheckbox) {
-        [self.userDefaults setBool:self.useShadowsCheckbox.state forKey:CNToggleUseShadowsPreferencesKey];
+        self.backstageController.shouldUseShadows = (self.useShadowsCheckbox.state == NSOnState);
     }
-    [self.userDefaults synchronize];
-
-    [[NSNotificationCenter defaultCenter] postNotificationName:kDefaultsChangedNotificationKey object:nil];
 }
 
 - (IBAction)changeView:(id)sender {
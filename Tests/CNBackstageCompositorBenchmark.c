@@ -0,0 +1,97 @@
+//
+//  CNBackstageCompositorBenchmark.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+#include "CNTestSupport.h"
+#include "CNBackstageCompositor.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Measures `CNCompositorRenderFrame` on a 2880x1800 Retina capture for every animation and visual effect combination, with
+/// the application view half way in on the left edge. The cost is reported per output pixel, so it can be compared across
+/// display sizes and serves as the baseline for rendering optimizations.
+
+static const int kCNBenchmarkWidth      = 2880;
+static const int kCNBenchmarkHeight     = 1800;
+static const int kCNBenchmarkFrames     = 5;
+
+static const char *kCNBenchmarkAnimationNames[] = { "static", "fade", "slide" };
+static const char *kCNBenchmarkEffectNames[] = { "none", "overlay", "blur", "overlay+blur" };
+
+int main(void)
+{
+    CNPixelBuffer snapshot, applicationImage, output;
+    if (!CNPixelBufferAlloc(&snapshot, kCNBenchmarkWidth, kCNBenchmarkHeight) ||
+        !CNPixelBufferAlloc(&applicationImage, kCNBenchmarkWidth, kCNBenchmarkHeight) ||
+        !CNPixelBufferAlloc(&output, kCNBenchmarkWidth, kCNBenchmarkHeight))
+        return EXIT_FAILURE;
+
+    uint32_t seed = 1;
+    for (int y = 0; y < kCNBenchmarkHeight; y++) {
+        uint8_t *pixel = snapshot.data + (size_t)y * snapshot.bytesPerRow;
+        uint8_t *applicationPixel = applicationImage.data + (size_t)y * applicationImage.bytesPerRow;
+        for (int x = 0; x < kCNBenchmarkWidth; x++, pixel += 4, applicationPixel += 4) {
+            pixel[0] = (uint8_t)CNTestRandom(&seed);
+            pixel[1] = (uint8_t)(y * 255 / kCNBenchmarkHeight);
+            pixel[2] = (uint8_t)(x * 255 / kCNBenchmarkWidth);
+            pixel[3] = 255;
+            applicationPixel[0] = 40;
+            applicationPixel[1] = (uint8_t)(y & 0xff);
+            applicationPixel[2] = 200;
+            applicationPixel[3] = 255;
+        }
+    }
+
+    double pixelCount = (double)kCNBenchmarkWidth * kCNBenchmarkHeight;
+    printf("compositor %dx%d, left edge, half way in\n", kCNBenchmarkWidth, kCNBenchmarkHeight);
+    for (int animation = CNLayoutAnimationStatic; animation <= CNLayoutAnimationSlide; animation++) {
+        for (unsigned int visualEffects = 0; visualEffects <= (CNCompositorEffectOverlayBlack | CNCompositorEffectGaussianBlur); visualEffects++) {
+            CNCompositorParameters parameters;
+            CNCompositorDefaultParameters(&parameters);
+            parameters.edge = CNLayoutEdgeLeft;
+            parameters.animation = (CNLayoutAnimation)animation;
+            parameters.visualEffects = visualEffects;
+            parameters.thickness = kCNBenchmarkWidth / 4;
+            CNCompositorFrame frame = { CNCompositorPhaseExpand, parameters.duration / 2, 0 };
+
+            double start = CNTestNow();
+            for (int i = 0; i < kCNBenchmarkFrames; i++) {
+                if (!CNCompositorRenderFrame(&parameters, &frame, &snapshot, &applicationImage, &output))
+                    return EXIT_FAILURE;
+            }
+            double frameTime = (CNTestNow() - start) / kCNBenchmarkFrames;
+            printf("  %-7s %-13s %7.2f ms  %6.2f ns/pixel\n", kCNBenchmarkAnimationNames[animation], kCNBenchmarkEffectNames[visualEffects],
+                   frameTime * 1e3, frameTime * 1e9 / pixelCount);
+        }
+    }
+
+    CNPixelBufferFree(&snapshot);
+    CNPixelBufferFree(&applicationImage);
+    CNPixelBufferFree(&output);
+    return EXIT_SUCCESS;
+}
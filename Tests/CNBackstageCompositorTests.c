@@ -0,0 +1,223 @@
+//
+//  CNBackstageCompositorTests.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CNTestSupport.h"
+#include "CNTestImage.h"
+#include <string.h>
+#include "CNBackstageCompositor.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Frames of a small synthetic screen are compared against the golden images in `Golden/`. The blur and the shadows use
+/// floating point math, so a channel may differ by `kCNGoldenTolerance`. After an intended change of the rendering, run
+/// the tests once with `CN_UPDATE_GOLDEN_IMAGES=1` set and review the written images before committing them.
+
+static const int kCNGoldenWidth     = 160;
+static const int kCNGoldenHeight    = 100;
+static const int kCNGoldenTolerance = 2;
+
+typedef struct {
+    const char *name;
+    CNLayoutEdge edge;
+    CNLayoutAnimation animation;
+    unsigned int visualEffects;
+    bool shouldUseShadows;
+    CNCompositorFrame frame;
+} CNGoldenFrame;
+
+static const CNGoldenFrame kCNGoldenFrames[] = {
+    { "expand-left-slide-blur",     CNLayoutEdgeLeft,               CNLayoutAnimationSlide,     CNCompositorEffectOverlayBlack | CNCompositorEffectGaussianBlur, true,  { CNCompositorPhaseExpand, 0.21, 0 } },
+    { "expand-top-fade-overlay",    CNLayoutEdgeTop,                CNLayoutAnimationFade,      CNCompositorEffectOverlayBlack,                                  true,  { CNCompositorPhaseExpand, 0.1, 0 } },
+    { "expanded-bottom-static",     CNLayoutEdgeBottom,             CNLayoutAnimationStatic,    CNCompositorEffectOverlayBlack,                                  true,  { CNCompositorPhaseExpand, 1.0, 0 } },
+    { "collapse-right-slide",       CNLayoutEdgeRight,              CNLayoutAnimationSlide,     0,                                                               false, { CNCompositorPhaseCollapse, 0.1, 0 } },
+    { "drag-top-slide",             CNLayoutEdgeTop,                CNLayoutAnimationSlide,     CNCompositorEffectOverlayBlack,                                  true,  { CNCompositorPhaseDrag, 0, 12 } },
+    { "expand-split-horizontal",    CNLayoutEdgeSplitHorizontal,    CNLayoutAnimationSlide,     CNCompositorEffectOverlayBlack | CNCompositorEffectGaussianBlur, true,  { CNCompositorPhaseExpand, 0.3, 0 } },
+    { "expand-split-vertical",      CNLayoutEdgeSplitVertical,      CNLayoutAnimationSlide,     CNCompositorEffectOverlayBlack,                                  true,  { CNCompositorPhaseExpand, 0.3, 0 } }
+};
+
+/// a gradient with a checkerboard, so offsets, blur and overlay are all visible
+static void CNTestFillSnapshot(CNPixelBuffer *snapshot)
+{
+    for (int y = 0; y < snapshot->height; y++) {
+        uint8_t *pixel = snapshot->data + (size_t)y * snapshot->bytesPerRow;
+        for (int x = 0; x < snapshot->width; x++, pixel += 4) {
+            pixel[0] = (uint8_t)(x * 255 / snapshot->width);
+            pixel[1] = (uint8_t)(y * 255 / snapshot->height);
+            pixel[2] = (uint8_t)((((x / 10) + (y / 10)) & 1) * 255);
+            pixel[3] = 255;
+        }
+    }
+}
+
+static void CNTestFillApplicationImage(CNPixelBuffer *applicationImage)
+{
+    for (int y = 0; y < applicationImage->height; y++) {
+        uint8_t *pixel = applicationImage->data + (size_t)y * applicationImage->bytesPerRow;
+        for (int x = 0; x < applicationImage->width; x++, pixel += 4) {
+            pixel[0] = 40;
+            pixel[1] = (uint8_t)(120 + (y % 16) * 4);
+            pixel[2] = 200;
+            pixel[3] = 255;
+        }
+    }
+}
+
+static void testGoldenFrames(void)
+{
+    CNPixelBuffer snapshot, applicationImage, output;
+    CNAssert(CNPixelBufferAlloc(&snapshot, kCNGoldenWidth, kCNGoldenHeight));
+    CNAssert(CNPixelBufferAlloc(&applicationImage, kCNGoldenWidth, kCNGoldenHeight));
+    CNAssert(CNPixelBufferAlloc(&output, kCNGoldenWidth, kCNGoldenHeight));
+    CNTestFillSnapshot(&snapshot);
+    CNTestFillApplicationImage(&applicationImage);
+
+    const char *update = getenv("CN_UPDATE_GOLDEN_IMAGES");
+    bool shouldUpdate = (update != NULL && strcmp(update, "1") == 0);
+
+    for (size_t i = 0; i < sizeof(kCNGoldenFrames) / sizeof(kCNGoldenFrames[0]); i++) {
+        const CNGoldenFrame *golden = &kCNGoldenFrames[i];
+        CNCompositorParameters parameters;
+        CNCompositorDefaultParameters(&parameters);
+        parameters.edge = golden->edge;
+        parameters.animation = golden->animation;
+        parameters.visualEffects = golden->visualEffects;
+        parameters.shouldUseShadows = golden->shouldUseShadows;
+        parameters.thickness = 48;
+
+        CNAssert(CNCompositorRenderFrame(&parameters, &golden->frame, &snapshot, &applicationImage, &output));
+
+        char path[256];
+        snprintf(path, sizeof(path), "Golden/%s.png", golden->name);
+        if (shouldUpdate) {
+            CNAssert(CNCompositorWritePNG(&output, path));
+            continue;
+        }
+
+        CNPixelBuffer reference;
+        bool hasReference = CNTestReadPNG(path, &reference);
+        if (!hasReference) {
+            fprintf(stderr, "missing golden image %s\n", path);
+            CNTestFailures++;
+            continue;
+        }
+        long differences = CNTestCompareImages(&output, &reference, kCNGoldenTolerance);
+        if (differences != 0) {
+            fprintf(stderr, "%s differs from its golden image in %ld pixels\n", golden->name, differences);
+            CNTestFailures++;
+        }
+        CNPixelBufferFree(&reference);
+    }
+
+    CNPixelBufferFree(&snapshot);
+    CNPixelBufferFree(&applicationImage);
+    CNPixelBufferFree(&output);
+}
+
+static void testFramesDiffer(void)
+{
+    /// guards against golden images that all show the same, e.g. an empty, frame
+    CNPixelBuffer snapshot, expandFrame, expandedFrame;
+    CNAssert(CNPixelBufferAlloc(&snapshot, kCNGoldenWidth, kCNGoldenHeight));
+    CNAssert(CNPixelBufferAlloc(&expandFrame, kCNGoldenWidth, kCNGoldenHeight));
+    CNAssert(CNPixelBufferAlloc(&expandedFrame, kCNGoldenWidth, kCNGoldenHeight));
+    CNTestFillSnapshot(&snapshot);
+
+    CNCompositorParameters parameters;
+    CNCompositorDefaultParameters(&parameters);
+    parameters.edge = CNLayoutEdgeLeft;
+    parameters.animation = CNLayoutAnimationSlide;
+    parameters.thickness = 48;
+
+    CNCompositorFrame frame = { CNCompositorPhaseExpand, 0.1, 0 };
+    CNAssert(CNCompositorRenderFrame(&parameters, &frame, &snapshot, NULL, &expandFrame));
+    frame.time = parameters.duration;
+    CNAssert(CNCompositorRenderFrame(&parameters, &frame, &snapshot, NULL, &expandedFrame));
+    CNAssert(CNTestCompareImages(&expandFrame, &expandedFrame, kCNGoldenTolerance) > 0);
+    CNAssert(CNTestCompareImages(&expandFrame, &snapshot, kCNGoldenTolerance) > 0);
+
+    CNPixelBufferFree(&snapshot);
+    CNPixelBufferFree(&expandFrame);
+    CNPixelBufferFree(&expandedFrame);
+}
+
+static void testRowKernelsMatchPerPixel(void)
+{
+    /// an odd count covers the vector loop and its scalar tail
+    enum { count = 37 };
+    uint8_t rowDestination[count * 4], pixelDestination[count * 4], source[count * 4];
+    uint32_t seed = 42;
+    for (int i = 0; i < count * 4; i++) {
+        rowDestination[i] = pixelDestination[i] = (uint8_t)CNTestRandom(&seed);
+        source[i] = (uint8_t)CNTestRandom(&seed);
+    }
+    /// premultiplied source, no channel exceeds its alpha
+    for (int i = 0; i < count; i++) {
+        for (int channel = 0; channel < 3; channel++) {
+            if (source[i * 4 + channel] > source[i * 4 + 3])
+                source[i * 4 + channel] = source[i * 4 + 3];
+        }
+    }
+
+    CNCompositorBlendRow(rowDestination, source, count, 200);
+    for (int i = 0; i < count; i++)
+        CNCompositorBlendRow(pixelDestination + i * 4, source + i * 4, 1, 200);
+    CNAssert(memcmp(rowDestination, pixelDestination, sizeof(rowDestination)) == 0);
+
+    CNCompositorDarkenRow(rowDestination, count, 100);
+    for (int i = 0; i < count; i++)
+        CNCompositorDarkenRow(pixelDestination + i * 4, 1, 100);
+    CNAssert(memcmp(rowDestination, pixelDestination, sizeof(rowDestination)) == 0);
+}
+
+static void testRenderFrameRejectsSizeMismatch(void)
+{
+    CNPixelBuffer snapshot, output;
+    CNAssert(CNPixelBufferAlloc(&snapshot, kCNGoldenWidth, kCNGoldenHeight));
+    CNAssert(CNPixelBufferAlloc(&output, kCNGoldenWidth / 2, kCNGoldenHeight));
+
+    CNCompositorParameters parameters;
+    CNCompositorDefaultParameters(&parameters);
+    parameters.thickness = 48;
+    CNCompositorFrame frame = { CNCompositorPhaseExpand, 0, 0 };
+    CNAssert(!CNCompositorRenderFrame(&parameters, &frame, &snapshot, NULL, &output));
+
+    CNPixelBufferFree(&snapshot);
+    CNPixelBufferFree(&output);
+}
+
+int main(void)
+{
+    CNTestRun(testGoldenFrames);
+    CNTestRun(testFramesDiffer);
+    CNTestRun(testRowKernelsMatchPerPixel);
+    CNTestRun(testRenderFrameRejectsSizeMismatch);
+    return CNTestResult();
+}
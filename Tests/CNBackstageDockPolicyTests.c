@@ -0,0 +1,193 @@
+//
+//  CNBackstageDockPolicyTests.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+#include "CNTestSupport.h"
+#include "CNBackstageDockPolicy.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Dock geometries of a 1440x900 screen with a 22 point menu bar, each expanded with a given edge and animation. The dock
+/// rect is derived from the screen and visible frames like `-[NSScreen dockFrame]` does, a bottom dock is narrowed to a
+/// centered dock window of 600 points.
+
+static const double kScreenWidth = 1440;
+static const double kScreenHeight = 900;
+static const double kMenuBarThickness = 22;
+static const double kDockWindowWidth = 600;
+
+typedef struct {
+    CNDockOrientation orientation;
+    double dockThickness;                               // 0 means the dock hides automatically
+    CNLayoutEdge edge;
+    CNLayoutAnimation animation;
+    double thickness;
+    bool overlaps;
+} CNDockFixture;
+
+static const CNDockFixture kDockFixtures[] = {
+    { CNDockOrientationBottom,  60, CNLayoutEdgeRight,              CNLayoutAnimationSlide,     360, false },
+    { CNDockOrientationLeft,    60, CNLayoutEdgeRight,              CNLayoutAnimationSlide,     360, false },
+    { CNDockOrientationBottom,  60, CNLayoutEdgeTop,                CNLayoutAnimationFade,      220, false },
+    { CNDockOrientationBottom,  60, CNLayoutEdgeBottom,             CNLayoutAnimationStatic,    220, true  },
+    { CNDockOrientationLeft,    60, CNLayoutEdgeLeft,               CNLayoutAnimationSlide,     360, true  },
+    { CNDockOrientationRight,   60, CNLayoutEdgeRight,              CNLayoutAnimationFade,      360, true  },
+    { CNDockOrientationLeft,    60, CNLayoutEdgeTop,                CNLayoutAnimationSlide,     220, true  },
+    { CNDockOrientationBottom,  60, CNLayoutEdgeSplitHorizontal,    CNLayoutAnimationFade,      400, true  },
+    { CNDockOrientationBottom,   0, CNLayoutEdgeBottom,             CNLayoutAnimationFade,      220, false },
+    { CNDockOrientationRight,    0, CNLayoutEdgeRight,              CNLayoutAnimationSlide,     360, false },
+};
+
+static CNLayoutRect CNFixtureDockRect(const CNDockFixture *fixture)
+{
+    double height = kScreenHeight - kMenuBarThickness;
+    double thickness = fixture->dockThickness;
+    CNLayoutRect screenFrame = CNLayoutRectMake(0, 0, kScreenWidth, kScreenHeight);
+    CNLayoutRect visibleFrame;
+    switch (fixture->orientation) {
+        case CNDockOrientationLeft:     visibleFrame = CNLayoutRectMake(thickness, 0, kScreenWidth - thickness, height); break;
+        case CNDockOrientationRight:    visibleFrame = CNLayoutRectMake(0, 0, kScreenWidth - thickness, height); break;
+        case CNDockOrientationBottom:   visibleFrame = CNLayoutRectMake(0, thickness, kScreenWidth, height - thickness); break;
+    }
+
+    CNLayoutRect dockRect = CNDockRect(fixture->orientation, screenFrame, visibleFrame);
+    if (fixture->orientation == CNDockOrientationBottom) {
+        CNLayoutRect windowBounds = CNLayoutRectMake((kScreenWidth - kDockWindowWidth) / 2, 0, kDockWindowWidth, thickness + 10);
+        dockRect = CNDockRectWithWindowBounds(dockRect, windowBounds);
+    }
+    return dockRect;
+}
+
+static void testFixtureGeometries(void)
+{
+    double height = kScreenHeight - kMenuBarThickness;
+    for (size_t i = 0; i < sizeof(kDockFixtures) / sizeof(kDockFixtures[0]); i++) {
+        const CNDockFixture *fixture = &kDockFixtures[i];
+        CNLayoutFrames collapsedFrames, expandedFrames;
+        CNLayoutCollapsedFrames(fixture->edge, fixture->animation, kScreenWidth, height, fixture->thickness, &collapsedFrames);
+        CNLayoutExpandedFrames(fixture->edge, fixture->animation, kScreenWidth, height, fixture->thickness, &expandedFrames);
+
+        CNLayoutRect coveredRect = CNLayoutRectUnion(collapsedFrames.applicationFrame, expandedFrames.applicationFrame);
+        if (CNDockRectIntersectsRects(CNFixtureDockRect(fixture), &coveredRect, 1) != fixture->overlaps) {
+            fprintf(stderr, "    fixture %zu\n", i);
+            CNAssert(false);
+        }
+    }
+}
+
+static void testDockRect(void)
+{
+    CNLayoutRect screenFrame = CNLayoutRectMake(0, 0, 1440, 900);
+    CNLayoutRect dockRect = CNDockRect(CNDockOrientationRight, screenFrame, CNLayoutRectMake(0, 0, 1380, 878));
+    CNAssertEqualsWithAccuracy(dockRect.x, 1380, 0);
+    CNAssertEqualsWithAccuracy(dockRect.width, 60, 0);
+    CNAssertEqualsWithAccuracy(dockRect.height, 900, 0);
+
+    /// a visible frame that equals the screen frame below the menu bar means there is no dock to measure
+    dockRect = CNDockRect(CNDockOrientationBottom, screenFrame, CNLayoutRectMake(0, 0, 1440, 878));
+    CNAssert(dockRect.width <= 0 || dockRect.height <= 0);
+}
+
+static void testDockRectWithWindowBounds(void)
+{
+    CNLayoutRect stripRect = CNLayoutRectMake(0, 0, 1440, 60);
+    CNLayoutRect dockRect = CNDockRectWithWindowBounds(stripRect, CNLayoutRectMake(420, 0, 600, 70));
+    CNAssertEqualsWithAccuracy(dockRect.x, 420, 0);
+    CNAssertEqualsWithAccuracy(dockRect.width, 600, 0);
+    CNAssertEqualsWithAccuracy(dockRect.height, 60, 0);
+
+    dockRect = CNDockRectWithWindowBounds(stripRect, CNLayoutRectMake(0, 0, 0, 0));
+    CNAssertEqualsWithAccuracy(dockRect.width, 1440, 0);
+    dockRect = CNDockRectWithWindowBounds(stripRect, CNLayoutRectMake(2000, 0, 100, 60));
+    CNAssertEqualsWithAccuracy(dockRect.width, 1440, 0);
+}
+
+static void testTouchingEdgesDontOverlap(void)
+{
+    CNLayoutRect dockRect = CNLayoutRectMake(0, 0, 1440, 60);
+    CNLayoutRect rects[2] = { CNLayoutRectMake(0, 60, 1440, 220), CNLayoutRectMake(0, 0, 0, 0) };
+    CNAssert(!CNDockRectIntersectsRects(dockRect, rects, 2));
+    rects[1] = CNLayoutRectMake(100, 59, 10, 10);
+    CNAssert(CNDockRectIntersectsRects(dockRect, rects, 2));
+}
+
+static void testImmediateRestore(void)
+{
+    CNDockPolicy policy;
+    CNDockPolicyInit(&policy, 0);
+    CNAssert(CNDockPolicyWillExpand(&policy, false) == CNDockPolicyActionNone);
+    CNAssert(CNDockPolicyDidCollapse(&policy, 1) == CNDockPolicyActionNone);
+    CNAssert(CNDockPolicyWillExpand(&policy, true) == CNDockPolicyActionHide);
+    CNAssert(CNDockPolicyDidCollapse(&policy, 2) == CNDockPolicyActionRestore);
+    CNAssert(CNDockPolicyNextDeadline(&policy) < 0);
+}
+
+static void testDelayedRestore(void)
+{
+    CNDockPolicy policy;
+    CNDockPolicyInit(&policy, 3);
+    CNAssert(CNDockPolicyWillExpand(&policy, true) == CNDockPolicyActionHide);
+    CNAssert(CNDockPolicyDidCollapse(&policy, 10) == CNDockPolicyActionNone);
+    CNAssertEqualsWithAccuracy(CNDockPolicyNextDeadline(&policy), 13, 0);
+    CNAssert(CNDockPolicyTick(&policy, 12.9) == CNDockPolicyActionNone);
+    CNAssert(CNDockPolicyTick(&policy, 13) == CNDockPolicyActionRestore);
+    CNAssert(!policy.dockIsHidden);
+    CNAssert(CNDockPolicyNextDeadline(&policy) < 0);
+}
+
+static void testReexpandWhileDockIsHidden(void)
+{
+    /// the controller measures the overlap against the last known dock frame while the dock is hidden, so a quick
+    /// re-expand of the same layout reports an overlap again and leaves the dock alone
+    CNDockPolicy policy;
+    CNDockPolicyInit(&policy, 3);
+    CNDockPolicyWillExpand(&policy, true);
+    CNDockPolicyDidCollapse(&policy, 10);
+    CNAssert(CNDockPolicyWillExpand(&policy, true) == CNDockPolicyActionNone);
+    CNAssert(policy.dockIsHidden);
+    CNAssert(CNDockPolicyNextDeadline(&policy) < 0);
+
+    /// a layout that doesn't overlap the dock anymore gives it back right away
+    CNDockPolicyDidCollapse(&policy, 20);
+    CNAssert(CNDockPolicyWillExpand(&policy, false) == CNDockPolicyActionRestore);
+    CNAssert(CNDockPolicyDidCollapse(&policy, 30) == CNDockPolicyActionNone);
+    CNAssert(CNDockPolicyNextDeadline(&policy) < 0);
+}
+
+
+int main(void)
+{
+    CNTestRun(testFixtureGeometries);
+    CNTestRun(testDockRect);
+    CNTestRun(testDockRectWithWindowBounds);
+    CNTestRun(testTouchingEdgesDontOverlap);
+    CNTestRun(testImmediateRestore);
+    CNTestRun(testDelayedRestore);
+    CNTestRun(testReexpandWhileDockIsHidden);
+    return CNTestResult();
+}
@@ -0,0 +1,246 @@
+//
+//  CNBackstageEdgeActivationTests.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CNTestSupport.h"
+#include "CNBackstageEdgeActivation.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The detector is fed with synthetic pointer streams, the timestamps are simulated seconds.
+
+static CNEdgeActivationConfig CNTestEdgeConfig(CNActivationEdge edge, CNActivationRegion region)
+{
+    CNEdgeActivationConfig config;
+    config.enabled              = true;
+    config.x                    = 0;
+    config.y                    = 0;
+    config.width                = 1440;
+    config.height               = 900;
+    config.edge                 = edge;
+    config.region               = region;
+    config.triggerDistance      = 2;
+    config.releaseDistance      = 24;
+    config.cornerSize           = 48;
+    config.dwellTime            = 0.3;
+    config.prepareTime          = 0.15;
+    config.velocityThreshold    = 1500;
+    return config;
+}
+
+static void testDwellPreparesAndActivates(void)
+{
+    CNEdgeActivationDetector detector;
+    CNEdgeActivationDetectorInit(&detector, CNTestEdgeConfig(CNActivationEdgeTop, CNActivationRegionEdge));
+
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 500, 400, 0.0) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 500, 899, 1.0) == CNEdgeActivationEventArmed);
+    CNAssertEqualsWithAccuracy(CNEdgeActivationDetectorDeadline(&detector), 1.15, 1e-9);
+    CNAssert(CNEdgeActivationDetectorTick(&detector, 1.1) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorTick(&detector, 1.15) == CNEdgeActivationEventPrepare);
+    CNAssertEqualsWithAccuracy(CNEdgeActivationDetectorDeadline(&detector), 1.3, 1e-9);
+
+    /// within the hysteresis the pointer may move away from the edge
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 505, 885, 1.2) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorTick(&detector, 1.3) == CNEdgeActivationEventActivate);
+    CNAssert(CNEdgeActivationDetectorDeadline(&detector) < 0);
+
+    /// latched until the pointer leaves the release zone
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 505, 899, 2.0) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 505, 800, 2.5) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 505, 899, 3.0) == CNEdgeActivationEventArmed);
+}
+
+static void testGrazingPointerIsNeverPrepared(void)
+{
+    CNEdgeActivationDetector detector;
+    CNEdgeActivationDetectorInit(&detector, CNTestEdgeConfig(CNActivationEdgeTop, CNActivationRegionEdge));
+
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 500, 899, 1.0) == CNEdgeActivationEventArmed);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 500, 850, 1.1) == CNEdgeActivationEventDisarmed);
+    CNAssert(CNEdgeActivationDetectorDeadline(&detector) < 0);
+    CNAssert(CNEdgeActivationDetectorTick(&detector, 1.15) == CNEdgeActivationEventNone);
+}
+
+static void testLateTickActivatesWithoutPrepare(void)
+{
+    CNEdgeActivationDetector detector;
+    CNEdgeActivationDetectorInit(&detector, CNTestEdgeConfig(CNActivationEdgeTop, CNActivationRegionEdge));
+
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 500, 899, 1.0) == CNEdgeActivationEventArmed);
+    CNAssert(CNEdgeActivationDetectorTick(&detector, 1.5) == CNEdgeActivationEventActivate);
+}
+
+static void testPrepareTimeBeyondDwellTime(void)
+{
+    CNEdgeActivationConfig config = CNTestEdgeConfig(CNActivationEdgeTop, CNActivationRegionEdge);
+    config.prepareTime = 1.0;
+
+    CNEdgeActivationDetector detector;
+    CNEdgeActivationDetectorInit(&detector, config);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 500, 899, 1.0) == CNEdgeActivationEventArmed);
+    CNAssertEqualsWithAccuracy(CNEdgeActivationDetectorDeadline(&detector), 1.3, 1e-9);
+    CNAssert(CNEdgeActivationDetectorTick(&detector, 1.3) == CNEdgeActivationEventActivate);
+}
+
+static void testFastPointerDoesNotArm(void)
+{
+    CNEdgeActivationDetector detector;
+    CNEdgeActivationDetectorInit(&detector, CNTestEdgeConfig(CNActivationEdgeTop, CNActivationRegionEdge));
+
+    /// 500 points in 10 ms
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 500, 400, 0.0) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 500, 899, 0.01) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 501, 899, 0.05) == CNEdgeActivationEventArmed);
+
+    /// flicking along the edge restarts the dwell time
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 900, 899, 0.1) == CNEdgeActivationEventNone);
+    CNAssertEqualsWithAccuracy(CNEdgeActivationDetectorDeadline(&detector), 0.25, 1e-9);
+}
+
+static void testTopRowAtMaximumY(void)
+{
+    CNEdgeActivationDetector detector;
+    CNEdgeActivationDetectorInit(&detector, CNTestEdgeConfig(CNActivationEdgeTop, CNActivationRegionEdge));
+
+    /// Cocoa reports the top row of a display as NSMaxY
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 500, 900, 1.0) == CNEdgeActivationEventArmed);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 500, 900.5, 1.1) == CNEdgeActivationEventDisarmed);
+}
+
+static void testRightEdgeExcludesNeighbourDisplay(void)
+{
+    CNEdgeActivationDetector detector;
+    CNEdgeActivationDetectorInit(&detector, CNTestEdgeConfig(CNActivationEdgeRight, CNActivationRegionEdge));
+
+    /// x == NSMaxX is the first column of the display to the right
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 1440, 400, 1.0) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 1439, 400, 2.0) == CNEdgeActivationEventArmed);
+}
+
+static void testBottomAndLeftEdges(void)
+{
+    CNEdgeActivationDetector detector;
+    CNEdgeActivationDetectorInit(&detector, CNTestEdgeConfig(CNActivationEdgeBottom, CNActivationRegionEdge));
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 700, 3, 1.0) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 700, 0, 2.0) == CNEdgeActivationEventArmed);
+
+    CNEdgeActivationDetectorSetConfig(&detector, CNTestEdgeConfig(CNActivationEdgeLeft, CNActivationRegionEdge));
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, -1, 400, 1.0) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 1, 400, 2.0) == CNEdgeActivationEventArmed);
+}
+
+static void testHotCorners(void)
+{
+    CNEdgeActivationDetector detector;
+    CNEdgeActivationDetectorInit(&detector, CNTestEdgeConfig(CNActivationEdgeTop, CNActivationRegionCorners));
+
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 700, 899, 1.0) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 1430, 899, 2.0) == CNEdgeActivationEventArmed);
+
+    /// the corner grows by the hysteresis while dwelling
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 1380, 899, 2.1) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 1300, 899, 2.2) == CNEdgeActivationEventDisarmed);
+}
+
+static void testDisabledDetector(void)
+{
+    CNEdgeActivationConfig config = CNTestEdgeConfig(CNActivationEdgeTop, CNActivationRegionEdge);
+    config.enabled = false;
+
+    CNEdgeActivationDetector detector;
+    CNEdgeActivationDetectorInit(&detector, config);
+    CNAssert(CNEdgeActivationDetectorPointerMoved(&detector, 500, 899, 1.0) == CNEdgeActivationEventNone);
+    CNAssert(CNEdgeActivationDetectorDeadline(&detector) < 0);
+}
+
+static void testRandomPointerStream(void)
+{
+    CNEdgeActivationConfig config = CNTestEdgeConfig(CNActivationEdgeTop, CNActivationRegionEdge);
+    CNEdgeActivationDetector detector;
+    CNEdgeActivationDetectorInit(&detector, config);
+
+    /// a pointer wandering near the edge, ticks are delivered at the deadlines like the controller does
+    uint32_t seed = 2012;
+    double x = 700, y = 850, time = 0, armedAt = -1;
+    int prepareCount = 0, activateCount = 0;
+    for (int sample = 0; sample < 200000; sample++) {
+        time += 0.004 + (CNTestRandom(&seed) % 40) / 1000.0;
+        x = fmin(fmax(x + (double)(CNTestRandom(&seed) % 41) - 20, 0), 1439);
+        y = fmin(fmax(y + (double)(CNTestRandom(&seed) % 21) - 10, 800), 900);
+
+        double deadline = CNEdgeActivationDetectorDeadline(&detector);
+        CNEdgeActivationEvent event = CNEdgeActivationEventNone;
+        if (deadline >= 0 && deadline <= time)
+            event = CNEdgeActivationDetectorTick(&detector, deadline);
+        if (event == CNEdgeActivationEventNone)
+            event = CNEdgeActivationDetectorPointerMoved(&detector, x, y, time);
+
+        switch (event) {
+            case CNEdgeActivationEventNone:
+                break;
+            case CNEdgeActivationEventArmed:
+                armedAt = time;
+                prepareCount = 0;
+                break;
+            case CNEdgeActivationEventPrepare:
+                CNAssert(armedAt >= 0);
+                CNAssert(++prepareCount == 1);
+                break;
+            case CNEdgeActivationEventDisarmed:
+                CNAssert(armedAt >= 0);
+                armedAt = -1;
+                break;
+            case CNEdgeActivationEventActivate:
+                CNAssert(armedAt >= 0 && time - armedAt >= config.dwellTime - 1e-9);
+                CNAssert(detector.state == CNEdgeActivationStateLatched);
+                armedAt = -1;
+                activateCount++;
+                break;
+        }
+    }
+    CNAssert(activateCount > 0);
+}
+
+int main(void)
+{
+    CNTestRun(testDwellPreparesAndActivates);
+    CNTestRun(testGrazingPointerIsNeverPrepared);
+    CNTestRun(testLateTickActivatesWithoutPrepare);
+    CNTestRun(testPrepareTimeBeyondDwellTime);
+    CNTestRun(testFastPointerDoesNotArm);
+    CNTestRun(testTopRowAtMaximumY);
+    CNTestRun(testRightEdgeExcludesNeighbourDisplay);
+    CNTestRun(testBottomAndLeftEdges);
+    CNTestRun(testHotCorners);
+    CNTestRun(testDisabledDetector);
+    CNTestRun(testRandomPointerStream);
+    return CNTestResult();
+}
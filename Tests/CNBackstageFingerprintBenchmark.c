@@ -0,0 +1,163 @@
+//
+//  CNBackstageFingerprintBenchmark.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CNTestSupport.h"
+#include <string.h>
+#include "CNBackstageFingerprint.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Measures the fingerprint of a nominal resolution capture of a 1440x878 and a 2560x1418 display with every row and every
+/// second row sampled, and with horizontal bands of the display sampled, which would shrink the capture itself. The
+/// controller samples every row.
+///
+/// The false reuse part changes one rect of typical screen content at random positions and counts how often the
+/// fingerprint still matches, i.e. how often a re-expand would show a stale snapshot. A change is only missed if none of
+/// its rows is sampled, so the rates follow from the geometry and are the same for any screen content.
+
+static const int kCNBenchmarkIterations = 100;
+static const int kCNBenchmarkChanges    = 400;
+
+typedef struct {
+    const char *name;
+    int rowStep;
+    int bandCount;                                      // 0 samples the whole capture
+    int bandHeight;
+} CNBenchmarkSampling;
+
+typedef struct {
+    const char *name;
+    int width;
+    int height;
+} CNBenchmarkChange;
+
+static const CNBenchmarkSampling kCNBenchmarkSamplings[] = {
+    { "every row",              1,  0,  0 },
+    { "every second row",       2,  0,  0 },
+    { "16 bands of 16 rows",    1, 16, 16 },
+    { "8 bands of 32 rows",     1,  8, 32 }
+};
+
+static const CNBenchmarkChange kCNBenchmarkChangeRects[] = {
+    { "pixel",          1,   1 },
+    { "text cursor",    2,  16 },
+    { "text line",    200,  14 },
+    { "icon",          32,  32 },
+    { "notification", 320,  64 },
+    { "window",       400, 300 }
+};
+
+/// Top row of band `index` if the bands are spread evenly over the capture, the first one at the top.
+static int CNBenchmarkBandOrigin(int height, int bandCount, int bandHeight, int index)
+{
+    return (int)((long long)(height - bandHeight) * index / (bandCount - 1));
+}
+
+/// Copies the sampled rows into `sampledPixels` and returns their count.
+static int CNBenchmarkSampleRows(const CNBenchmarkSampling *sampling, const uint8_t *pixels, size_t bytesPerRow, int height, uint8_t *sampledPixels)
+{
+    if (sampling->bandCount == 0) {
+        memcpy(sampledPixels, pixels, bytesPerRow * (size_t)height);
+        return height;
+    }
+    for (int band = 0; band < sampling->bandCount; band++) {
+        int origin = CNBenchmarkBandOrigin(height, sampling->bandCount, sampling->bandHeight, band);
+        memcpy(sampledPixels + (size_t)band * sampling->bandHeight * bytesPerRow, pixels + (size_t)origin * bytesPerRow, (size_t)sampling->bandHeight * bytesPerRow);
+    }
+    return sampling->bandCount * sampling->bandHeight;
+}
+
+static void CNBenchmarkFingerprint(int width, int height, const CNBenchmarkSampling *sampling)
+{
+    size_t bytesPerRow = (size_t)width * 4 + 64;
+    uint8_t *pixels = malloc(bytesPerRow * (size_t)height);
+    uint8_t *sampledPixels = malloc(bytesPerRow * (size_t)height);
+    uint32_t seed = 3;
+    for (size_t i = 0; pixels != NULL && i < bytesPerRow * (size_t)height; i++)
+        pixels[i] = (uint8_t)CNTestRandom(&seed);
+
+    CNFingerprint fingerprint;
+    int sampledHeight = (sampling->bandCount == 0 ? height : sampling->bandCount * sampling->bandHeight);
+    if (pixels == NULL || sampledPixels == NULL || !CNFingerprintInit(&fingerprint, width, sampledHeight, 16, sampling->rowStep)) {
+        free(pixels);
+        free(sampledPixels);
+        return;
+    }
+
+    double start = CNTestNow();
+    for (int iteration = 0; iteration < kCNBenchmarkIterations; iteration++) {
+        CNBenchmarkSampleRows(sampling, pixels, bytesPerRow, height, sampledPixels);
+        CNFingerprintCompute(&fingerprint, sampledPixels, bytesPerRow);
+    }
+    double duration = (CNTestNow() - start) / kCNBenchmarkIterations;
+    double capturedRatio = (double)sampledHeight / height;
+    printf("  %4dx%-4d  %-20s %6.3f ms  %5.1f%% of the display captured\n", width, height, sampling->name, duration * 1e3, capturedRatio * 100);
+
+    /// false reuse, every change is made on a fresh copy of the screen
+    printf("             false reuse:");
+    CNFingerprint changedFingerprint;
+    CNFingerprintInit(&changedFingerprint, width, sampledHeight, 16, sampling->rowStep);
+    uint8_t *changedPixels = malloc(bytesPerRow * (size_t)height);
+    for (size_t i = 0; changedPixels != NULL && i < sizeof(kCNBenchmarkChangeRects) / sizeof(kCNBenchmarkChangeRects[0]); i++) {
+        const CNBenchmarkChange *change = &kCNBenchmarkChangeRects[i];
+        int missed = 0;
+        for (int trial = 0; trial < kCNBenchmarkChanges; trial++) {
+            memcpy(changedPixels, pixels, bytesPerRow * (size_t)height);
+            int x = (int)(CNTestRandom(&seed) % (uint32_t)(width - change->width + 1));
+            int y = (int)(CNTestRandom(&seed) % (uint32_t)(height - change->height + 1));
+            for (int row = y; row < y + change->height; row++) {
+                for (size_t column = (size_t)x * 4; column < (size_t)(x + change->width) * 4; column++)
+                    changedPixels[(size_t)row * bytesPerRow + column] ^= 0x5a;
+            }
+            CNBenchmarkSampleRows(sampling, changedPixels, bytesPerRow, height, sampledPixels);
+            CNFingerprintCompute(&changedFingerprint, sampledPixels, bytesPerRow);
+            missed += CNFingerprintMatches(&fingerprint, &changedFingerprint);
+        }
+        printf("  %s %.1f%%", change->name, 100.0 * missed / kCNBenchmarkChanges);
+    }
+    printf("\n");
+
+    free(changedPixels);
+    CNFingerprintFree(&changedFingerprint);
+    CNFingerprintFree(&fingerprint);
+    free(sampledPixels);
+    free(pixels);
+}
+
+int main(void)
+{
+    printf("fingerprint\n");
+    for (size_t i = 0; i < sizeof(kCNBenchmarkSamplings) / sizeof(kCNBenchmarkSamplings[0]); i++)
+        CNBenchmarkFingerprint(1440, 878, &kCNBenchmarkSamplings[i]);
+    for (size_t i = 0; i < sizeof(kCNBenchmarkSamplings) / sizeof(kCNBenchmarkSamplings[0]); i++)
+        CNBenchmarkFingerprint(2560, 1418, &kCNBenchmarkSamplings[i]);
+    return EXIT_SUCCESS;
+}
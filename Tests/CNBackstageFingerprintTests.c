@@ -0,0 +1,206 @@
+//
+//  CNBackstageFingerprintTests.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CNTestSupport.h"
+#include <string.h>
+#include "CNBackstageFingerprint.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Changes the old byte sum fingerprint missed must change the fingerprint now: moved content and swapped channels.
+
+static const int kCNTestWidth   = 200;
+static const int kCNTestHeight  = 120;
+
+static uint8_t *CNTestCreateScreen(size_t bytesPerRow)
+{
+    /// a flat desktop with a few colored squares
+    uint8_t *pixels = calloc((size_t)kCNTestHeight, bytesPerRow);
+    for (int y = 0; y < kCNTestHeight; y++) {
+        for (int x = 0; x < kCNTestWidth; x++) {
+            uint8_t *pixel = pixels + (size_t)y * bytesPerRow + (size_t)x * 4;
+            pixel[0] = 60; pixel[1] = 70; pixel[2] = 80; pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+static void CNTestFillSquare(uint8_t *pixels, size_t bytesPerRow, int x, int y, int size, const uint8_t color[4])
+{
+    for (int row = y; row < y + size; row++) {
+        for (int column = x; column < x + size; column++)
+            memcpy(pixels + (size_t)row * bytesPerRow + (size_t)column * 4, color, 4);
+    }
+}
+
+static bool CNTestFingerprintsMatch(const uint8_t *pixels, const uint8_t *otherPixels, size_t bytesPerRow, int blockSize, int rowStep)
+{
+    CNFingerprint fingerprint, otherFingerprint;
+    CNFingerprintInit(&fingerprint, kCNTestWidth, kCNTestHeight, blockSize, rowStep);
+    CNFingerprintInit(&otherFingerprint, kCNTestWidth, kCNTestHeight, blockSize, rowStep);
+    CNFingerprintCompute(&fingerprint, pixels, bytesPerRow);
+    CNFingerprintCompute(&otherFingerprint, otherPixels, bytesPerRow);
+    bool matches = CNFingerprintMatches(&fingerprint, &otherFingerprint);
+    CNFingerprintFree(&fingerprint);
+    CNFingerprintFree(&otherFingerprint);
+    return matches;
+}
+
+static void testEqualCapturesMatch(void)
+{
+    size_t bytesPerRow = kCNTestWidth * 4 + 32;
+    uint8_t *pixels = CNTestCreateScreen(bytesPerRow);
+    uint8_t *otherPixels = CNTestCreateScreen(bytesPerRow);
+    static const uint8_t color[4] = { 250, 20, 20, 255 };
+    CNTestFillSquare(pixels, bytesPerRow, 40, 40, 6, color);
+    CNTestFillSquare(otherPixels, bytesPerRow, 40, 40, 6, color);
+
+    /// the padding at the end of a row isn't part of the capture
+    otherPixels[bytesPerRow - 1] = 0xAB;
+    CNAssert(CNTestFingerprintsMatch(pixels, otherPixels, bytesPerRow, 16, 1));
+    CNAssert(CNTestFingerprintsMatch(pixels, otherPixels, bytesPerRow, 16, 2));
+    free(pixels);
+    free(otherPixels);
+}
+
+static void testOnePixelMoveDoesNotMatch(void)
+{
+    size_t bytesPerRow = kCNTestWidth * 4;
+    static const uint8_t color[4] = { 250, 20, 20, 255 };
+
+    /// every row is sampled, like the controller does
+    for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            if (dx == 0 && dy == 0)
+                continue;
+            uint8_t *pixels = CNTestCreateScreen(bytesPerRow);
+            uint8_t *otherPixels = CNTestCreateScreen(bytesPerRow);
+            CNTestFillSquare(pixels, bytesPerRow, 42, 42, 6, color);
+            CNTestFillSquare(otherPixels, bytesPerRow, 42 + dx, 42 + dy, 6, color);
+            CNAssert(!CNTestFingerprintsMatch(pixels, otherPixels, bytesPerRow, 16, 1));
+            free(pixels);
+            free(otherPixels);
+        }
+    }
+}
+
+static void testSingleByteChangesDoNotMatch(void)
+{
+    size_t bytesPerRow = kCNTestWidth * 4 + 16;
+    uint8_t *pixels = CNTestCreateScreen(bytesPerRow);
+    uint8_t *otherPixels = CNTestCreateScreen(bytesPerRow);
+    uint32_t seed = 11;
+    for (int i = 0; i < 500; i++) {
+        size_t offset = (CNTestRandom(&seed) % kCNTestHeight) * bytesPerRow + CNTestRandom(&seed) % (kCNTestWidth * 4);
+        otherPixels[offset] ^= (uint8_t)(1 + CNTestRandom(&seed) % 255);
+        CNAssert(!CNTestFingerprintsMatch(pixels, otherPixels, bytesPerRow, 16, 1));
+        otherPixels[offset] = pixels[offset];
+    }
+    free(pixels);
+    free(otherPixels);
+}
+
+static void testSwappedChannelsDoNotMatch(void)
+{
+    /// red and blue swapped keep the byte sum of every block
+    size_t bytesPerRow = kCNTestWidth * 4;
+    uint8_t *pixels = CNTestCreateScreen(bytesPerRow);
+    uint8_t *otherPixels = CNTestCreateScreen(bytesPerRow);
+    static const uint8_t color[4] = { 250, 20, 90, 255 };
+    static const uint8_t swappedColor[4] = { 90, 20, 250, 255 };
+    CNTestFillSquare(pixels, bytesPerRow, 100, 60, 10, color);
+    CNTestFillSquare(otherPixels, bytesPerRow, 100, 60, 10, swappedColor);
+    CNAssert(!CNTestFingerprintsMatch(pixels, otherPixels, bytesPerRow, 16, 1));
+    free(pixels);
+    free(otherPixels);
+}
+
+static void testSampledRows(void)
+{
+    /// a row step above 1 has a blind spot, a change confined to a row that isn't sampled
+    size_t bytesPerRow = kCNTestWidth * 4;
+    uint8_t *pixels = CNTestCreateScreen(bytesPerRow);
+    uint8_t *otherPixels = CNTestCreateScreen(bytesPerRow);
+
+    otherPixels[bytesPerRow * 33 + 4 * 70] ^= 0x10;
+    CNAssert(CNTestFingerprintsMatch(pixels, otherPixels, bytesPerRow, 16, 2));
+    CNAssert(!CNTestFingerprintsMatch(pixels, otherPixels, bytesPerRow, 16, 1));
+
+    otherPixels[bytesPerRow * 34 + 4 * 70] ^= 0x10;
+    CNAssert(!CNTestFingerprintsMatch(pixels, otherPixels, bytesPerRow, 16, 2));
+
+    /// a row step that doesn't divide the block size samples every third row of the whole capture
+    memcpy(otherPixels, pixels, bytesPerRow * kCNTestHeight);
+    otherPixels[bytesPerRow * 18 + 4 * 70] ^= 0x10;
+    CNAssert(!CNTestFingerprintsMatch(pixels, otherPixels, bytesPerRow, 16, 3));
+    memcpy(otherPixels, pixels, bytesPerRow * kCNTestHeight);
+    otherPixels[bytesPerRow * 17 + 4 * 70] ^= 0x10;
+    CNAssert(CNTestFingerprintsMatch(pixels, otherPixels, bytesPerRow, 16, 3));
+
+    /// the last block row is only 8 rows high
+    memcpy(otherPixels, pixels, bytesPerRow * kCNTestHeight);
+    otherPixels[bytesPerRow * (kCNTestHeight - 2) + 4 * (kCNTestWidth - 1)] ^= 0x10;
+    CNAssert(!CNTestFingerprintsMatch(pixels, otherPixels, bytesPerRow, 16, 2));
+
+    free(pixels);
+    free(otherPixels);
+}
+
+static void testGeometryMismatch(void)
+{
+    size_t bytesPerRow = kCNTestWidth * 4;
+    uint8_t *pixels = CNTestCreateScreen(bytesPerRow);
+
+    CNFingerprint fingerprint, otherFingerprint;
+    CNAssert(CNFingerprintInit(&fingerprint, kCNTestWidth, kCNTestHeight, 16, 2));
+    CNAssert(CNFingerprintInit(&otherFingerprint, kCNTestWidth, kCNTestHeight, 16, 1));
+    CNFingerprintCompute(&fingerprint, pixels, bytesPerRow);
+    CNFingerprintCompute(&otherFingerprint, pixels, bytesPerRow);
+    CNAssert(!CNFingerprintMatches(&fingerprint, &otherFingerprint));
+    CNFingerprintFree(&otherFingerprint);
+
+    /// a freed fingerprint never matches
+    CNAssert(!CNFingerprintMatches(&fingerprint, &otherFingerprint));
+    CNAssert(!CNFingerprintInit(&otherFingerprint, kCNTestWidth, kCNTestHeight, 16, 0));
+    CNFingerprintFree(&fingerprint);
+    free(pixels);
+}
+
+int main(void)
+{
+    CNTestRun(testEqualCapturesMatch);
+    CNTestRun(testOnePixelMoveDoesNotMatch);
+    CNTestRun(testSingleByteChangesDoNotMatch);
+    CNTestRun(testSwappedChannelsDoNotMatch);
+    CNTestRun(testSampledRows);
+    CNTestRun(testGeometryMismatch);
+    return CNTestResult();
+}
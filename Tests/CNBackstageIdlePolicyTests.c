@@ -0,0 +1,155 @@
+//
+//  CNBackstageIdlePolicyTests.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include "CNTestSupport.h"
+#include "CNBackstageIdlePolicy.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The idle policy is driven by a simulated clock, every call gets the current time passed in.
+
+static void testInitialStateHibernates(void)
+{
+    CNIdlePolicy policy;
+    CNIdlePolicyInit(&policy, 180, true);
+    CNAssert(policy.state == CNIdlePolicyStateHibernating);
+    CNAssert(CNIdlePolicyNextDeadline(&policy) < 0);
+    CNAssert(CNIdlePolicyTick(&policy, 1000) == CNIdlePolicyActionNone);
+}
+
+static void testFirstExpandWakesUp(void)
+{
+    CNIdlePolicy policy;
+    CNIdlePolicyInit(&policy, 180, true);
+    CNAssert(CNIdlePolicyWillExpand(&policy) == CNIdlePolicyActionWakeUp);
+    CNAssert(CNIdlePolicyNextDeadline(&policy) < 0);
+
+    CNIdlePolicyDidCollapse(&policy, 10);
+    CNAssert(CNIdlePolicyWillExpand(&policy) == CNIdlePolicyActionNone);
+}
+
+static void testCollapseHibernatesAfterIdleInterval(void)
+{
+    CNIdlePolicy policy;
+    CNIdlePolicyInit(&policy, 180, true);
+    CNIdlePolicyWillExpand(&policy);
+    CNIdlePolicyDidCollapse(&policy, 100);
+
+    CNAssertEqualsWithAccuracy(CNIdlePolicyNextDeadline(&policy), 280, 0);
+    CNAssert(CNIdlePolicyTick(&policy, 279.9) == CNIdlePolicyActionNone);
+    CNAssert(CNIdlePolicyTick(&policy, 280) == CNIdlePolicyActionHibernate);
+    CNAssert(CNIdlePolicyNextDeadline(&policy) < 0);
+    CNAssert(CNIdlePolicyWillExpand(&policy) == CNIdlePolicyActionWakeUp);
+}
+
+static void testExpandCancelsDeadline(void)
+{
+    CNIdlePolicy policy;
+    CNIdlePolicyInit(&policy, 180, true);
+    CNIdlePolicyWillExpand(&policy);
+    CNIdlePolicyDidCollapse(&policy, 100);
+    CNIdlePolicyWillExpand(&policy);
+
+    /// a timer that fires after the expand must not release resources in use
+    CNAssert(CNIdlePolicyNextDeadline(&policy) < 0);
+    CNAssert(CNIdlePolicyTick(&policy, 280) == CNIdlePolicyActionNone);
+
+    /// the idle interval starts again with the next collapse
+    CNIdlePolicyDidCollapse(&policy, 300);
+    CNAssert(CNIdlePolicyTick(&policy, 400) == CNIdlePolicyActionNone);
+    CNAssert(CNIdlePolicyTick(&policy, 480) == CNIdlePolicyActionHibernate);
+}
+
+static void testDisabledIdleInterval(void)
+{
+    CNIdlePolicy policy;
+    CNIdlePolicyInit(&policy, 0, true);
+    CNIdlePolicyWillExpand(&policy);
+    CNIdlePolicyDidCollapse(&policy, 100);
+    CNAssert(CNIdlePolicyNextDeadline(&policy) < 0);
+    CNAssert(CNIdlePolicyTick(&policy, 1e9) == CNIdlePolicyActionNone);
+}
+
+static void testPrewarm(void)
+{
+    CNIdlePolicy policy;
+    CNIdlePolicyInit(&policy, 60, true);
+    CNAssert(CNIdlePolicyPrewarm(&policy, 5) == CNIdlePolicyActionWakeUp);
+    CNAssert(CNIdlePolicyPrewarm(&policy, 6) == CNIdlePolicyActionNone);
+
+    /// a prewarmed but unused controller hibernates again
+    CNAssertEqualsWithAccuracy(CNIdlePolicyNextDeadline(&policy), 65, 0);
+    CNAssert(CNIdlePolicyWillExpand(&policy) == CNIdlePolicyActionNone);
+    CNAssert(CNIdlePolicyPrewarm(&policy, 7) == CNIdlePolicyActionNone);
+}
+
+static void testMemoryPressure(void)
+{
+    CNIdlePolicy policy;
+    CNIdlePolicyInit(&policy, 180, true);
+
+    /// nothing to release while hibernating, nothing is taken away while expanded
+    CNAssert(CNIdlePolicyMemoryPressure(&policy, CNMemoryPressureCritical) == CNIdlePolicyActionNone);
+    CNIdlePolicyWillExpand(&policy);
+    CNAssert(CNIdlePolicyMemoryPressure(&policy, CNMemoryPressureCritical) == CNIdlePolicyActionNone);
+    CNAssert(policy.state == CNIdlePolicyStateExpanded);
+
+    CNIdlePolicyDidCollapse(&policy, 100);
+    CNAssert(CNIdlePolicyMemoryPressure(&policy, CNMemoryPressureNormal) == CNIdlePolicyActionNone);
+    CNAssert(CNIdlePolicyMemoryPressure(&policy, CNMemoryPressureWarning) == CNIdlePolicyActionHibernate);
+    CNAssert(CNIdlePolicyNextDeadline(&policy) < 0);
+    CNAssert(CNIdlePolicyMemoryPressure(&policy, CNMemoryPressureCritical) == CNIdlePolicyActionNone);
+}
+
+static void testMemoryPressureDisabled(void)
+{
+    CNIdlePolicy policy;
+    CNIdlePolicyInit(&policy, 180, false);
+    CNIdlePolicyWillExpand(&policy);
+    CNIdlePolicyDidCollapse(&policy, 100);
+    CNAssert(CNIdlePolicyMemoryPressure(&policy, CNMemoryPressureCritical) == CNIdlePolicyActionNone);
+    CNAssert(CNIdlePolicyTick(&policy, 280) == CNIdlePolicyActionHibernate);
+}
+
+
+int main(void)
+{
+    CNTestRun(testInitialStateHibernates);
+    CNTestRun(testFirstExpandWakesUp);
+    CNTestRun(testCollapseHibernatesAfterIdleInterval);
+    CNTestRun(testExpandCancelsDeadline);
+    CNTestRun(testDisabledIdleInterval);
+    CNTestRun(testPrewarm);
+    CNTestRun(testMemoryPressure);
+    CNTestRun(testMemoryPressureDisabled);
+    return CNTestResult();
+}
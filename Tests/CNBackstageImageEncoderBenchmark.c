@@ -0,0 +1,120 @@
+//
+//  CNBackstageImageEncoderBenchmark.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+#include "CNTestSupport.h"
+#include <string.h>
+#include "CNBackstageImageEncoder.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Measures the encoder on a synthetic 5120x2880 BGRA capture that looks like a desktop: a gradient wallpaper, flat
+/// windows and rows of glyph noise. The rows are appended in bands of 64, like the controller does, and each level is
+/// measured as the best of three runs with the same encoder, so the output buffer is already grown.
+
+static const int kCNBenchmarkWidth      = 5120;
+static const int kCNBenchmarkHeight     = 2880;
+static const int kCNBenchmarkBandHeight = 64;
+static const int kCNBenchmarkRuns       = 3;
+
+static void CNBenchmarkFillScreen(uint8_t *pixels, int width, int height, size_t bytesPerRow)
+{
+    uint32_t seed = 12345;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t *pixel = pixels + y * bytesPerRow + x * 4;
+            pixel[0] = (uint8_t)(80 + x * 100 / width);
+            pixel[1] = (uint8_t)(40 + y * 120 / height);
+            pixel[2] = (uint8_t)(120 + (x + y) * 60 / (width + height));
+            pixel[3] = 255;
+        }
+    }
+    for (int window = 0; window < 12; window++) {
+        int originX = (int)(CNTestRandom(&seed) % (uint32_t)(width - 1200));
+        int originY = (int)(CNTestRandom(&seed) % (uint32_t)(height - 900));
+        int windowWidth = 600 + (int)(CNTestRandom(&seed) % 600);
+        int windowHeight = 400 + (int)(CNTestRandom(&seed) % 500);
+        uint8_t gray = (uint8_t)(220 + CNTestRandom(&seed) % 36);
+        for (int y = originY; y < originY + windowHeight; y++)
+            memset(pixels + y * bytesPerRow + originX * 4, gray, (size_t)windowWidth * 4);
+
+        for (int line = originY + 40; line + 18 < originY + windowHeight; line += 26) {
+            for (int x = originX + 20; x < originX + windowWidth - 20; x += 9) {
+                if (CNTestRandom(&seed) % 7 == 0)
+                    continue;
+                for (int glyphY = 0; glyphY < 14; glyphY++) {
+                    for (int glyphX = 0; glyphX < 7; glyphX++) {
+                        if (CNTestRandom(&seed) % 3 == 0) {
+                            uint8_t *pixel = pixels + (line + glyphY) * bytesPerRow + (x + glyphX) * 4;
+                            pixel[0] = pixel[1] = pixel[2] = (uint8_t)(CNTestRandom(&seed) % 90);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    size_t bytesPerRow = (size_t)kCNBenchmarkWidth * 4;
+    uint8_t *pixels = malloc(bytesPerRow * kCNBenchmarkHeight);
+    CNImageEncoder *encoder = CNImageEncoderCreate();
+    if (pixels == NULL || encoder == NULL)
+        return EXIT_FAILURE;
+    CNBenchmarkFillScreen(pixels, kCNBenchmarkWidth, kCNBenchmarkHeight, bytesPerRow);
+
+    printf("image encoder %dx%d BGRA\n", kCNBenchmarkWidth, kCNBenchmarkHeight);
+    static const int compressionLevels[] = { 0, 1, 2, 3, 6 };
+    for (size_t i = 0; i < sizeof(compressionLevels) / sizeof(compressionLevels[0]); i++) {
+        CNImageEncoderParameters parameters;
+        CNImageEncoderDefaultParameters(&parameters, kCNBenchmarkWidth, kCNBenchmarkHeight);
+        parameters.pixelFormat = CNImagePixelFormatBGRA;
+        parameters.compressionLevel = compressionLevels[i];
+
+        double bestTime = INFINITY;
+        size_t length = 0;
+        for (int run = 0; run < kCNBenchmarkRuns; run++) {
+            double start = CNTestNow();
+            CNImageEncoderBegin(encoder, &parameters);
+            for (int y = 0; y < kCNBenchmarkHeight; y += kCNBenchmarkBandHeight) {
+                int rowCount = (kCNBenchmarkHeight - y < kCNBenchmarkBandHeight ? kCNBenchmarkHeight - y : kCNBenchmarkBandHeight);
+                if (!CNImageEncoderAppendRows(encoder, pixels + y * bytesPerRow, bytesPerRow, rowCount))
+                    return EXIT_FAILURE;
+            }
+            if (CNImageEncoderFinish(encoder, &length) == NULL)
+                return EXIT_FAILURE;
+            bestTime = fmin(bestTime, CNTestNow() - start);
+        }
+        printf("  level %d   %7.1f ms  %9zu bytes  capacity %zu\n", compressionLevels[i], bestTime * 1e3, length, CNImageEncoderCapacity(encoder));
+    }
+
+    CNImageEncoderFree(encoder);
+    free(pixels);
+    return EXIT_SUCCESS;
+}
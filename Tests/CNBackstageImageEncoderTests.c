@@ -0,0 +1,287 @@
+//
+//  CNBackstageImageEncoderTests.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+#include "CNTestSupport.h"
+#include <string.h>
+#include "CNTestImage.h"
+#include "CNBackstageImageEncoder.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Every image is encoded and decoded again with the PNG reader of the golden image tests. The sizes are odd on purpose and
+/// the rows are padded, so row lengths and strides never line up with anything.
+
+static const int kCNTestWidth = 97;
+static const int kCNTestHeight = 61;
+static const size_t kCNTestBytesPerRow = 97 * 4 + 20;
+
+static uint8_t *CNTestCreateStraightImage(uint32_t seed, bool isOpaque)
+{
+    uint8_t *pixels = malloc(kCNTestBytesPerRow * kCNTestHeight);
+    for (size_t i = 0; i < kCNTestBytesPerRow * kCNTestHeight; i++)
+        pixels[i] = (uint8_t)CNTestRandom(&seed);
+    if (isOpaque) {
+        for (int y = 0; y < kCNTestHeight; y++)
+            for (int x = 0; x < kCNTestWidth; x++)
+                pixels[y * kCNTestBytesPerRow + x * 4 + 3] = 255;
+    }
+    return pixels;
+}
+
+static void CNTestPremultiply(uint8_t *pixels)
+{
+    for (int y = 0; y < kCNTestHeight; y++) {
+        uint8_t *pixel = pixels + y * kCNTestBytesPerRow;
+        for (int x = 0; x < kCNTestWidth; x++, pixel += 4) {
+            for (int channel = 0; channel < 3; channel++)
+                pixel[channel] = (uint8_t)((pixel[channel] * pixel[3] + 127) / 255);
+        }
+    }
+}
+
+static bool CNTestEncode(CNImageEncoder *encoder, const CNImageEncoderParameters *parameters, const uint8_t *pixels, int rowsPerCall, CNPixelBuffer *decoded)
+{
+    if (!CNImageEncoderBegin(encoder, parameters))
+        return false;
+    for (int y = 0; y < parameters->height; y += rowsPerCall) {
+        int rowCount = (parameters->height - y < rowsPerCall ? parameters->height - y : rowsPerCall);
+        if (!CNImageEncoderAppendRows(encoder, pixels + y * kCNTestBytesPerRow, kCNTestBytesPerRow, rowCount))
+            return false;
+    }
+    size_t length = 0;
+    const uint8_t *data = CNImageEncoderFinish(encoder, &length);
+    return (data != NULL && CNTestDecodePNG(data, length, decoded));
+}
+
+/// Returns the number of pixels of `decoded` that differ from `pixels`, with the red and blue channels of `pixels` swapped if
+/// they are BGRA and the alpha channel ignored if the image was written opaque.
+static long CNTestDifferences(const CNPixelBuffer *decoded, const uint8_t *pixels, CNImagePixelFormat pixelFormat, bool isOpaque)
+{
+    int red = (pixelFormat == CNImagePixelFormatBGRA ? 2 : 0);
+    long differences = 0;
+    for (int y = 0; y < kCNTestHeight; y++) {
+        const uint8_t *pixel = decoded->data + y * decoded->bytesPerRow;
+        const uint8_t *source = pixels + y * kCNTestBytesPerRow;
+        for (int x = 0; x < kCNTestWidth; x++, pixel += 4, source += 4) {
+            uint8_t alpha = (isOpaque ? 255 : source[3]);
+            if (pixel[0] != source[red] || pixel[1] != source[1] || pixel[2] != source[2 - red] || pixel[3] != alpha)
+                differences++;
+        }
+    }
+    return differences;
+}
+
+static void testOpaqueRoundTrip(void)
+{
+    uint8_t *pixels = CNTestCreateStraightImage(1, false);
+    CNImageEncoder *encoder = CNImageEncoderCreate();
+    CNImageEncoderParameters parameters;
+    CNImageEncoderDefaultParameters(&parameters, kCNTestWidth, kCNTestHeight);
+
+    /// an opaque image drops whatever is stored in the alpha channel
+    CNPixelBuffer decoded;
+    CNAssert(CNTestEncode(encoder, &parameters, pixels, kCNTestHeight, &decoded));
+    CNAssert(decoded.width == kCNTestWidth && decoded.height == kCNTestHeight);
+    CNAssert(CNTestDifferences(&decoded, pixels, CNImagePixelFormatRGBA, true) == 0);
+    CNPixelBufferFree(&decoded);
+
+    parameters.pixelFormat = CNImagePixelFormatBGRA;
+    CNAssert(CNTestEncode(encoder, &parameters, pixels, kCNTestHeight, &decoded));
+    CNAssert(CNTestDifferences(&decoded, pixels, CNImagePixelFormatBGRA, true) == 0);
+    CNPixelBufferFree(&decoded);
+
+    CNImageEncoderFree(encoder);
+    free(pixels);
+}
+
+static void testStraightAlphaRoundTrip(void)
+{
+    uint8_t *pixels = CNTestCreateStraightImage(2, false);
+    CNImageEncoder *encoder = CNImageEncoderCreate();
+    CNImageEncoderParameters parameters;
+    CNImageEncoderDefaultParameters(&parameters, kCNTestWidth, kCNTestHeight);
+    parameters.isOpaque = false;
+    parameters.isPremultiplied = false;
+
+    CNPixelBuffer decoded;
+    for (int pixelFormat = CNImagePixelFormatRGBA; pixelFormat <= CNImagePixelFormatBGRA; pixelFormat++) {
+        parameters.pixelFormat = (CNImagePixelFormat)pixelFormat;
+        CNAssert(CNTestEncode(encoder, &parameters, pixels, kCNTestHeight, &decoded));
+        CNAssert(CNTestDifferences(&decoded, pixels, parameters.pixelFormat, false) == 0);
+        CNPixelBufferFree(&decoded);
+    }
+
+    CNImageEncoderFree(encoder);
+    free(pixels);
+}
+
+static void testPremultipliedAlphaRoundTrip(void)
+{
+    uint8_t *pixels = CNTestCreateStraightImage(3, false);
+    pixels[3] = 0;
+    pixels[7] = 255;
+    CNTestPremultiply(pixels);
+    CNImageEncoderParameters parameters;
+    CNImageEncoderDefaultParameters(&parameters, kCNTestWidth, kCNTestHeight);
+    parameters.isOpaque = false;
+    parameters.pixelFormat = CNImagePixelFormatBGRA;
+
+    CNImageEncoder *encoder = CNImageEncoderCreate();
+    CNPixelBuffer decoded;
+    CNAssert(CNTestEncode(encoder, &parameters, pixels, kCNTestHeight, &decoded));
+
+    /// the straight colors can't be restored exactly, but premultiplying them again has to give the input back
+    uint8_t *first = decoded.data;
+    CNAssert(first[0] == 0 && first[1] == 0 && first[2] == 0 && first[3] == 0);
+    for (int y = 0; y < kCNTestHeight; y++) {
+        uint8_t *pixel = decoded.data + y * decoded.bytesPerRow;
+        for (int x = 0; x < kCNTestWidth; x++, pixel += 4) {
+            for (int channel = 0; channel < 3; channel++)
+                pixel[channel] = (uint8_t)((pixel[channel] * pixel[3] + 127) / 255);
+        }
+    }
+    CNAssert(CNTestDifferences(&decoded, pixels, CNImagePixelFormatBGRA, false) == 0);
+    CNPixelBufferFree(&decoded);
+
+    CNImageEncoderFree(encoder);
+    free(pixels);
+}
+
+static void testRowsPerCall(void)
+{
+    uint8_t *pixels = CNTestCreateStraightImage(4, true);
+    CNImageEncoder *encoder = CNImageEncoderCreate();
+    CNImageEncoderParameters parameters;
+    CNImageEncoderDefaultParameters(&parameters, kCNTestWidth, kCNTestHeight);
+
+    static const int rowsPerCall[] = { 1, 3, 7, 60 };
+    for (size_t i = 0; i < sizeof(rowsPerCall) / sizeof(rowsPerCall[0]); i++) {
+        CNPixelBuffer decoded;
+        CNAssert(CNTestEncode(encoder, &parameters, pixels, rowsPerCall[i], &decoded));
+        CNAssert(CNTestDifferences(&decoded, pixels, CNImagePixelFormatRGBA, true) == 0);
+        CNPixelBufferFree(&decoded);
+    }
+
+    CNImageEncoderFree(encoder);
+    free(pixels);
+}
+
+static void testCompressionLevels(void)
+{
+    uint8_t *pixels = CNTestCreateStraightImage(5, true);
+    CNImageEncoder *encoder = CNImageEncoderCreate();
+    CNImageEncoderParameters parameters;
+    CNImageEncoderDefaultParameters(&parameters, kCNTestWidth, kCNTestHeight);
+
+    for (int level = 0; level <= 9; level += 3) {
+        CNPixelBuffer decoded;
+        parameters.compressionLevel = level;
+        CNAssert(CNTestEncode(encoder, &parameters, pixels, 16, &decoded));
+        CNAssert(CNTestDifferences(&decoded, pixels, CNImagePixelFormatRGBA, true) == 0);
+        CNPixelBufferFree(&decoded);
+    }
+
+    CNImageEncoderFree(encoder);
+    free(pixels);
+}
+
+static void testEncoderReuse(void)
+{
+    uint8_t *pixels = CNTestCreateStraightImage(6, true);
+    CNImageEncoder *encoder = CNImageEncoderCreate();
+    CNImageEncoderParameters parameters;
+    CNImageEncoderDefaultParameters(&parameters, kCNTestWidth, kCNTestHeight);
+
+    size_t length = 0;
+    CNImageEncoderBegin(encoder, &parameters);
+    CNImageEncoderAppendRows(encoder, pixels, kCNTestBytesPerRow, kCNTestHeight);
+    const uint8_t *data = CNImageEncoderFinish(encoder, &length);
+    CNAssert(data != NULL);
+    uint8_t *firstData = malloc(length);
+    memcpy(firstData, data, length);
+    size_t firstLength = length;
+    size_t capacity = CNImageEncoderCapacity(encoder);
+
+    /// a smaller image in between must neither leak into the next one nor shrink the buffer
+    CNImageEncoderParameters smallParameters;
+    CNImageEncoderDefaultParameters(&smallParameters, 5, 3);
+    CNImageEncoderBegin(encoder, &smallParameters);
+    CNImageEncoderAppendRows(encoder, pixels, kCNTestBytesPerRow, 3);
+    CNAssert(CNImageEncoderFinish(encoder, &length) != NULL);
+
+    CNImageEncoderBegin(encoder, &parameters);
+    CNImageEncoderAppendRows(encoder, pixels, kCNTestBytesPerRow, kCNTestHeight);
+    data = CNImageEncoderFinish(encoder, &length);
+    CNAssert(data != NULL && length == firstLength && memcmp(data, firstData, length) == 0);
+    CNAssert(CNImageEncoderCapacity(encoder) == capacity);
+
+    free(firstData);
+    CNImageEncoderFree(encoder);
+    free(pixels);
+}
+
+static void testInvalidRowCounts(void)
+{
+    uint8_t *pixels = CNTestCreateStraightImage(7, true);
+    CNImageEncoder *encoder = CNImageEncoderCreate();
+    CNImageEncoderParameters parameters;
+    CNImageEncoderDefaultParameters(&parameters, kCNTestWidth, kCNTestHeight);
+    size_t length = 0;
+
+    CNAssert(CNImageEncoderBegin(encoder, &parameters));
+    CNAssert(CNImageEncoderAppendRows(encoder, pixels, kCNTestBytesPerRow, kCNTestHeight - 1));
+    CNAssert(CNImageEncoderFinish(encoder, &length) == NULL);
+
+    CNAssert(CNImageEncoderBegin(encoder, &parameters));
+    CNAssert(CNImageEncoderAppendRows(encoder, pixels, kCNTestBytesPerRow, kCNTestHeight));
+    CNAssert(!CNImageEncoderAppendRows(encoder, pixels, kCNTestBytesPerRow, 1));
+    CNAssert(CNImageEncoderFinish(encoder, &length) == NULL);
+
+    /// a failed image doesn't affect the next one
+    CNPixelBuffer decoded;
+    CNAssert(CNTestEncode(encoder, &parameters, pixels, kCNTestHeight, &decoded));
+    CNAssert(CNTestDifferences(&decoded, pixels, CNImagePixelFormatRGBA, true) == 0);
+    CNPixelBufferFree(&decoded);
+
+    CNImageEncoderFree(encoder);
+    free(pixels);
+}
+
+
+int main(void)
+{
+    CNTestRun(testOpaqueRoundTrip);
+    CNTestRun(testStraightAlphaRoundTrip);
+    CNTestRun(testPremultipliedAlphaRoundTrip);
+    CNTestRun(testRowsPerCall);
+    CNTestRun(testCompressionLevels);
+    CNTestRun(testEncoderReuse);
+    CNTestRun(testInvalidRowCounts);
+    return CNTestResult();
+}
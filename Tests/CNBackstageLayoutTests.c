@@ -0,0 +1,199 @@
+//
+//  CNBackstageLayoutTests.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+#include "CNTestSupport.h"
+#include "CNBackstageLayout.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Panels of a 1000x600 window: the main panel of 300 points, a right panel of 200, a top panel of 100 and a bottom panel
+/// of 50 points, so every frame and the remaining region can be checked against numbers that are easy to follow.
+
+static const double kCNTestWindowWidth = 1000;
+static const double kCNTestWindowHeight = 600;
+
+static CNLayoutPanels CNTestPanels(CNLayoutEdge mainEdge)
+{
+    CNLayoutPanels panels = { { 0, 0, 0, 0 } };
+    panels.thickness[mainEdge] = 300;
+    if (mainEdge != CNLayoutEdgeRight)
+        panels.thickness[CNLayoutEdgeRight] = 200;
+    if (mainEdge != CNLayoutEdgeTop)
+        panels.thickness[CNLayoutEdgeTop] = 100;
+    if (mainEdge != CNLayoutEdgeBottom)
+        panels.thickness[CNLayoutEdgeBottom] = 50;
+    return panels;
+}
+
+static bool CNTestRectEquals(CNLayoutRect rect, double x, double y, double width, double height)
+{
+    return (rect.x == x && rect.y == y && rect.width == width && rect.height == height);
+}
+
+static void testFramesOfMainPanel(void)
+{
+    CNLayoutFrames collapsedFrames, expandedFrames;
+    CNLayoutCollapsedFrames(CNLayoutEdgeLeft, CNLayoutAnimationSlide, kCNTestWindowWidth, kCNTestWindowHeight, 300, &collapsedFrames);
+    CNLayoutExpandedFrames(CNLayoutEdgeLeft, CNLayoutAnimationSlide, kCNTestWindowWidth, kCNTestWindowHeight, 300, &expandedFrames);
+    CNAssert(collapsedFrames.applicationFrame.x + collapsedFrames.applicationFrame.width <= 0);
+    CNAssert(CNTestRectEquals(expandedFrames.applicationFrame, 0, 0, 300, kCNTestWindowHeight));
+    CNAssert(expandedFrames.firstCoverFrame.x == 300);
+    CNAssert(!expandedFrames.hasSecondCover);
+
+    CNLayoutExpandedFrames(CNLayoutEdgeSplitHorizontal, CNLayoutAnimationSlide, kCNTestWindowWidth, kCNTestWindowHeight, 300, &expandedFrames);
+    CNAssert(expandedFrames.hasSecondCover);
+}
+
+static void testPanelsOnTheAxisOfTheMainPanel(void)
+{
+    /// left and right span the whole height, top and bottom fill the space between them
+    CNLayoutPanels panels = CNTestPanels(CNLayoutEdgeLeft);
+    CNLayoutRect panelFrames[4], remainingFrame;
+    CNLayoutPanelFrames(CNLayoutEdgeLeft, &panels, kCNTestWindowWidth, kCNTestWindowHeight, panelFrames, &remainingFrame);
+
+    CNAssert(CNTestRectEquals(panelFrames[CNLayoutEdgeLeft], 0, 0, 300, 600));
+    CNAssert(CNTestRectEquals(panelFrames[CNLayoutEdgeRight], 800, 0, 200, 600));
+    CNAssert(CNTestRectEquals(panelFrames[CNLayoutEdgeTop], 300, 500, 500, 100));
+    CNAssert(CNTestRectEquals(panelFrames[CNLayoutEdgeBottom], 300, 0, 500, 50));
+    CNAssert(CNTestRectEquals(remainingFrame, 300, 50, 500, 450));
+}
+
+static void testPanelsAcrossTheAxisOfTheMainPanel(void)
+{
+    CNLayoutPanels panels = CNTestPanels(CNLayoutEdgeTop);
+    panels.thickness[CNLayoutEdgeLeft] = 150;
+    CNLayoutRect panelFrames[4], remainingFrame;
+    CNLayoutPanelFrames(CNLayoutEdgeTop, &panels, kCNTestWindowWidth, kCNTestWindowHeight, panelFrames, &remainingFrame);
+
+    CNAssert(CNTestRectEquals(panelFrames[CNLayoutEdgeTop], 0, 300, 1000, 300));
+    CNAssert(CNTestRectEquals(panelFrames[CNLayoutEdgeBottom], 0, 0, 1000, 50));
+    CNAssert(CNTestRectEquals(panelFrames[CNLayoutEdgeLeft], 0, 50, 150, 250));
+    CNAssert(CNTestRectEquals(panelFrames[CNLayoutEdgeRight], 800, 50, 200, 250));
+    CNAssert(CNTestRectEquals(remainingFrame, 150, 50, 650, 250));
+}
+
+static void testRemainingFrameWithoutPanels(void)
+{
+    CNLayoutPanels panels = { { 0, 0, 0, 0 } };
+    panels.thickness[CNLayoutEdgeBottom] = 200;
+    CNLayoutRect panelFrames[4], remainingFrame;
+    CNLayoutPanelFrames(CNLayoutEdgeBottom, &panels, kCNTestWindowWidth, kCNTestWindowHeight, panelFrames, &remainingFrame);
+
+    CNAssert(CNTestRectEquals(remainingFrame, 0, 200, 1000, 400));
+    for (int edge = CNLayoutEdgeTop; edge <= CNLayoutEdgeRight; edge++) {
+        if (edge != CNLayoutEdgeBottom)
+            CNAssert(CNTestRectEquals(panelFrames[edge], 0, 0, 0, 0));
+    }
+}
+
+static void testOversizedPanels(void)
+{
+    /// panels that don't fit overlap each other, the remaining region is empty then but never negative
+    CNLayoutPanels panels = { { 0, 0, 600, 600 } };
+    CNLayoutRect panelFrames[4], remainingFrame;
+    CNLayoutPanelFrames(CNLayoutEdgeLeft, &panels, kCNTestWindowWidth, kCNTestWindowHeight, panelFrames, &remainingFrame);
+
+    CNAssert(remainingFrame.width == 0);
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 500, 300) == CNLayoutEdgeLeft);
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 700, 300) == CNLayoutEdgeRight);
+}
+
+static void testPanelAtPoint(void)
+{
+    CNLayoutPanels panels = CNTestPanels(CNLayoutEdgeLeft);
+    CNLayoutRect panelFrames[4], remainingFrame;
+    CNLayoutPanelFrames(CNLayoutEdgeLeft, &panels, kCNTestWindowWidth, kCNTestWindowHeight, panelFrames, &remainingFrame);
+
+    /// the corners belong to the panels that span the whole window
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 0, 0) == CNLayoutEdgeLeft);
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 299.5, 599.5) == CNLayoutEdgeLeft);
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 999.5, 0) == CNLayoutEdgeRight);
+
+    /// frames are half open, a shared border belongs to the panel that starts there
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 300, 599.5) == CNLayoutEdgeTop);
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 800, 10) == CNLayoutEdgeRight);
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 799.5, 10) == CNLayoutEdgeBottom);
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 500, 50) == -1);
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 500, 500) == CNLayoutEdgeTop);
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 500, 499.5) == -1);
+
+    /// outside of the window
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 1000, 300) == -1);
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, -0.5, 300) == -1);
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 500, 600) == -1);
+
+    /// a removed panel isn't hit, even if its stale frame is passed in
+    panels.thickness[CNLayoutEdgeTop] = 0;
+    CNAssert(CNLayoutPanelAtPoint(&panels, panelFrames, 500, 550) == -1);
+}
+
+static void testPanelAtPointIsConstantTime(void)
+{
+    /// a miss checks every panel, so the time for one panel and for four panels has to be about the same
+    enum { iterations = 2000000 };
+    double times[2];
+    for (int run = 0; run < 2; run++) {
+        CNLayoutPanels panels = (run == 0 ? (CNLayoutPanels){ { 0, 0, 300, 0 } } : CNTestPanels(CNLayoutEdgeLeft));
+        CNLayoutRect panelFrames[4], remainingFrame;
+        CNLayoutPanelFrames(CNLayoutEdgeLeft, &panels, kCNTestWindowWidth, kCNTestWindowHeight, panelFrames, &remainingFrame);
+
+        volatile int hits = 0;
+        double start = CNTestNow();
+        for (int i = 0; i < iterations; i++)
+            hits += (CNLayoutPanelAtPoint(&panels, panelFrames, 400 + (i & 255), 100 + (i & 127)) >= 0);
+        times[run] = CNTestNow() - start;
+        CNAssert(hits == 0);
+    }
+    CNAssert(times[1] < times[0] * 3);
+}
+
+static void testCollapsedPanelFrame(void)
+{
+    CNLayoutRect panelFrame = CNLayoutRectMake(800, 0, 200, 600);
+    CNLayoutRect collapsedFrame = CNLayoutCollapsedPanelFrame(CNLayoutEdgeRight, CNLayoutAnimationSlide, panelFrame);
+    CNAssert(CNTestRectEquals(collapsedFrame, 1000, 0, 200, 600));
+    collapsedFrame = CNLayoutCollapsedPanelFrame(CNLayoutEdgeTop, CNLayoutAnimationSlide, CNLayoutRectMake(300, 500, 500, 100));
+    CNAssert(CNTestRectEquals(collapsedFrame, 300, 600, 500, 100));
+    collapsedFrame = CNLayoutCollapsedPanelFrame(CNLayoutEdgeRight, CNLayoutAnimationFade, panelFrame);
+    CNAssert(CNTestRectEquals(collapsedFrame, 800, 0, 200, 600));
+}
+
+
+int main(void)
+{
+    CNTestRun(testFramesOfMainPanel);
+    CNTestRun(testPanelsOnTheAxisOfTheMainPanel);
+    CNTestRun(testPanelsAcrossTheAxisOfTheMainPanel);
+    CNTestRun(testRemainingFrameWithoutPanels);
+    CNTestRun(testOversizedPanels);
+    CNTestRun(testPanelAtPoint);
+    CNTestRun(testPanelAtPointIsConstantTime);
+    CNTestRun(testCollapsedPanelFrame);
+    return CNTestResult();
+}
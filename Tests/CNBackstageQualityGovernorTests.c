@@ -0,0 +1,231 @@
+//
+//  CNBackstageQualityGovernorTests.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CNTestSupport.h"
+#include "CNBackstageQualityGovernor.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The governor is fed with synthetic frame time traces: one session per expand, collapse or drag, the frame timestamps
+/// in seconds. Sessions start ten seconds apart, the pause in between must never count.
+
+static const double kCNTest60Hz     = 1.0 / 60.0;
+static const double kCNTest120Hz    = 1.0 / 120.0;
+static const unsigned int kCNTestAllLevels = 0x3f;
+
+typedef struct {
+    double sessionStart;
+    unsigned int levelChanges;
+} CNTestTrace;
+
+/// A session of `frameCount` frames `frameTime` apart, every `stallEvery`th frame (if not 0) takes `stallTime` instead.
+static void CNTestPlaySession(CNQualityGovernor *governor, CNTestTrace *trace, double displayInterval,
+                              int frameCount, double frameTime, int stallEvery, double stallTime)
+{
+    CNQualityGovernorBeginSession(governor, displayInterval);
+    double timestamp = trace->sessionStart;
+    for (int frame = 0; frame < frameCount; frame++) {
+        trace->levelChanges += CNQualityGovernorAddFrame(governor, timestamp);
+        timestamp += (stallEvery > 0 && frame % stallEvery == stallEvery - 1 ? stallTime : frameTime);
+    }
+    trace->levelChanges += CNQualityGovernorEndSession(governor);
+    trace->sessionStart += 10;
+}
+
+static void testSmoothSessionsKeepFullQuality(void)
+{
+    CNQualityGovernor governor;
+    CNQualityGovernorInit(&governor, kCNTestAllLevels);
+    CNTestTrace trace = { 0, 0 };
+    for (int session = 0; session < 20; session++)
+        CNTestPlaySession(&governor, &trace, kCNTest60Hz, 25, kCNTest60Hz, 0, 0);
+    CNAssert(governor.level == CNQualityLevelFull);
+    CNAssert(trace.levelChanges == 0);
+}
+
+static void testJitterIsNotJank(void)
+{
+    /// vsync jitter of +-30% rounds to the nominal interval
+    CNQualityGovernor governor;
+    CNQualityGovernorInit(&governor, kCNTestAllLevels);
+    CNQualityGovernorBeginSession(&governor, kCNTest60Hz);
+    uint32_t seed = 11;
+    double timestamp = 0;
+    bool levelDidChange = false;
+    for (int frame = 0; frame < 600; frame++) {
+        levelDidChange |= CNQualityGovernorAddFrame(&governor, timestamp);
+        timestamp += kCNTest60Hz * (0.7 + (CNTestRandom(&seed) % 61) / 100.0);
+    }
+    levelDidChange |= CNQualityGovernorEndSession(&governor);
+    CNAssert(!levelDidChange);
+    CNAssert(governor.level == CNQualityLevelFull);
+}
+
+static void testHalfFrameRateStepsDownOncePerSession(void)
+{
+    CNQualityGovernor governor;
+    CNQualityGovernorInit(&governor, kCNTestAllLevels);
+    CNTestTrace trace = { 0, 0 };
+
+    /// a long 30 fps drag has several bad windows, but the new level only applies to the next session
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 90, 1.0 / 30.0, 0, 0);
+    CNAssert(governor.level == CNQualityLevelReducedBlur);
+    CNAssert(trace.levelChanges == 1);
+
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 90, 1.0 / 30.0, 0, 0);
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 90, 1.0 / 30.0, 0, 0);
+    CNAssert(governor.level == CNQualityLevelNoShadows);
+
+    /// the lowest level is the floor
+    for (int session = 0; session < 10; session++)
+        CNTestPlaySession(&governor, &trace, kCNTest60Hz, 90, 1.0 / 30.0, 0, 0);
+    CNAssert(governor.level == CNQualityLevelStatic);
+    CNAssert(trace.levelChanges == CNQualityLevelStatic);
+}
+
+static void testHighRefreshRateDisplay(void)
+{
+    /// 60 fps is fine on a 60 Hz display, but misses every second frame at 120 Hz
+    CNQualityGovernor governor;
+    CNQualityGovernorInit(&governor, kCNTestAllLevels);
+    CNTestTrace trace = { 0, 0 };
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 60, kCNTest60Hz, 0, 0);
+    CNAssert(governor.level == CNQualityLevelFull);
+    CNTestPlaySession(&governor, &trace, kCNTest120Hz, 60, kCNTest60Hz, 0, 0);
+    CNAssert(governor.level == CNQualityLevelReducedBlur);
+}
+
+static void testSingleStallDoesNotStepDown(void)
+{
+    /// a half second hiccup counts as three missed frames at most
+    CNQualityGovernor governor;
+    CNQualityGovernorInit(&governor, kCNTestAllLevels);
+    CNTestTrace trace = { 0, 0 };
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 60, kCNTest60Hz, 40, 0.5);
+    CNAssert(governor.level == CNQualityLevelFull);
+
+    /// regular stalls do
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 60, kCNTest60Hz, 5, 0.5);
+    CNAssert(governor.level == CNQualityLevelReducedBlur);
+}
+
+static void testShortSessionsAreIgnored(void)
+{
+    CNQualityGovernor governor;
+    CNQualityGovernorInit(&governor, kCNTestAllLevels);
+    CNTestTrace trace = { 0, 0 };
+    /// five frames at 30 fps span eight nominal frames, less than a window worth evaluating
+    for (int session = 0; session < 20; session++)
+        CNTestPlaySession(&governor, &trace, kCNTest60Hz, 5, 1.0 / 30.0, 0, 0);
+    CNAssert(governor.level == CNQualityLevelFull);
+}
+
+static void testRecoveryAndBackoff(void)
+{
+    CNQualityGovernor governor;
+    CNQualityGovernorInit(&governor, kCNTestAllLevels);
+    CNTestTrace trace = { 0, 0 };
+    for (int session = 0; session < 3; session++)
+        CNTestPlaySession(&governor, &trace, kCNTest60Hz, 90, 1.0 / 30.0, 0, 0);
+    CNAssert(governor.level == CNQualityLevelNoShadows);
+
+    /// four good windows step up one level and start probing it
+    for (int session = 0; session < 4; session++)
+        CNTestPlaySession(&governor, &trace, kCNTest60Hz, 25, kCNTest60Hz, 0, 0);
+    CNAssert(governor.level == CNQualityLevelNoBlur);
+    CNAssert(governor.isProbing);
+
+    /// the probe fails at once, the next step up needs twice as many good windows
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 25, 1.0 / 30.0, 0, 0);
+    CNAssert(governor.level == CNQualityLevelNoShadows);
+    CNAssert(governor.goodWindowsRequired == 8);
+
+    for (int session = 0; session < 7; session++)
+        CNTestPlaySession(&governor, &trace, kCNTest60Hz, 25, kCNTest60Hz, 0, 0);
+    CNAssert(governor.level == CNQualityLevelNoShadows);
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 25, kCNTest60Hz, 0, 0);
+    CNAssert(governor.level == CNQualityLevelNoBlur);
+
+    /// a probe that holds halves the requirement again
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 25, kCNTest60Hz, 0, 0);
+    CNAssert(!governor.isProbing);
+    CNAssert(governor.goodWindowsRequired == 4);
+}
+
+static void testOscillatingMachineBacksOff(void)
+{
+    /// alternating good and bad phases must not flip the level on every expand
+    CNQualityGovernor governor;
+    CNQualityGovernorInit(&governor, kCNTestAllLevels);
+    CNTestTrace trace = { 0, 0 };
+    for (int cycle = 0; cycle < 8; cycle++) {
+        for (int session = 0; session < 4; session++)
+            CNTestPlaySession(&governor, &trace, kCNTest60Hz, 25, kCNTest60Hz, 0, 0);
+        CNTestPlaySession(&governor, &trace, kCNTest60Hz, 25, 1.0 / 30.0, 0, 0);
+    }
+    CNAssert(governor.goodWindowsRequired > 4);
+    CNAssert(trace.levelChanges < 8 * 2);
+}
+
+static void testInapplicableLevelsAreSkipped(void)
+{
+    /// without blur and shadows only the animation can be reduced
+    CNQualityGovernor governor;
+    CNQualityGovernorInit(&governor, CNQualityLevelMask(CNQualityLevelFade) | CNQualityLevelMask(CNQualityLevelStatic));
+    CNTestTrace trace = { 0, 0 };
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 11, 1.0 / 20.0, 0, 0);
+    CNAssert(governor.level == CNQualityLevelFade);
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 11, 1.0 / 20.0, 0, 0);
+    CNAssert(governor.level == CNQualityLevelStatic);
+    CNTestPlaySession(&governor, &trace, kCNTest60Hz, 11, 1.0 / 20.0, 0, 0);
+    CNAssert(governor.level == CNQualityLevelStatic);
+
+    for (int session = 0; session < 4; session++)
+        CNTestPlaySession(&governor, &trace, kCNTest60Hz, 25, kCNTest60Hz, 0, 0);
+    CNAssert(governor.level == CNQualityLevelFade);
+
+    CNQualityGovernorReset(&governor);
+    CNAssert(governor.level == CNQualityLevelFull);
+}
+
+int main(void)
+{
+    CNTestRun(testSmoothSessionsKeepFullQuality);
+    CNTestRun(testJitterIsNotJank);
+    CNTestRun(testHalfFrameRateStepsDownOncePerSession);
+    CNTestRun(testHighRefreshRateDisplay);
+    CNTestRun(testSingleStallDoesNotStepDown);
+    CNTestRun(testShortSessionsAreIgnored);
+    CNTestRun(testRecoveryAndBackoff);
+    CNTestRun(testOscillatingMachineBacksOff);
+    CNTestRun(testInapplicableLevelsAreSkipped);
+    return CNTestResult();
+}
@@ -0,0 +1,211 @@
+//
+//  CNBackstageSnapshotBufferTests.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+#include "CNTestSupport.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "CNBackstageSnapshotBuffer.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The shared memory tests fork a reader process that maps the buffer of its parent, the two synchronize over pipes.
+
+static const int kCNTestWidth = 301;
+static const int kCNTestHeight = 97;
+static const size_t kCNTestBytesPerRow = 301 * 4 + 12;
+static const char *kCNTestSharedName = "/cnbackstage.test";
+
+static int CNTestReleasedTag = 0;
+
+static void CNTestReleaseCallback(void *context)
+{
+    CNTestReleasedTag = *(int *)context;
+}
+
+static CNSnapshotBufferInfo CNTestInfo(void)
+{
+    CNSnapshotBufferInfo info;
+    info.width = kCNTestWidth;
+    info.height = kCNTestHeight;
+    info.bytesPerRow = kCNTestBytesPerRow;
+    info.pixelFormat = CNImagePixelFormatBGRA;
+    info.isOpaque = true;
+    info.backingScale = 2.0;
+    info.displayID = 42;
+    return info;
+}
+
+/// The last row doesn't need its padding.
+static size_t CNTestMinimumLength(void)
+{
+    return kCNTestBytesPerRow * (kCNTestHeight - 1) + (size_t)kCNTestWidth * 4;
+}
+
+static uint8_t *CNTestCreatePixels(void)
+{
+    uint8_t *pixels = malloc(kCNTestBytesPerRow * kCNTestHeight);
+    for (size_t i = 0; i < kCNTestBytesPerRow * kCNTestHeight; i++)
+        pixels[i] = (uint8_t)(i * 7 + 3);
+    return pixels;
+}
+
+static void testBytesAreNotCopied(void)
+{
+    uint8_t *pixels = CNTestCreatePixels();
+    CNSnapshotBufferInfo info = CNTestInfo();
+    int tag = 7;
+    CNTestReleasedTag = 0;
+
+    CNSnapshotBuffer *buffer = CNSnapshotBufferCreateWithBytes(&info, pixels, CNTestMinimumLength(), CNTestReleaseCallback, &tag);
+    CNAssert(buffer != NULL);
+    CNAssert(CNSnapshotBufferGetBytes(buffer) == pixels);
+    CNAssert(CNSnapshotBufferGetBacking(buffer) == CNSnapshotBufferBackingBytes);
+    CNAssert(CNSnapshotBufferGetInfo(buffer)->displayID == 42);
+
+    CNAssert(CNSnapshotBufferRetain(buffer) == buffer);
+    CNSnapshotBufferRelease(buffer);
+    CNAssert(CNTestReleasedTag == 0);
+    CNSnapshotBufferRelease(buffer);
+    CNAssert(CNTestReleasedTag == 7);
+
+    CNAssert(CNSnapshotBufferRetain(NULL) == NULL);
+    CNSnapshotBufferRelease(NULL);
+    free(pixels);
+}
+
+static void testInvalidGeometry(void)
+{
+    uint8_t *pixels = CNTestCreatePixels();
+    CNSnapshotBufferInfo info = CNTestInfo();
+    int tag = 9;
+    CNTestReleasedTag = 0;
+
+    /// the callback isn't called for a buffer that was never created
+    CNAssert(CNSnapshotBufferCreateWithBytes(&info, pixels, CNTestMinimumLength() - 1, CNTestReleaseCallback, &tag) == NULL);
+    CNAssert(CNTestReleasedTag == 0);
+
+    info.bytesPerRow = (size_t)kCNTestWidth * 4 - 1;
+    CNAssert(CNSnapshotBufferCreateWithBytes(&info, pixels, kCNTestBytesPerRow * kCNTestHeight, NULL, NULL) == NULL);
+    info = CNTestInfo();
+    info.width = 0;
+    CNAssert(CNSnapshotBufferCreateWithBytes(&info, pixels, kCNTestBytesPerRow * kCNTestHeight, NULL, NULL) == NULL);
+    free(pixels);
+}
+
+static void testSharedMemoryInProcess(void)
+{
+    uint8_t *pixels = CNTestCreatePixels();
+    CNSnapshotBufferInfo info = CNTestInfo();
+    CNSnapshotBufferRelease(CNSnapshotBufferOpenShared(kCNTestSharedName));
+
+    CNSnapshotBuffer *buffer = CNSnapshotBufferCreateShared(&info, pixels, kCNTestSharedName);
+    CNAssert(buffer != NULL);
+    CNAssert(CNSnapshotBufferGetBacking(buffer) == CNSnapshotBufferBackingSharedMemory);
+    CNAssert(memcmp(CNSnapshotBufferGetBytes(buffer), pixels, CNTestMinimumLength()) == 0);
+
+    /// names are exclusive
+    CNAssert(CNSnapshotBufferCreateShared(&info, pixels, kCNTestSharedName) == NULL);
+
+    CNSnapshotBuffer *openedBuffer = CNSnapshotBufferOpenShared(kCNTestSharedName);
+    CNAssert(openedBuffer != NULL);
+    CNSnapshotBufferRelease(buffer);
+    CNAssert(memcmp(CNSnapshotBufferGetBytes(openedBuffer), pixels, CNTestMinimumLength()) == 0);
+    CNSnapshotBufferRelease(openedBuffer);
+
+    CNAssert(CNSnapshotBufferOpenShared(kCNTestSharedName) == NULL);
+    free(pixels);
+}
+
+static bool CNTestReaderProcess(const uint8_t *pixels, int readyPipe, int releasedPipe)
+{
+    CNSnapshotBuffer *buffer = CNSnapshotBufferOpenShared(kCNTestSharedName);
+    bool isValid = (buffer != NULL);
+    if (isValid) {
+        const CNSnapshotBufferInfo *info = CNSnapshotBufferGetInfo(buffer);
+        isValid = (info->width == kCNTestWidth && info->height == kCNTestHeight && info->bytesPerRow == kCNTestBytesPerRow &&
+                   info->pixelFormat == CNImagePixelFormatBGRA && info->isOpaque && info->backingScale == 2.0 && info->displayID == 42 &&
+                   CNSnapshotBufferGetBacking(buffer) == CNSnapshotBufferBackingSharedMemory &&
+                   memcmp(CNSnapshotBufferGetBytes(buffer), pixels, CNTestMinimumLength()) == 0);
+    }
+    if (write(readyPipe, &isValid, sizeof(isValid)) != sizeof(isValid))
+        return false;
+
+    /// the creator has released its buffer and unlinked the name meanwhile, the mapping stays valid
+    char signal;
+    if (read(releasedPipe, &signal, 1) != 1)
+        return false;
+    bool isStillValid = (isValid && memcmp(CNSnapshotBufferGetBytes(buffer), pixels, CNTestMinimumLength()) == 0);
+    CNSnapshotBuffer *reopenedBuffer = CNSnapshotBufferOpenShared(kCNTestSharedName);
+    CNSnapshotBufferRelease(reopenedBuffer);
+    CNSnapshotBufferRelease(buffer);
+    return (isStillValid && reopenedBuffer == NULL);
+}
+
+static void testSharedMemoryAcrossProcesses(void)
+{
+    uint8_t *pixels = CNTestCreatePixels();
+    CNSnapshotBufferInfo info = CNTestInfo();
+    CNSnapshotBuffer *buffer = CNSnapshotBufferCreateShared(&info, pixels, kCNTestSharedName);
+    CNAssert(buffer != NULL);
+
+    int readyPipe[2], releasedPipe[2];
+    CNAssert(pipe(readyPipe) == 0 && pipe(releasedPipe) == 0);
+    pid_t pid = fork();
+    CNAssert(pid >= 0);
+    if (pid == 0)
+        _exit(CNTestReaderProcess(pixels, readyPipe[1], releasedPipe[0]) ? EXIT_SUCCESS : EXIT_FAILURE);
+
+    bool readerIsValid = false;
+    CNAssert(read(readyPipe[0], &readerIsValid, sizeof(readerIsValid)) == sizeof(readerIsValid));
+    CNAssert(readerIsValid);
+    CNSnapshotBufferRelease(buffer);
+    CNAssert(write(releasedPipe[1], "x", 1) == 1);
+
+    int status = 0;
+    CNAssert(waitpid(pid, &status, 0) == pid);
+    CNAssert(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    CNAssert(CNSnapshotBufferOpenShared(kCNTestSharedName) == NULL);
+
+    close(readyPipe[0]);
+    close(readyPipe[1]);
+    close(releasedPipe[0]);
+    close(releasedPipe[1]);
+    free(pixels);
+}
+
+
+int main(void)
+{
+    CNTestRun(testBytesAreNotCopied);
+    CNTestRun(testInvalidGeometry);
+    CNTestRun(testSharedMemoryInProcess);
+    CNTestRun(testSharedMemoryAcrossProcesses);
+    return CNTestResult();
+}
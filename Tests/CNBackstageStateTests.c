@@ -0,0 +1,319 @@
+//
+//  CNBackstageStateTests.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CNTestSupport.h"
+#include <string.h>
+#include "CNBackstageState.h"
+#include "CNBackstageCompositor.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The state record is encoded and decoded like the controller does when it writes to and restores from its state store.
+/// The save scheduler is driven by a simulated clock.
+
+static const CNDisplayIdentity kCNTestBuiltInDisplay  = { 1552, 40998, 0 };
+static const CNDisplayIdentity kCNTestExternalDisplay = { 7789, 30853, 16843009 };
+
+static bool CNTestDecode(CNStateRecord *record, const char *text, int displayCount)
+{
+    return CNStateRecordDecode(record, text, strlen(text), displayCount);
+}
+
+static void CNTestFillRecord(CNStateRecord *record)
+{
+    CNStateRecordInit(record);
+    record->fields = CNStateFieldEdge | CNStateFieldSize | CNStateFieldDisplay | CNStateFieldVisualEffects |
+                     CNStateFieldAnimation | CNStateFieldOverlayAlpha | CNStateFieldShadows;
+    record->edge = CNLayoutEdgeRight;
+    record->sizeWidth = 480;
+    record->sizeHeight = 2;
+    record->display = 1;
+    record->visualEffects = CNCompositorEffectOverlayBlack | CNCompositorEffectGaussianBlur;
+    record->animation = CNLayoutAnimationFade;
+    record->overlayAlpha = 0.75;
+    record->shouldUseShadows = true;
+    CNAssert(CNDraggedSizesSet(&record->draggedSizes, kCNTestBuiltInDisplay, CNLayoutEdgeLeft, 512));
+    CNAssert(CNDraggedSizesSet(&record->draggedSizes, kCNTestExternalDisplay, CNLayoutEdgeTop, 300));
+}
+
+static void testRoundTrip(void)
+{
+    CNStateRecord record, restored;
+    CNTestFillRecord(&record);
+
+    size_t length = CNStateRecordEncode(&record, NULL, 0);
+    char *text = malloc(length + 1);
+    CNAssert(CNStateRecordEncode(&record, text, length + 1) == length);
+    CNAssert(strlen(text) == length);
+    CNAssert(strncmp(text, "CNBackstageState 1\n", 19) == 0);
+
+    CNAssert(CNStateRecordDecode(&restored, text, length, 2));
+    CNAssert(restored.fields == record.fields);
+    CNAssert(restored.edge == CNLayoutEdgeRight);
+    CNAssert(restored.sizeWidth == 480 && restored.sizeHeight == 2);
+    CNAssert(restored.display == 1);
+    CNAssert(restored.visualEffects == record.visualEffects);
+    CNAssert(restored.animation == CNLayoutAnimationFade);
+    CNAssertEqualsWithAccuracy(restored.overlayAlpha, 0.75, 1e-9);
+    CNAssert(restored.shouldUseShadows);
+
+    long size = 0;
+    CNAssert(restored.draggedSizes.count == 2);
+    CNAssert(CNDraggedSizesGet(&restored.draggedSizes, kCNTestBuiltInDisplay, CNLayoutEdgeLeft, &size) && size == 512);
+    CNAssert(CNDraggedSizesGet(&restored.draggedSizes, kCNTestExternalDisplay, CNLayoutEdgeTop, &size) && size == 300);
+
+    free(text);
+    CNStateRecordFree(&record);
+    CNStateRecordFree(&restored);
+}
+
+static void testEncodeIntoShortBuffer(void)
+{
+    /// like snprintf the text is cut, but always terminated, and the whole length is returned
+    CNStateRecord record;
+    CNTestFillRecord(&record);
+    size_t length = CNStateRecordEncode(&record, NULL, 0);
+
+    char buffer[24];
+    memset(buffer, 'x', sizeof(buffer));
+    CNAssert(CNStateRecordEncode(&record, buffer, sizeof(buffer)) == length);
+    CNAssert(strlen(buffer) == sizeof(buffer) - 1);
+    CNStateRecordFree(&record);
+}
+
+static void testOtherVersionsAreRejected(void)
+{
+    CNStateRecord record;
+    CNAssert(!CNTestDecode(&record, "CNBackstageState 2\nedge 1\n", 1));
+    CNAssert(record.fields == 0);
+    CNAssert(!CNTestDecode(&record, "CNBackstageState 0\nedge 1\n", 1));
+    CNAssert(!CNTestDecode(&record, "CNBackstageState\nedge 1\n", 1));
+    CNAssert(!CNTestDecode(&record, "edge 1\nCNBackstageState 1\n", 1));
+    CNAssert(!CNTestDecode(&record, "", 1));
+
+    /// a binary property list, as written by earlier builds
+    static const char plist[] = "bplist00\xd1\x01\x02_\x10\x17" "CNBackstageState";
+    CNAssert(!CNStateRecordDecode(&record, plist, sizeof(plist) - 1, 1));
+    CNAssert(record.draggedSizes.count == 0);
+
+    CNAssert(CNTestDecode(&record, "CNBackstageState 1", 1));
+    CNAssert(record.fields == 0);
+}
+
+static void testOutOfRangeValuesAreSkipped(void)
+{
+    CNStateRecord record;
+    CNAssert(CNTestDecode(&record,
+                          "CNBackstageState 1\n"
+                          "edge 6\n"
+                          "size 480\n"
+                          "display 4\n"
+                          "visualEffects 4\n"
+                          "animation 3\n"
+                          "shadows 2\n"
+                          "dragged 1552 40998 0 6 512\n"
+                          "dragged 1552 40998 0 2 0\n"
+                          "dragged 1552 40998 4294967296 2 512\n", 8));
+    CNAssert(record.fields == 0);
+    CNAssert(record.draggedSizes.count == 0);
+
+    /// negative numbers, trailing garbage and overflows are not values
+    CNAssert(CNTestDecode(&record,
+                          "CNBackstageState 1\n"
+                          "edge -1\n"
+                          "edge 2x\n"
+                          "edge 2 \n"
+                          "edge  2\n"
+                          "display 99999999999999999999999\n"
+                          "unknownKey 1\n"
+                          "animation 1 1\n", 8));
+    CNAssert(record.fields == 0);
+
+    /// the values that are valid are still taken
+    CNAssert(CNTestDecode(&record, "CNBackstageState 1\nedge 9\nanimation 2\n", 1));
+    CNAssert(record.fields == CNStateFieldAnimation);
+    CNAssert(record.animation == CNLayoutAnimationSlide);
+}
+
+static void testDisplayIsCheckedAgainstDisplayCount(void)
+{
+    CNStateRecord record;
+    CNAssert(CNTestDecode(&record, "CNBackstageState 1\ndisplay 1\n", 2));
+    CNAssert(record.fields == CNStateFieldDisplay && record.display == 1);
+
+    /// the second display is unplugged, the controller keeps its current display
+    CNAssert(CNTestDecode(&record, "CNBackstageState 1\ndisplay 1\n", 1));
+    CNAssert(record.fields == 0);
+
+    /// there are only four CNToggleDisplay values
+    CNAssert(CNTestDecode(&record, "CNBackstageState 1\ndisplay 3\n", 16));
+    CNAssert(record.fields == CNStateFieldDisplay);
+    CNAssert(CNTestDecode(&record, "CNBackstageState 1\ndisplay 4\n", 16));
+    CNAssert(record.fields == 0);
+    CNAssert(CNTestDecode(&record, "CNBackstageState 1\ndisplay 0\n", 0));
+    CNAssert(record.fields == 0);
+}
+
+static void testOverlayAlphaIsClamped(void)
+{
+    CNStateRecord record;
+    CNAssert(CNTestDecode(&record, "CNBackstageState 1\noverlayAlpha 2500000\n", 1));
+    CNAssert(record.fields == CNStateFieldOverlayAlpha);
+    CNAssertEqualsWithAccuracy(record.overlayAlpha, 1.0, 1e-12);
+
+    /// a value out of range is clamped on encoding as well
+    char text[64];
+    CNStateRecordInit(&record);
+    record.fields = CNStateFieldOverlayAlpha;
+    record.overlayAlpha = -0.5;
+    CNStateRecordEncode(&record, text, sizeof(text));
+    CNAssert(strcmp(text, "CNBackstageState 1\noverlayAlpha 0\n") == 0);
+
+    record.overlayAlpha = NAN;
+    CNStateRecordEncode(&record, text, sizeof(text));
+    CNAssert(strcmp(text, "CNBackstageState 1\n") == 0);
+}
+
+static void testDraggedSizesAreKeyedByDisplayAndEdge(void)
+{
+    CNDraggedSizes sizes = { NULL, 0, 0 };
+    long size = 0;
+    CNAssert(!CNDraggedSizesGet(&sizes, kCNTestBuiltInDisplay, CNLayoutEdgeLeft, &size));
+
+    CNAssert(CNDraggedSizesSet(&sizes, kCNTestBuiltInDisplay, CNLayoutEdgeLeft, 400));
+    CNAssert(CNDraggedSizesSet(&sizes, kCNTestBuiltInDisplay, CNLayoutEdgeTop, 200));
+    CNAssert(CNDraggedSizesSet(&sizes, kCNTestExternalDisplay, CNLayoutEdgeLeft, 600));
+    CNAssert(CNDraggedSizesSet(&sizes, kCNTestBuiltInDisplay, CNLayoutEdgeLeft, 420));
+    CNAssert(sizes.count == 3);
+
+    CNAssert(CNDraggedSizesGet(&sizes, kCNTestBuiltInDisplay, CNLayoutEdgeLeft, &size) && size == 420);
+    CNAssert(CNDraggedSizesGet(&sizes, kCNTestBuiltInDisplay, CNLayoutEdgeTop, &size) && size == 200);
+    CNAssert(CNDraggedSizesGet(&sizes, kCNTestExternalDisplay, CNLayoutEdgeLeft, &size) && size == 600);
+
+    /// the same model with another serial number is another display
+    CNDisplayIdentity otherDisplay = kCNTestBuiltInDisplay;
+    otherDisplay.serial = 1;
+    CNAssert(!CNDraggedSizesGet(&sizes, otherDisplay, CNLayoutEdgeLeft, &size));
+
+    /// an explicit toggle size removes only the entry of the current display and edge
+    CNDraggedSizesRemove(&sizes, kCNTestBuiltInDisplay, CNLayoutEdgeLeft);
+    CNAssert(sizes.count == 2);
+    CNAssert(!CNDraggedSizesGet(&sizes, kCNTestBuiltInDisplay, CNLayoutEdgeLeft, &size));
+    CNAssert(CNDraggedSizesGet(&sizes, kCNTestBuiltInDisplay, CNLayoutEdgeTop, &size) && size == 200);
+    CNAssert(CNDraggedSizesGet(&sizes, kCNTestExternalDisplay, CNLayoutEdgeLeft, &size) && size == 600);
+    CNDraggedSizesRemove(&sizes, kCNTestBuiltInDisplay, CNLayoutEdgeLeft);
+    CNAssert(sizes.count == 2);
+
+    CNAssert(!CNDraggedSizesSet(&sizes, kCNTestBuiltInDisplay, (CNLayoutEdge)6, 400));
+    CNAssert(!CNDraggedSizesSet(&sizes, kCNTestBuiltInDisplay, CNLayoutEdgeLeft, 0));
+
+    CNDraggedSizes copy = { NULL, 0, 0 };
+    CNAssert(CNDraggedSizesCopy(&copy, &sizes));
+    CNDraggedSizesFree(&sizes);
+    CNAssert(sizes.count == 0 && sizes.entries == NULL);
+    CNAssert(CNDraggedSizesGet(&copy, kCNTestExternalDisplay, CNLayoutEdgeLeft, &size) && size == 600);
+
+    /// more entries than the initial capacity
+    for (int i = 0; i < 40; i++)
+        CNAssert(CNDraggedSizesSet(&copy, (CNDisplayIdentity){ 1, 2, (uint32_t)i }, CNLayoutEdgeBottom, 100 + i));
+    CNAssert(copy.count == 42);
+    CNAssert(CNDraggedSizesGet(&copy, (CNDisplayIdentity){ 1, 2, 39 }, CNLayoutEdgeBottom, &size) && size == 139);
+    CNDraggedSizesFree(&copy);
+}
+
+static void testBurstIsCoalescedIntoOneSave(void)
+{
+    CNStateSaveScheduler scheduler;
+    CNStateSaveSchedulerInit(&scheduler, 0.5);
+    CNAssert(CNStateSaveSchedulerTick(&scheduler, 0) == CNStateSaveActionNone);
+
+    /// a slider is dragged for a second, a change every 16 ms, only the first change schedules a tick
+    int scheduledTicks = 0;
+    for (int i = 0; i <= 60; i++) {
+        if (CNStateSaveSchedulerChange(&scheduler, 10 + i * 0.016))
+            scheduledTicks++;
+    }
+    CNAssert(scheduledTicks == 1);
+
+    /// the tick scheduled by the first change comes too early and waits for the last change
+    double now = 10.5;
+    int saves = 0, ticks = 0;
+    CNStateSaveAction action;
+    while ((action = CNStateSaveSchedulerTick(&scheduler, now)) == CNStateSaveActionWait) {
+        CNAssert(scheduler.deadline > now);
+        now = scheduler.deadline;
+        ticks++;
+    }
+    if (action == CNStateSaveActionSave)
+        saves++;
+    CNAssert(saves == 1 && ticks == 1);
+    CNAssertEqualsWithAccuracy(now, 10 + 60 * 0.016 + 0.5, 1e-9);
+
+    /// nothing is pending afterwards, the next change schedules a new tick
+    CNAssert(CNStateSaveSchedulerTick(&scheduler, now + 1) == CNStateSaveActionNone);
+    CNAssert(CNStateSaveSchedulerChange(&scheduler, 20));
+    CNAssert(CNStateSaveSchedulerTick(&scheduler, 20.5) == CNStateSaveActionSave);
+}
+
+static void testFlushAndReset(void)
+{
+    CNStateSaveScheduler scheduler;
+    CNStateSaveSchedulerInit(&scheduler, 0.5);
+    CNAssert(!CNStateSaveSchedulerFlush(&scheduler));
+
+    /// the application terminates before the tick
+    CNAssert(CNStateSaveSchedulerChange(&scheduler, 1));
+    CNAssert(CNStateSaveSchedulerFlush(&scheduler));
+    CNAssert(!CNStateSaveSchedulerFlush(&scheduler));
+    CNAssert(CNStateSaveSchedulerTick(&scheduler, 1.5) == CNStateSaveActionNone);
+
+    /// another store is assigned, its changes don't need the tick of the previous one
+    CNAssert(CNStateSaveSchedulerChange(&scheduler, 2));
+    CNStateSaveSchedulerReset(&scheduler);
+    CNAssert(!CNStateSaveSchedulerChange(&scheduler, 2.2));
+    CNAssert(CNStateSaveSchedulerTick(&scheduler, 2.5) == CNStateSaveActionWait);
+    CNAssert(CNStateSaveSchedulerTick(&scheduler, 2.7) == CNStateSaveActionSave);
+    CNAssert(!CNStateSaveSchedulerFlush(&scheduler));
+}
+
+int main(void)
+{
+    CNTestRun(testRoundTrip);
+    CNTestRun(testEncodeIntoShortBuffer);
+    CNTestRun(testOtherVersionsAreRejected);
+    CNTestRun(testOutOfRangeValuesAreSkipped);
+    CNTestRun(testDisplayIsCheckedAgainstDisplayCount);
+    CNTestRun(testOverlayAlphaIsClamped);
+    CNTestRun(testDraggedSizesAreKeyedByDisplayAndEdge);
+    CNTestRun(testBurstIsCoalescedIntoOneSave);
+    CNTestRun(testFlushAndReset);
+    return CNTestResult();
+}
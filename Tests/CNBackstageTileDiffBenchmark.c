@@ -0,0 +1,88 @@
+//
+//  CNBackstageTileDiffBenchmark.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CNTestSupport.h"
+#include <string.h>
+#include "CNBackstageTileDiff.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Measures the tile grid on a synthetic 2880x1800 Retina capture: hashing a full frame, an unchanged frame, and a
+/// sequence in which a 320x180 video rect moves over the screen, which is the typical live cover refresh.
+
+static const int kCNBenchmarkWidth      = 2880;
+static const int kCNBenchmarkHeight     = 1800;
+static const int kCNBenchmarkFrames     = 60;
+
+int main(void)
+{
+    size_t bytesPerRow = (size_t)kCNBenchmarkWidth * 4 + 64;
+    uint8_t *pixels = malloc(bytesPerRow * kCNBenchmarkHeight);
+    if (pixels == NULL)
+        return EXIT_FAILURE;
+    uint32_t seed = 1;
+    for (size_t i = 0; i < bytesPerRow * kCNBenchmarkHeight; i++)
+        pixels[i] = (uint8_t)CNTestRandom(&seed);
+
+    CNTileGrid grid;
+    if (!CNTileGridInit(&grid, kCNBenchmarkWidth, kCNBenchmarkHeight, 64))
+        return EXIT_FAILURE;
+    int *changedTiles = malloc(sizeof(int) * (size_t)CNTileGridTileCount(&grid));
+
+    double start = CNTestNow();
+    int changedCount = CNTileGridUpdate(&grid, pixels, bytesPerRow, changedTiles);
+    double firstFrame = CNTestNow() - start;
+
+    start = CNTestNow();
+    for (int frame = 0; frame < kCNBenchmarkFrames; frame++)
+        changedCount = CNTileGridUpdate(&grid, pixels, bytesPerRow, changedTiles);
+    double unchangedFrame = (CNTestNow() - start) / kCNBenchmarkFrames;
+
+    int totalChanged = 0;
+    start = CNTestNow();
+    for (int frame = 0; frame < kCNBenchmarkFrames; frame++) {
+        for (int y = 800; y < 980; y++)
+            memset(pixels + bytesPerRow * y + 4 * (1000 + frame * 4), frame, 320 * 4);
+        totalChanged += CNTileGridUpdate(&grid, pixels, bytesPerRow, changedTiles);
+    }
+    double videoFrame = (CNTestNow() - start) / kCNBenchmarkFrames;
+
+    double bytesPerFrame = (double)kCNBenchmarkWidth * kCNBenchmarkHeight * 4;
+    printf("tile grid %dx%d, %d tiles\n", kCNBenchmarkWidth, kCNBenchmarkHeight, CNTileGridTileCount(&grid));
+    printf("  first frame       %7.2f ms\n", firstFrame * 1e3);
+    printf("  unchanged frame   %7.2f ms  %5.1f GB/s  %d changed\n", unchangedFrame * 1e3, bytesPerFrame / unchangedFrame / 1e9, changedCount);
+    printf("  moving video      %7.2f ms  %5.1f GB/s  %d changed per frame\n", videoFrame * 1e3, bytesPerFrame / videoFrame / 1e9, totalChanged / kCNBenchmarkFrames);
+
+    free(changedTiles);
+    CNTileGridFree(&grid);
+    free(pixels);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+//
+//  CNBackstageTileDiffTests.c
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CNTestSupport.h"
+#include <string.h>
+#include "CNBackstageTileDiff.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// The known hashes pin the hash function, so the SSE2 and the scalar implementation are held to the same results on
+/// every platform. They only have to be updated on an intended change of the hash.
+
+static uint8_t *CNTestCreateNoise(int height, size_t bytesPerRow, uint32_t seed)
+{
+    uint8_t *pixels = malloc(bytesPerRow * (size_t)height);
+    for (size_t i = 0; pixels != NULL && i < bytesPerRow * (size_t)height; i++)
+        pixels[i] = (uint8_t)CNTestRandom(&seed);
+    return pixels;
+}
+
+static void CNTestFillSquare(uint8_t *pixels, size_t bytesPerRow, int x, int y, int size, uint32_t color)
+{
+    for (int row = y; row < y + size; row++) {
+        for (int column = x; column < x + size; column++)
+            memcpy(pixels + (size_t)row * bytesPerRow + (size_t)column * 4, &color, 4);
+    }
+}
+
+static void testKnownHashes(void)
+{
+    /// odd sizes and offsets cover the stripes and the pixel tail
+    uint8_t *pixels = CNTestCreateNoise(64, 256 * 4 + 12, 7);
+    CNAssert(CNTileHash(pixels, 256 * 4 + 12, 0, 0, 64, 64) == 0x5dcf3debd3c457b1ULL);
+    CNAssert(CNTileHash(pixels, 256 * 4 + 12, 3, 5, 61, 33) == 0xf194578d4091d861ULL);
+    CNAssert(CNTileHash(pixels, 256 * 4 + 12, 100, 1, 3, 7) == 0xcfba596922aab3ccULL);
+    CNAssert(CNTileHash(pixels, 256 * 4 + 12, 0, 0, 256, 1) == 0xcf307271e2e3490bULL);
+    free(pixels);
+}
+
+static void testMovedContentChangesHash(void)
+{
+    /// a 4x4 square on a flat background moved by a full stripe used to keep the hash of its tile
+    size_t bytesPerRow = 64 * 4;
+    uint8_t *first = calloc(64, bytesPerRow);
+    uint8_t *second = calloc(64, bytesPerRow);
+    CNTestFillSquare(first, bytesPerRow, 0, 8, 4, 0xFF2040E0u);
+    CNTestFillSquare(second, bytesPerRow, 16, 8, 4, 0xFF2040E0u);
+    CNAssert(CNTileHash(first, bytesPerRow, 0, 0, 64, 64) != CNTileHash(second, bytesPerRow, 0, 0, 64, 64));
+
+    for (int offset = 1; offset <= 60; offset++) {
+        memset(second, 0, 64 * bytesPerRow);
+        CNTestFillSquare(second, bytesPerRow, offset, 8, 4, 0xFF2040E0u);
+        CNAssert(CNTileHash(first, bytesPerRow, 0, 0, 64, 64) != CNTileHash(second, bytesPerRow, 0, 0, 64, 64));
+    }
+    free(first);
+    free(second);
+}
+
+static void testSwappedStripesChangeHash(void)
+{
+    /// the same two stripes in the other order
+    size_t bytesPerRow = 32 * 4;
+    uint8_t *first = calloc(1, bytesPerRow);
+    uint8_t *second = calloc(1, bytesPerRow);
+    memset(first, 0x11, 16);
+    memset(first + 16, 0x22, 16);
+    memset(second, 0x22, 16);
+    memset(second + 16, 0x11, 16);
+    CNAssert(CNTileHash(first, bytesPerRow, 0, 0, 32, 1) != CNTileHash(second, bytesPerRow, 0, 0, 32, 1));
+    free(first);
+    free(second);
+}
+
+static void testNoCollisionsOfSinglePixelChanges(void)
+{
+    /// every single bit flip of a 16x16 tile gets a hash of its own
+    enum { size = 16, bitCount = size * size * 32 };
+    size_t bytesPerRow = size * 4;
+    uint8_t *pixels = CNTestCreateNoise(size, bytesPerRow, 99);
+    uint64_t *hashes = malloc(sizeof(uint64_t) * (bitCount + 1));
+    hashes[bitCount] = CNTileHash(pixels, bytesPerRow, 0, 0, size, size);
+    for (int bit = 0; bit < bitCount; bit++) {
+        pixels[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        hashes[bit] = CNTileHash(pixels, bytesPerRow, 0, 0, size, size);
+        pixels[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+    }
+
+    int collisions = 0;
+    for (int i = 0; i <= bitCount; i++) {
+        for (int j = i + 1; j <= bitCount; j++)
+            collisions += (hashes[i] == hashes[j]);
+    }
+    CNAssert(collisions == 0);
+    free(hashes);
+    free(pixels);
+}
+
+static void testGridReportsChangedTiles(void)
+{
+    int width = 300, height = 200;
+    size_t bytesPerRow = (size_t)width * 4 + 16;
+    uint8_t *pixels = CNTestCreateNoise(height, bytesPerRow, 1);
+    int changedTiles[5 * 4];
+
+    CNTileGrid grid;
+    CNAssert(CNTileGridInit(&grid, width, height, 64));
+    CNAssert(CNTileGridTileCount(&grid) == 5 * 4);
+    CNAssert(CNTileGridUpdate(&grid, pixels, bytesPerRow, changedTiles) == 20);
+    CNAssert(CNTileGridUpdate(&grid, pixels, bytesPerRow, changedTiles) == 0);
+
+    pixels[bytesPerRow * 70 + 4 * 130 + 2] ^= 1;
+    CNAssert(CNTileGridUpdate(&grid, pixels, bytesPerRow, changedTiles) == 1);
+    CNAssert(changedTiles[0] == 1 * 5 + 2);
+
+    /// the last tile is smaller than the others
+    pixels[bytesPerRow * (height - 1) + 4 * (width - 1)] ^= 0x80;
+    CNAssert(CNTileGridUpdate(&grid, pixels, bytesPerRow, changedTiles) == 1);
+    CNAssert(changedTiles[0] == 19);
+    int x, y, tileWidth, tileHeight;
+    CNTileGridTileRect(&grid, 19, &x, &y, &tileWidth, &tileHeight);
+    CNAssert(x == 256 && y == 192 && tileWidth == 44 && tileHeight == 8);
+
+    CNTileGridInvalidate(&grid);
+    CNAssert(CNTileGridUpdate(&grid, pixels, bytesPerRow, changedTiles) == 20);
+
+    CNTileGridFree(&grid);
+    free(pixels);
+}
+
+int main(void)
+{
+    CNTestRun(testKnownHashes);
+    CNTestRun(testMovedContentChangesHash);
+    CNTestRun(testSwappedStripesChangeHash);
+    CNTestRun(testNoCollisionsOfSinglePixelChanges);
+    CNTestRun(testGridReportsChangedTiles);
+    return CNTestResult();
+}
@@ -0,0 +1,198 @@
+//
+//  CNTestImage.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef CNTestImage_h
+#define CNTestImage_h
+
+#include <stdbool.h>
+#include <string.h>
+#include <zlib.h>
+#include "CNTestSupport.h"
+#include "CNBackstageCompositor.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A strict PNG reader for the golden images and the encoder tests. It only reads what `CNBackstageImageEncoder` writes:
+/// 8 bit RGB or RGBA, not interlaced, but it verifies every chunk CRC and supports all five row filters. RGB is expanded
+/// to opaque RGBA, the alpha is stored as read (straight).
+
+static inline uint32_t CNTestReadBigEndian(const uint8_t *bytes)
+{
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+}
+
+static inline int CNTestPaeth(int left, int up, int upLeft)
+{
+    int estimate = left + up - upLeft;
+    int distanceLeft = abs(estimate - left), distanceUp = abs(estimate - up), distanceUpLeft = abs(estimate - upLeft);
+    if (distanceLeft <= distanceUp && distanceLeft <= distanceUpLeft)
+        return left;
+    return (distanceUp <= distanceUpLeft ? up : upLeft);
+}
+
+/// Decodes a PNG into a new buffer, release it with `CNPixelBufferFree`.
+static inline bool CNTestDecodePNG(const uint8_t *data, size_t length, CNPixelBuffer *buffer)
+{
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    if (length < 8 || memcmp(data, signature, 8) != 0)
+        return false;
+
+    int width = 0, height = 0, bytesPerPixel = 0;
+    bool hasEnd = false;
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    uint8_t *filtered = NULL;
+    size_t filteredLength = 0;
+
+    size_t offset = 8;
+    while (!hasEnd && offset + 12 <= length) {
+        uint32_t chunkLength = CNTestReadBigEndian(data + offset);
+        const uint8_t *type = data + offset + 4;
+        const uint8_t *chunk = data + offset + 8;
+        if (chunkLength > length - offset - 12)
+            break;
+        if (crc32(crc32(0, NULL, 0), type, chunkLength + 4) != CNTestReadBigEndian(chunk + chunkLength))
+            break;
+
+        if (memcmp(type, "IHDR", 4) == 0 && chunkLength == 13) {
+            width = (int)CNTestReadBigEndian(chunk);
+            height = (int)CNTestReadBigEndian(chunk + 4);
+            bytesPerPixel = (chunk[9] == 6 ? 4 : (chunk[9] == 2 ? 3 : 0));
+            if (chunk[8] != 8 || bytesPerPixel == 0 || chunk[12] != 0 || width <= 0 || height <= 0)
+                break;
+            filteredLength = (size_t)height * ((size_t)width * bytesPerPixel + 1);
+            filtered = malloc(filteredLength);
+            if (filtered == NULL || inflateInit(&stream) != Z_OK)
+                break;
+            stream.next_out = filtered;
+            stream.avail_out = (uInt)filteredLength;
+        }
+        else if (memcmp(type, "IDAT", 4) == 0 && filtered != NULL) {
+            stream.next_in = (Bytef *)chunk;
+            stream.avail_in = chunkLength;
+            int status = inflate(&stream, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END)
+                break;
+        }
+        else if (memcmp(type, "IEND", 4) == 0) {
+            hasEnd = true;
+        }
+        offset += chunkLength + 12;
+    }
+
+    bool isAllocated = (hasEnd && filtered != NULL && stream.total_out == filteredLength && CNPixelBufferAlloc(buffer, width, height));
+    bool success = isAllocated;
+    if (filtered != NULL)
+        inflateEnd(&stream);
+
+    size_t rowLength = (size_t)width * bytesPerPixel;
+    for (int y = 0; success && y < height; y++) {
+        uint8_t *row = filtered + (size_t)y * (rowLength + 1);
+        const uint8_t *previousRow = (y > 0 ? row - rowLength : NULL);
+        uint8_t filter = *row++;
+        for (size_t i = 0; i < rowLength; i++) {
+            int left = (i >= (size_t)bytesPerPixel ? row[i - bytesPerPixel] : 0);
+            int up = (previousRow != NULL ? previousRow[i] : 0);
+            int upLeft = (previousRow != NULL && i >= (size_t)bytesPerPixel ? previousRow[i - bytesPerPixel] : 0);
+            switch (filter) {
+                case 0:                                                     break;
+                case 1: row[i] = (uint8_t)(row[i] + left);                  break;
+                case 2: row[i] = (uint8_t)(row[i] + up);                    break;
+                case 3: row[i] = (uint8_t)(row[i] + (left + up) / 2);       break;
+                case 4: row[i] = (uint8_t)(row[i] + CNTestPaeth(left, up, upLeft)); break;
+                default: success = false;                                   break;
+            }
+        }
+        uint8_t *pixel = buffer->data + (size_t)y * buffer->bytesPerRow;
+        for (int x = 0; success && x < width; x++, pixel += 4) {
+            const uint8_t *source = row + (size_t)x * bytesPerPixel;
+            pixel[0] = source[0];
+            pixel[1] = source[1];
+            pixel[2] = source[2];
+            pixel[3] = (bytesPerPixel == 4 ? source[3] : 255);
+        }
+    }
+    if (!success && isAllocated)
+        CNPixelBufferFree(buffer);
+
+    free(filtered);
+    return success;
+}
+
+static inline bool CNTestReadPNG(const char *path, CNPixelBuffer *buffer)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+        return false;
+
+    uint8_t *data = NULL;
+    size_t length = 0, capacity = 0, count;
+    do {
+        if (length == capacity) {
+            capacity = (capacity == 0 ? 65536 : capacity * 2);
+            uint8_t *grown = realloc(data, capacity);
+            if (grown == NULL)
+                break;
+            data = grown;
+        }
+        count = fread(data + length, 1, capacity - length, file);
+        length += count;
+    } while (count > 0);
+    fclose(file);
+
+    bool success = (data != NULL && CNTestDecodePNG(data, length, buffer));
+    free(data);
+    return success;
+}
+
+/// Returns the number of pixels that differ by more than `tolerance` in any channel, or -1 if the sizes differ.
+static inline long CNTestCompareImages(const CNPixelBuffer *image, const CNPixelBuffer *reference, int tolerance)
+{
+    if (image->width != reference->width || image->height != reference->height)
+        return -1;
+
+    long differences = 0;
+    for (int y = 0; y < image->height; y++) {
+        const uint8_t *pixel = image->data + (size_t)y * image->bytesPerRow;
+        const uint8_t *referencePixel = reference->data + (size_t)y * reference->bytesPerRow;
+        for (int x = 0; x < image->width * 4; x += 4) {
+            for (int channel = 0; channel < 4; channel++) {
+                if (abs(pixel[x + channel] - referencePixel[x + channel]) > tolerance) {
+                    differences++;
+                    break;
+                }
+            }
+        }
+    }
+    return differences;
+}
+
+#endif
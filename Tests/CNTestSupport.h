@@ -0,0 +1,96 @@
+//
+//  CNTestSupport.h
+//
+//  Created by cocoa:naut on 19.10.26.
+//  Copyright (c) 2012 cocoa:naut. All rights reserved.
+//
+
+/*
+ The MIT License (MIT)
+ Copyright © 2012 Frank Gregor, <phranck@cocoanaut.com>
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the “Software”), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+
+#ifndef CNTestSupport_h
+#define CNTestSupport_h
+
+/// clock_gettime, fork and friends aren't declared in strict C99 mode otherwise, include this header first
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// A minimal test support. Every test file is one executable with a `main` that runs its test functions with `CNTestRun`
+/// and returns `CNTestResult()`. A failed assertion is reported and the test function goes on.
+
+#if defined(__GNUC__)
+#define CN_TEST_UNUSED  __attribute__((unused))
+#else
+#define CN_TEST_UNUSED
+#endif
+
+/// benchmarks include this header as well but don't assert
+static int CNTestFailures CN_TEST_UNUSED = 0;
+
+#define CNAssert(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+            CNTestFailures++; \
+        } \
+    } while (0)
+
+#define CNAssertEqualsWithAccuracy(value, expected, accuracy)   CNAssert(fabs((double)(value) - (double)(expected)) <= (accuracy))
+
+#define CNTestRun(testFunction) \
+    do { \
+        int failures = CNTestFailures; \
+        testFunction(); \
+        printf("%s %s\n", (CNTestFailures == failures ? "passed" : "FAILED"), #testFunction); \
+    } while (0)
+
+#define CNTestResult()  (CNTestFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE)
+
+/// Seconds of a monotonic clock, for benchmarks.
+static inline double CNTestNow(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+/// A deterministic pseudo random generator, so fixtures are the same on every run and platform.
+static inline uint32_t CNTestRandom(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+#endif